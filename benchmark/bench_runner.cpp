@@ -0,0 +1,325 @@
+#include "bench_runner.h"
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+
+BenchRunner::BenchRunner(const BenchConfig& config)
+    : config_(config) {
+    if (config_.bin_dir.empty()) {
+        // 默认在自身所在目录查找main_server和main_pressure
+        char path[4096];
+        ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+        if (len > 0) {
+            path[len] = '\0';
+            std::string exe(path);
+            config_.bin_dir = exe.substr(0, exe.find_last_of('/'));
+        } else {
+            config_.bin_dir = ".";
+        }
+    }
+}
+
+int BenchRunner::run() {
+    // 清空上一次的日志
+    std::ofstream(config_.output_prefix + ".log", std::ios::trunc);
+
+    size_t total = config_.message_sizes.size() * config_.connections.size() *
+                   config_.depths.size() * config_.workers.size();
+    size_t index = 0;
+    bool all_ok = true;
+
+    for (int workers : config_.workers) {
+        for (int size : config_.message_sizes) {
+            for (int conns : config_.connections) {
+                for (int depth : config_.depths) {
+                    BenchResult result;
+                    result.message_size = size;
+                    result.connections = conns;
+                    result.depth = depth;
+                    result.workers = workers;
+
+                    std::cout << "[" << ++index << "/" << total << "] size=" << size
+                              << " conns=" << conns << " depth=" << depth
+                              << " workers=" << workers << " ... " << std::flush;
+                    result.ok = runPoint(result);
+                    if (result.ok) {
+                        std::cout << std::fixed << std::setprecision(1)
+                                  << result.messages_per_sec << " msg/s, p99 "
+                                  << result.p99_us << " us" << std::endl;
+                    } else {
+                        std::cout << "FAILED" << std::endl;
+                        all_ok = false;
+                    }
+                    results_.push_back(result);
+                }
+            }
+        }
+    }
+
+    writeCsv(config_.output_prefix + ".csv");
+    writeJson(config_.output_prefix + ".json");
+    std::cout << "Results written to " << config_.output_prefix << ".csv and "
+              << config_.output_prefix << ".json" << std::endl;
+
+    if (!config_.baseline.empty() && compareBaseline() > 0) {
+        return 1;
+    }
+    return all_ok ? 0 : 2;
+}
+
+bool BenchRunner::runPoint(BenchResult& result) {
+    std::string port = std::to_string(config_.port);
+    pid_t server = spawn({config_.bin_dir + "/main_server", "-p", port,
+                          "-w", std::to_string(result.workers), "-t", "100"});
+    if (server <= 0) {
+        return false;
+    }
+    if (!waitForServer(5000)) {
+        std::cerr << "Server did not start listening on port " << port << std::endl;
+        stopServer(server);
+        return false;
+    }
+
+    // 每条连接的消息数设得足够大，测试时长内连接保持不变
+    std::string json_path = config_.output_prefix + ".point.json";
+    unlink(json_path.c_str());
+    pid_t client = spawn({config_.bin_dir + "/main_pressure", "-h", "127.0.0.1", "-p", port,
+                          "-c", std::to_string(result.connections),
+                          "-s", std::to_string(result.message_size),
+                          "-m", "1000000000",
+                          "-t", std::to_string(config_.duration),
+                          "-T", std::to_string(config_.client_threads),
+                          "--depth", std::to_string(result.depth),
+                          "--json", json_path});
+    int status = 0;
+    bool ok = client > 0 && waitpid(client, &status, 0) == client &&
+              WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    stopServer(server);
+
+    ok = ok && parseResult(json_path, result);
+    unlink(json_path.c_str());
+    return ok;
+}
+
+pid_t BenchRunner::spawn(const std::vector<std::string>& args) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Fork failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    if (pid == 0) {
+        // 子进程输出追加到日志，保持驱动程序的输出简洁
+        std::string log = config_.output_prefix + ".log";
+        int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        std::vector<char*> argv;
+        for (const auto& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        std::cerr << "Exec " << args[0] << " failed: " << strerror(errno) << std::endl;
+        _exit(127);
+    }
+    return pid;
+}
+
+bool BenchRunner::waitForServer(int timeout_ms) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config_.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1) {
+            return false;
+        }
+        int ret = connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+        close(fd);
+        if (ret == 0) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+}
+
+void BenchRunner::stopServer(pid_t pid) {
+    kill(pid, SIGINT);
+    // 最多等待5秒，超时强制结束
+    for (int i = 0; i < 500; ++i) {
+        int status;
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+// 从main_pressure输出的扁平JSON中读取一个数值字段
+static bool readNumber(const std::string& json, const std::string& key, double& value) {
+    std::string pattern = "\"" + key + "\":";
+    size_t pos = json.find(pattern);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    value = std::strtod(json.c_str() + pos + pattern.size(), nullptr);
+    return true;
+}
+
+bool BenchRunner::parseResult(const std::string& path, BenchResult& result) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string json = buffer.str();
+
+    double failed = 0, timeouts = 0, mismatches = 0;
+    bool ok = readNumber(json, "messages_per_sec", result.messages_per_sec) &&
+              readNumber(json, "throughput_kbps", result.throughput_kbps) &&
+              readNumber(json, "latency_p50_us", result.p50_us) &&
+              readNumber(json, "latency_p99_us", result.p99_us) &&
+              readNumber(json, "latency_p999_us", result.p999_us) &&
+              readNumber(json, "latency_max_us", result.max_us) &&
+              readNumber(json, "failed_connections", failed) &&
+              readNumber(json, "timeouts", timeouts) &&
+              readNumber(json, "echo_mismatches", mismatches);
+    result.failed_connections = static_cast<long>(failed);
+    result.timeouts = static_cast<long>(timeouts);
+    result.echo_mismatches = static_cast<long>(mismatches);
+    return ok;
+}
+
+void BenchRunner::writeCsv(const std::string& path) const {
+    std::ofstream out(path);
+    out << "message_size,connections,depth,workers,ok,messages_per_sec,throughput_kbps,"
+        << "p50_us,p99_us,p999_us,max_us,failed_connections,timeouts,echo_mismatches\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& r : results_) {
+        out << r.message_size << "," << r.connections << "," << r.depth << "," << r.workers << ","
+            << (r.ok ? 1 : 0) << "," << r.messages_per_sec << "," << r.throughput_kbps << ","
+            << r.p50_us << "," << r.p99_us << "," << r.p999_us << "," << r.max_us << ","
+            << r.failed_connections << "," << r.timeouts << "," << r.echo_mismatches << "\n";
+    }
+}
+
+void BenchRunner::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    out << std::fixed << std::setprecision(3);
+    out << "[\n";
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const BenchResult& r = results_[i];
+        out << "  {\"message_size\": " << r.message_size
+            << ", \"connections\": " << r.connections
+            << ", \"depth\": " << r.depth
+            << ", \"workers\": " << r.workers
+            << ", \"ok\": " << (r.ok ? "true" : "false")
+            << ", \"messages_per_sec\": " << r.messages_per_sec
+            << ", \"throughput_kbps\": " << r.throughput_kbps
+            << ", \"latency_p50_us\": " << r.p50_us
+            << ", \"latency_p99_us\": " << r.p99_us
+            << ", \"latency_p999_us\": " << r.p999_us
+            << ", \"latency_max_us\": " << r.max_us
+            << ", \"failed_connections\": " << r.failed_connections
+            << ", \"timeouts\": " << r.timeouts
+            << ", \"echo_mismatches\": " << r.echo_mismatches << "}"
+            << (i + 1 < results_.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+bool BenchRunner::loadBaseline(std::vector<BenchResult>& baseline) const {
+    std::ifstream in(config_.baseline);
+    if (!in) {
+        std::cerr << "Open baseline failed: " << config_.baseline << std::endl;
+        return false;
+    }
+    std::string line;
+    std::getline(in, line); // 跳过表头
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 9) {
+            continue;
+        }
+        BenchResult r;
+        r.message_size = std::atoi(fields[0].c_str());
+        r.connections = std::atoi(fields[1].c_str());
+        r.depth = std::atoi(fields[2].c_str());
+        r.workers = std::atoi(fields[3].c_str());
+        r.ok = fields[4] == "1";
+        r.messages_per_sec = std::atof(fields[5].c_str());
+        r.p99_us = std::atof(fields[8].c_str());
+        baseline.push_back(r);
+    }
+    return true;
+}
+
+int BenchRunner::compareBaseline() const {
+    std::vector<BenchResult> baseline;
+    if (!loadBaseline(baseline)) {
+        return 1;
+    }
+
+    std::cout << "\n=== Baseline Comparison (threshold " << config_.threshold << "%) ===" << std::endl;
+    int regressions = 0;
+    double limit = config_.threshold / 100.0;
+    for (const auto& current : results_) {
+        for (const auto& base : baseline) {
+            if (base.message_size != current.message_size || base.connections != current.connections ||
+                base.depth != current.depth || base.workers != current.workers || !base.ok) {
+                continue;
+            }
+
+            // 吞吐下降或p99上升超过阈值即视为回归
+            double tput_change = base.messages_per_sec > 0 ?
+                (current.messages_per_sec - base.messages_per_sec) / base.messages_per_sec : 0;
+            double p99_change = base.p99_us > 0 ? (current.p99_us - base.p99_us) / base.p99_us : 0;
+            bool regressed = !current.ok || tput_change < -limit || p99_change > limit;
+
+            std::cout << (regressed ? "REGRESSION " : "ok         ")
+                      << "size=" << current.message_size << " conns=" << current.connections
+                      << " depth=" << current.depth << " workers=" << current.workers
+                      << std::showpos << std::fixed << std::setprecision(1)
+                      << "  throughput " << tput_change * 100 << "%"
+                      << "  p99 " << p99_change * 100 << "%" << std::noshowpos << std::endl;
+            if (regressed) {
+                regressions++;
+            }
+            break;
+        }
+    }
+    std::cout << regressions << " regression(s) found" << std::endl;
+    return regressions;
+}
@@ -0,0 +1,65 @@
+#ifndef BENCH_RUNNER_H
+#define BENCH_RUNNER_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// 基准矩阵配置：对每个参数组合启动一次本地服务器并运行main_pressure
+struct BenchConfig {
+    std::vector<int> message_sizes = {64, 1024, 16384};  // 消息大小
+    std::vector<int> connections = {100, 1000};          // 并发连接数
+    std::vector<int> depths = {1, 8};                    // 流水线深度
+    std::vector<int> workers = {1};                      // 服务器事件循环数
+    int client_threads = 1;                              // main_pressure线程数
+    int duration = 5;                                    // 每个组合的测试时间(秒)
+    int port = 18080;                                    // 本地服务器端口
+    std::string bin_dir;                                 // main_server/main_pressure所在目录
+    std::string output_prefix = "bench_results";        // 输出 PREFIX.json/PREFIX.csv/PREFIX.log
+    std::string baseline;                                // 基线CSV，为空则不比较
+    double threshold = 10.0;                             // 回归阈值(百分比)
+};
+
+// 单个组合的结果
+struct BenchResult {
+    int message_size = 0;
+    int connections = 0;
+    int depth = 0;
+    int workers = 0;
+    bool ok = false;                 // 是否成功运行
+    double messages_per_sec = 0;
+    double throughput_kbps = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double p999_us = 0;
+    double max_us = 0;
+    long failed_connections = 0;
+    long timeouts = 0;
+    long echo_mismatches = 0;
+};
+
+class BenchRunner {
+public:
+    BenchRunner(const BenchConfig& config);
+
+    // 运行整个矩阵，返回进程退出码: 0正常，1存在性能回归，2运行失败
+    int run();
+
+private:
+    bool runPoint(BenchResult& result);                          // 运行一个组合
+    pid_t spawn(const std::vector<std::string>& args);           // 启动子进程，输出写入日志
+    bool waitForServer(int timeout_ms);                          // 等待服务器开始监听
+    void stopServer(pid_t pid);                                  // SIGINT停止服务器并回收
+    bool parseResult(const std::string& path, BenchResult& result);
+
+    void writeCsv(const std::string& path) const;
+    void writeJson(const std::string& path) const;
+    bool loadBaseline(std::vector<BenchResult>& baseline) const;
+    int compareBaseline() const;                                 // 返回回归的组合数
+
+private:
+    BenchConfig config_;
+    std::vector<BenchResult> results_;
+};
+
+#endif // BENCH_RUNNER_H
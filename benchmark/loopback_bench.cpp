@@ -0,0 +1,361 @@
+// 进程内回环基准: EpollServer事件循环与负载生成器运行在同一进程的两个绑核线程中，
+// 通过socketpair相连，按固定消息数闭环收发。不经过TCP协议栈和跨进程调度，
+// 结果主要反映服务器的解析与分发代码，适合发现小幅性能回退。
+#include "../include/server.h"
+#include "../include/frame.h"
+#include "../include/latency_histogram.h"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LoopbackConfig {
+    int connections = 16;           // socketpair数量
+    int messages = 20000;           // 每个连接发送的消息数
+    int message_size = 64;          // 消息大小(字节)
+    int depth = 1;                  // 每个连接的在途消息数
+    int repetitions = 5;            // 重复运行次数
+    int server_cpu = 0;             // 服务器线程绑定的CPU，-1不绑定
+    int client_cpu = 1;             // 负载线程绑定的CPU，-1不绑定
+};
+
+struct LoopbackResult {
+    double seconds = 0;
+    long messages = 0;
+    long errors = 0;
+    LatencyHistogram latency;
+};
+
+// 将当前线程绑定到指定CPU
+static bool pinThread(int cpu) {
+    if (cpu < 0) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) {
+        std::cerr << "Pin thread to CPU " << cpu << " failed: " << strerror(ret) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 负载生成器中每个连接的状态
+struct LoopbackConnection {
+    int fd = -1;
+    int sent = 0;                       // 已完整发出的消息数
+    int received = 0;                   // 已收到回射的消息数
+    size_t send_offset = 0;             // 当前消息已发送的字节数
+    std::vector<char> receive_buffer;
+    size_t receive_length = 0;
+    std::vector<std::chrono::steady_clock::time_point> send_times;  // 在途消息的发送时间，按消息序号取模
+};
+
+class LoopbackGenerator {
+public:
+    LoopbackGenerator(const LoopbackConfig& config, const std::vector<int>& fds)
+        : config_(config), epoll_fd_(-1) {
+        std::mt19937 rng(42);   // 固定种子，每次运行发送相同的数据
+        buildFrame(generatePayload(rng, config_.message_size), frame_);
+        for (int fd : fds) {
+            LoopbackConnection conn;
+            conn.fd = fd;
+            conn.receive_buffer.resize(frame_.size() * config_.depth + 4096);
+            conn.send_times.resize(config_.depth);
+            connections_.push_back(conn);
+        }
+    }
+
+    ~LoopbackGenerator() {
+        if (epoll_fd_ != -1) {
+            close(epoll_fd_);
+        }
+    }
+
+    bool run(LoopbackResult& result) {
+        epoll_fd_ = epoll_create1(0);
+        if (epoll_fd_ == -1) {
+            std::cerr << "Create epoll failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < connections_.size(); ++i) {
+            int flags = fcntl(connections_[i].fd, F_GETFL, 0);
+            fcntl(connections_[i].fd, F_SETFL, flags | O_NONBLOCK);
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+            ev.data.u32 = static_cast<uint32_t>(i);
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, connections_[i].fd, &ev) == -1) {
+                std::cerr << "Add epoll event failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        size_t finished = 0;
+        for (auto& conn : connections_) {
+            if (!fill(conn, result)) {
+                return false;
+            }
+        }
+
+        std::vector<struct epoll_event> events(connections_.size());
+        while (finished < connections_.size()) {
+            int num_events = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), 1000);
+            if (num_events == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "Epoll wait failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            if (num_events == 0) {
+                std::cerr << "Loopback run stalled" << std::endl;
+                return false;
+            }
+            for (int i = 0; i < num_events; ++i) {
+                LoopbackConnection& conn = connections_[events[i].data.u32];
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    std::cerr << "Server closed connection " << conn.fd << std::endl;
+                    return false;
+                }
+                bool was_done = conn.received == config_.messages;
+                if (!receive(conn, result) || !fill(conn, result)) {
+                    return false;
+                }
+                if (!was_done && conn.received == config_.messages) {
+                    finished++;
+                }
+            }
+        }
+
+        result.seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count() / 1e9;
+        return true;
+    }
+
+private:
+    // 补足在途窗口并尽量发出
+    bool fill(LoopbackConnection& conn, LoopbackResult& result) {
+        while (conn.sent < config_.messages && conn.sent - conn.received < config_.depth) {
+            if (conn.send_offset == 0) {
+                conn.send_times[conn.sent % config_.depth] = std::chrono::steady_clock::now();
+            }
+            ssize_t ret = send(conn.fd, frame_.data() + conn.send_offset,
+                               frame_.size() - conn.send_offset, MSG_NOSIGNAL);
+            if (ret < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                std::cerr << "Send failed: " << strerror(errno) << std::endl;
+                result.errors++;
+                return false;
+            }
+            conn.send_offset += ret;
+            if (conn.send_offset == frame_.size()) {
+                conn.send_offset = 0;
+                conn.sent++;
+            }
+        }
+        return true;
+    }
+
+    // 读取并校验所有已到达的回射
+    bool receive(LoopbackConnection& conn, LoopbackResult& result) {
+        while (true) {
+            ssize_t ret = recv(conn.fd, conn.receive_buffer.data() + conn.receive_length,
+                               conn.receive_buffer.size() - conn.receive_length, 0);
+            if (ret < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                std::cerr << "Receive failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            if (ret == 0) {
+                std::cerr << "Server closed connection " << conn.fd << std::endl;
+                return false;
+            }
+            conn.receive_length += ret;
+
+            auto now = std::chrono::steady_clock::now();
+            size_t offset = 0;
+            while (conn.receive_length - offset >= frame_.size()) {
+                if (memcmp(conn.receive_buffer.data() + offset, frame_.data(), frame_.size()) != 0) {
+                    result.errors++;
+                }
+                result.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - conn.send_times[conn.received % config_.depth]).count());
+                result.messages++;
+                conn.received++;
+                offset += frame_.size();
+            }
+            memmove(conn.receive_buffer.data(), conn.receive_buffer.data() + offset,
+                    conn.receive_length - offset);
+            conn.receive_length -= offset;
+        }
+    }
+
+private:
+    LoopbackConfig config_;
+    int epoll_fd_;
+    std::vector<char> frame_;                       // 所有消息相同，长度字段 + 数据
+    std::vector<LoopbackConnection> connections_;
+};
+
+// 运行一次: 新建socketpair和服务器实例，结束后全部释放
+static bool runOnce(const LoopbackConfig& config, LoopbackResult& result) {
+    ServerConfig server_config;
+    server_config.listen = false;
+    server_config.max_events = std::max(config.connections, 64);
+    server_config.timeout_ms = 100;
+    EpollServer server(server_config);
+    if (!server.initialize()) {
+        return false;
+    }
+
+    std::vector<int> client_fds;
+    for (int i = 0; i < config.connections; ++i) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+            std::cerr << "Create socketpair failed: " << strerror(errno) << std::endl;
+            for (int fd : client_fds) {
+                close(fd);
+            }
+            return false;
+        }
+        server.adoptConnection(fds[0]);
+        client_fds.push_back(fds[1]);
+    }
+
+    std::thread server_thread([&]() {
+        pinThread(config.server_cpu);
+        server.run();
+    });
+
+    bool ok = false;
+    std::thread client_thread([&]() {
+        pinThread(config.client_cpu);
+        LoopbackGenerator generator(config, client_fds);
+        ok = generator.run(result);
+    });
+    client_thread.join();
+
+    for (int fd : client_fds) {
+        close(fd);
+    }
+    server.stop();
+    server_thread.join();
+    return ok && result.errors == 0;
+}
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Runs an EpollServer loop and a load generator in one process over socketpairs." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -c CONNECTIONS Socket pairs (default: 16)" << std::endl;
+    std::cout << "  -m MESSAGES    Messages per connection (default: 20000)" << std::endl;
+    std::cout << "  -s SIZE        Message size in bytes (default: 64)" << std::endl;
+    std::cout << "  -d DEPTH       Messages in flight per connection (default: 1)" << std::endl;
+    std::cout << "  -r REPS        Repetitions (default: 5)" << std::endl;
+    std::cout << "  --server-cpu N CPU for the server thread, -1 to not pin (default: 0)" << std::endl;
+    std::cout << "  --client-cpu N CPU for the load thread, -1 to not pin (default: 1)" << std::endl;
+    std::cout << "  --help         Show this help message" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    LoopbackConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-c" && i + 1 < argc) {
+            config.connections = std::atoi(argv[++i]);
+        } else if (arg == "-m" && i + 1 < argc) {
+            config.messages = std::atoi(argv[++i]);
+        } else if (arg == "-s" && i + 1 < argc) {
+            config.message_size = std::atoi(argv[++i]);
+        } else if (arg == "-d" && i + 1 < argc) {
+            config.depth = std::atoi(argv[++i]);
+        } else if (arg == "-r" && i + 1 < argc) {
+            config.repetitions = std::atoi(argv[++i]);
+        } else if (arg == "--server-cpu" && i + 1 < argc) {
+            config.server_cpu = std::atoi(argv[++i]);
+        } else if (arg == "--client-cpu" && i + 1 < argc) {
+            config.client_cpu = std::atoi(argv[++i]);
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.connections < 1 || config.messages < 1 || config.message_size < 1 ||
+        config.depth < 1 || config.repetitions < 1) {
+        std::cerr << "Connections, messages, size, depth and repetitions must be positive" << std::endl;
+        return 1;
+    }
+
+    // 单核机器上无法分开绑核，此时不绑定
+    int cpus = static_cast<int>(std::thread::hardware_concurrency());
+    if (cpus > 0 && (config.server_cpu >= cpus || config.client_cpu >= cpus)) {
+        std::cerr << "Only " << cpus << " CPU(s) available, threads will not be pinned" << std::endl;
+        config.server_cpu = -1;
+        config.client_cpu = -1;
+    }
+
+    std::cout << "Loopback: " << config.connections << " socketpairs, " << config.messages
+              << " messages x " << config.message_size << " bytes, depth " << config.depth
+              << ", server cpu " << config.server_cpu << ", client cpu " << config.client_cpu << std::endl;
+
+    std::vector<double> rates;
+    LatencyHistogram total_latency;
+    std::cout << std::fixed << std::setprecision(2);
+    for (int rep = 0; rep < config.repetitions; ++rep) {
+        LoopbackResult result;
+        if (!runOnce(config, result)) {
+            std::cerr << "Repetition " << rep + 1 << " failed (" << result.errors << " errors)" << std::endl;
+            return 2;
+        }
+        double rate = result.messages / result.seconds;
+        rates.push_back(rate);
+        total_latency.merge(result.latency);
+        std::cout << "Run " << rep + 1 << ": " << rate << " msg/s, "
+                  << rate * config.message_size / (1024 * 1024) << " MB/s, latency(us) p50="
+                  << result.latency.percentile(50) / 1000.0
+                  << " p99=" << result.latency.percentile(99) / 1000.0
+                  << " p99.9=" << result.latency.percentile(99.9) / 1000.0
+                  << " max=" << result.latency.max() / 1000.0 << std::endl;
+    }
+
+    // 中位数作为结果，最大最小值的相对差反映噪声
+    std::sort(rates.begin(), rates.end());
+    double median = rates[rates.size() / 2];
+    if (rates.size() % 2 == 0) {
+        median = (rates[rates.size() / 2 - 1] + rates[rates.size() / 2]) / 2;
+    }
+    std::cout << "\n=== Loopback Results ===" << std::endl;
+    std::cout << "Median throughput: " << median << " msg/s" << std::endl;
+    std::cout << "Spread (max-min)/median: " << (rates.back() - rates.front()) / median * 100 << "%" << std::endl;
+    std::cout << "Latency (us): p50=" << total_latency.percentile(50) / 1000.0
+              << " p90=" << total_latency.percentile(90) / 1000.0
+              << " p99=" << total_latency.percentile(99) / 1000.0
+              << " p99.9=" << total_latency.percentile(99.9) / 1000.0
+              << " max=" << total_latency.max() / 1000.0 << std::endl;
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "bench_runner.h"
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Runs main_server + main_pressure for every combination and records the results." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --sizes LIST       Message sizes (default: 64,1024,16384)" << std::endl;
+    std::cout << "  --conns LIST       Connection counts (default: 100,1000)" << std::endl;
+    std::cout << "  --depths LIST      Pipelining depths (default: 1,8)" << std::endl;
+    std::cout << "  --workers LIST     Server worker counts (default: 1)" << std::endl;
+    std::cout << "  -T THREADS         main_pressure threads (default: 1)" << std::endl;
+    std::cout << "  -t SECONDS         Duration of each point (default: 5)" << std::endl;
+    std::cout << "  -p PORT            Local server port (default: 18080)" << std::endl;
+    std::cout << "  -o PREFIX          Output prefix for .csv/.json/.log (default: bench_results)" << std::endl;
+    std::cout << "  --bin-dir DIR      Directory of main_server/main_pressure (default: own directory)" << std::endl;
+    std::cout << "  --baseline FILE    Compare against a previous .csv and fail on regressions" << std::endl;
+    std::cout << "  --threshold PCT    Allowed throughput drop / p99 increase (default: 10)" << std::endl;
+    std::cout << "  --help             Show this help message" << std::endl;
+    std::cout << "Exit status: 0 ok, 1 regression against baseline, 2 a point failed to run" << std::endl;
+}
+
+// 解析逗号分隔的整数列表
+static std::vector<int> parseList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(std::atoi(item.c_str()));
+        }
+    }
+    return values;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            config.message_sizes = parseList(argv[++i]);
+        } else if (arg == "--conns" && i + 1 < argc) {
+            config.connections = parseList(argv[++i]);
+        } else if (arg == "--depths" && i + 1 < argc) {
+            config.depths = parseList(argv[++i]);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            config.workers = parseList(argv[++i]);
+        } else if (arg == "-T" && i + 1 < argc) {
+            config.client_threads = std::atoi(argv[++i]);
+        } else if (arg == "-t" && i + 1 < argc) {
+            config.duration = std::atoi(argv[++i]);
+        } else if (arg == "-p" && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            config.output_prefix = argv[++i];
+        } else if (arg == "--bin-dir" && i + 1 < argc) {
+            config.bin_dir = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            config.baseline = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            config.threshold = std::atof(argv[++i]);
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    BenchRunner runner(config);
+    return runner.run();
+}
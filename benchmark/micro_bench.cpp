@@ -0,0 +1,357 @@
+// 热点函数微基准: 不经过网络，单独测量报文编解码、缓冲区构建、载荷生成、回射校验和连接表操作
+// 每个用例先预热，再重复测量多轮，输出每次操作耗时的均值、中位数和95%置信区间
+#include "../include/frame.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+struct MicroBenchConfig {
+    int repetitions = 20;       // 测量轮数
+    int warmup_ms = 100;        // 预热时间
+    int min_time_ms = 20;       // 每轮最短测量时间，据此确定每轮迭代次数
+    std::string filter;         // 只运行名称包含该字符串的用例
+};
+
+// 阻止编译器把被测结果优化掉
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// 自由度df的t分布双侧95%分位数，df>30时近似为正态分布
+static double tQuantile95(int df) {
+    static const double table[] = {
+        0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df <= 0) {
+        return 0;
+    }
+    return df <= 30 ? table[df] : 1.96;
+}
+
+class MicroBench {
+public:
+    MicroBench(const MicroBenchConfig& config) : config_(config) {}
+
+    // body执行iterations次被测操作
+    void run(const std::string& name, const std::function<void(long iterations)>& body) {
+        if (!config_.filter.empty() && name.find(config_.filter) == std::string::npos) {
+            return;
+        }
+
+        // 预热并估算每轮迭代次数，使每轮耗时不少于min_time_ms
+        long iterations = 1;
+        auto warmup_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.warmup_ms);
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            body(iterations);
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            if (elapsed < config_.min_time_ms * 1000000L) {
+                iterations *= 2;
+            } else if (std::chrono::steady_clock::now() >= warmup_end) {
+                break;
+            }
+        }
+
+        std::vector<double> samples;
+        for (int i = 0; i < config_.repetitions; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            body(iterations);
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            samples.push_back(static_cast<double>(elapsed) / iterations);
+        }
+        report(name, samples);
+    }
+
+    static void printHeader() {
+        std::cout << std::left << std::setw(40) << "Benchmark"
+                  << std::right << std::setw(12) << "mean(ns)" << std::setw(12) << "median(ns)"
+                  << std::setw(12) << "min(ns)" << std::setw(12) << "+/-95%CI" << std::setw(10) << "CI%"
+                  << std::endl;
+    }
+
+private:
+    void report(const std::string& name, std::vector<double>& samples) {
+        size_t n = samples.size();
+        double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+        double variance = 0;
+        for (double sample : samples) {
+            variance += (sample - mean) * (sample - mean);
+        }
+        variance = n > 1 ? variance / (n - 1) : 0;
+        double ci = tQuantile95(static_cast<int>(n) - 1) * std::sqrt(variance / n);
+
+        std::sort(samples.begin(), samples.end());
+        double median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+
+        std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << mean << std::setw(12) << median << std::setw(12) << samples.front()
+                  << std::setw(12) << ci << std::setw(9) << (mean > 0 ? ci / mean * 100 : 0) << "%"
+                  << std::endl;
+    }
+
+private:
+    MicroBenchConfig config_;
+};
+
+// 报文长度字段编解码
+static void benchFrameHeader(MicroBench& bench) {
+    char header[kFrameHeaderSize];
+    bench.run("frame_header/encode", [&](long iterations) {
+        for (long i = 0; i < iterations; ++i) {
+            encodeFrameHeader(header, static_cast<uint32_t>(i));
+            doNotOptimize(header);
+        }
+    });
+    encodeFrameHeader(header, 1024);
+    bench.run("frame_header/decode", [&](long iterations) {
+        uint32_t sum = 0;
+        for (long i = 0; i < iterations; ++i) {
+            doNotOptimize(header);
+            sum += decodeFrameHeader(header);
+        }
+        doNotOptimize(sum);
+    });
+}
+
+// 发送报文的缓冲区构建
+// fresh: server.cpp/client.cpp的sendCompleteMessage，每次分配新缓冲区并拷贝数据
+// reused: 复用同一缓冲区，只拷贝数据
+// header_only: pressure_client.cpp，只写长度和序号，数据由writev直接引用载荷池
+static void benchBuildFrame(MicroBench& bench, const std::vector<int>& sizes) {
+    std::mt19937 rng(42);
+    for (int size : sizes) {
+        std::string payload = generatePayload(rng, size);
+        std::string suffix = "/" + std::to_string(size);
+
+        bench.run("build_frame/fresh" + suffix, [&](long iterations) {
+            for (long i = 0; i < iterations; ++i) {
+                std::vector<char> buffer;
+                buildFrame(payload, buffer);
+                doNotOptimize(buffer.data());
+            }
+        });
+
+        std::vector<char> reused;
+        bench.run("build_frame/reused" + suffix, [&](long iterations) {
+            for (long i = 0; i < iterations; ++i) {
+                buildFrame(payload, reused);
+                doNotOptimize(reused.data());
+            }
+        });
+
+        char header[kFrameHeaderSize + sizeof(uint64_t)];
+        bench.run("build_frame/header_only" + suffix, [&](long iterations) {
+            for (long i = 0; i < iterations; ++i) {
+                uint64_t seq = static_cast<uint64_t>(i);
+                encodeFrameHeader(header, static_cast<uint32_t>(sizeof(seq) + payload.size()));
+                memcpy(header + kFrameHeaderSize, &seq, sizeof(seq));
+                doNotOptimize(header);
+            }
+        });
+    }
+}
+
+// 随机载荷生成(PressureClient载荷池、StressClient::generateMessage)
+static void benchGeneratePayload(MicroBench& bench, const std::vector<int>& sizes) {
+    std::mt19937 rng32(42);
+    std::mt19937_64 rng64(42);
+    for (int size : sizes) {
+        std::string suffix = "/" + std::to_string(size);
+        bench.run("generate_payload/mt19937" + suffix, [&](long iterations) {
+            for (long i = 0; i < iterations; ++i) {
+                std::string payload = generatePayload(rng32, size);
+                doNotOptimize(payload.data());
+            }
+        });
+        bench.run("generate_payload/mt19937_64" + suffix, [&](long iterations) {
+            for (long i = 0; i < iterations; ++i) {
+                std::string payload = generatePayload(rng64, size);
+                doNotOptimize(payload.data());
+            }
+        });
+    }
+}
+
+// 回射校验: 序号 + 数据逐字节比较
+static void benchVerifyEcho(MicroBench& bench, const std::vector<int>& sizes) {
+    std::mt19937 rng(42);
+    for (int size : sizes) {
+        std::string body = generatePayload(rng, size);
+        std::vector<char> echo(sizeof(uint64_t) + body.size());
+        uint64_t seq = 7;
+        memcpy(echo.data(), &seq, sizeof(seq));
+        memcpy(echo.data() + sizeof(seq), body.data(), body.size());
+
+        bench.run("verify_echo/" + std::to_string(size), [&](long iterations) {
+            long matched = 0;
+            for (long i = 0; i < iterations; ++i) {
+                doNotOptimize(echo.data());
+                matched += verifyEchoPayload(echo.data(), echo.size(), seq, body);
+            }
+            doNotOptimize(matched);
+        });
+    }
+}
+
+// CRC32C校验和: 硬件指令与查表实现对比，以及带校验和的回射验证
+static void benchChecksum(MicroBench& bench, const std::vector<int>& sizes) {
+    std::mt19937 rng(42);
+    for (int size : sizes) {
+        std::string data = generatePayload(rng, size);
+        std::string suffix = "/" + std::to_string(size);
+
+        if (crc32cHardwareAvailable()) {
+            bench.run("crc32c/hardware" + suffix, [&](long iterations) {
+                uint32_t crc = 0;
+                for (long i = 0; i < iterations; ++i) {
+                    doNotOptimize(data.data());
+                    crc ^= crc32c(data.data(), data.size());
+                }
+                doNotOptimize(crc);
+            });
+        }
+        bench.run("crc32c/software" + suffix, [&](long iterations) {
+            uint32_t crc = 0;
+            for (long i = 0; i < iterations; ++i) {
+                doNotOptimize(data.data());
+                crc ^= crc32cSoftware(data.data(), data.size());
+            }
+            doNotOptimize(crc);
+        });
+
+        // 序号 + 数据 + 校验和
+        uint64_t seq = 7;
+        std::vector<char> echo(sizeof(seq) + data.size() + kChecksumSize);
+        memcpy(echo.data(), &seq, sizeof(seq));
+        memcpy(echo.data() + sizeof(seq), data.data(), data.size());
+        encodeChecksum(echo.data() + sizeof(seq) + data.size(),
+                       crc32c(echo.data(), sizeof(seq) + data.size()));
+        bench.run("verify_echo_crc" + suffix, [&](long iterations) {
+            long matched = 0;
+            for (long i = 0; i < iterations; ++i) {
+                doNotOptimize(echo.data());
+                matched += verifyEchoChecksum(echo.data(), echo.size(), seq, data.size());
+            }
+            doNotOptimize(matched);
+        });
+    }
+}
+
+// 连接表插入/删除: 内核总是分配最小的可用fd，这里模拟连接数稳定时的断开重连
+// set: EpollServer的client_buffers_
+// fd_table: PressureClient/ChurnClient的fd下标表 + 活跃列表交换删除
+static void benchConnectionTable(MicroBench& bench, const std::vector<int>& counts) {
+    for (int count : counts) {
+        std::mt19937 rng(42);
+        std::vector<int> victims(4096);
+        for (int& fd : victims) {
+            fd = std::uniform_int_distribution<>(0, count - 1)(rng);
+        }
+        std::string suffix = "/" + std::to_string(count);
+
+        std::set<int> table;
+        for (int fd = 0; fd < count; ++fd) {
+            table.insert(fd);
+        }
+        bench.run("conn_table/set_erase_insert" + suffix, [&](long iterations) {
+            for (long i = 0; i < iterations; ++i) {
+                int fd = victims[i & 4095];
+                table.erase(fd);
+                table.insert(fd);
+            }
+            doNotOptimize(table.size());
+        });
+
+        struct Slot {
+            int fd = -1;
+            size_t list_index = 0;
+        };
+        std::vector<Slot> slots(count);
+        std::vector<int> active;
+        for (int fd = 0; fd < count; ++fd) {
+            slots[fd].fd = fd;
+            slots[fd].list_index = active.size();
+            active.push_back(fd);
+        }
+        bench.run("conn_table/fd_table_erase_insert" + suffix, [&](long iterations) {
+            for (long i = 0; i < iterations; ++i) {
+                int fd = victims[i & 4095];
+                // 交换删除
+                Slot& slot = slots[fd];
+                int last_fd = active.back();
+                active[slot.list_index] = last_fd;
+                slots[last_fd].list_index = slot.list_index;
+                active.pop_back();
+                slot.fd = -1;
+                // 重新插入
+                slot.fd = fd;
+                slot.list_index = active.size();
+                active.push_back(fd);
+            }
+            doNotOptimize(active.data());
+        });
+    }
+}
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -r REPS        Measured repetitions per benchmark (default: 20)" << std::endl;
+    std::cout << "  -w MS          Warm-up time per benchmark (default: 100)" << std::endl;
+    std::cout << "  -m MS          Minimum time per repetition (default: 20)" << std::endl;
+    std::cout << "  -f TEXT        Only run benchmarks whose name contains TEXT" << std::endl;
+    std::cout << "  --help         Show this help message" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    MicroBenchConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) {
+            config.repetitions = std::atoi(argv[++i]);
+        } else if (arg == "-w" && i + 1 < argc) {
+            config.warmup_ms = std::atoi(argv[++i]);
+        } else if (arg == "-m" && i + 1 < argc) {
+            config.min_time_ms = std::atoi(argv[++i]);
+        } else if (arg == "-f" && i + 1 < argc) {
+            config.filter = argv[++i];
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.repetitions < 2) {
+        std::cerr << "At least 2 repetitions are needed for a confidence interval" << std::endl;
+        return 1;
+    }
+
+    std::vector<int> sizes = {64, 1024, 16384};
+    MicroBench bench(config);
+    MicroBench::printHeader();
+    benchFrameHeader(bench);
+    benchBuildFrame(bench, sizes);
+    benchGeneratePayload(bench, sizes);
+    benchVerifyEcho(bench, sizes);
+    benchChecksum(bench, sizes);
+    benchConnectionTable(bench, {1000, 10000});
+    return 0;
+}
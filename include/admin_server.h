@@ -0,0 +1,43 @@
+#ifndef ADMIN_SERVER_H
+#define ADMIN_SERVER_H
+
+#include "server.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 本地管理端口: 监听Unix域套接字，按行接收文本命令，在独立线程中执行，不进入事件循环
+//   stats                       各worker的循环与连接统计
+//   connections [N]             列出最多N个连接(默认100)及其TCP_INFO，由各事件循环分批抓取
+//   get                         当前可调参数
+//   set NAME VALUE              修改可调参数: max-connections, idle-timeout(ms),
+//                               budget-msgs, budget-bytes, log-level(error|warn|info|debug)
+// 例: echo stats | nc -U /tmp/echo_server.sock
+class AdminServer {
+public:
+    AdminServer(const std::string& path, const std::vector<EpollServer*>& servers, ServerTunables& tunables);
+    ~AdminServer();
+
+    bool start();   // 创建套接字并启动管理线程
+    void stop();
+
+private:
+    void run();
+    void serveClient(int fd);
+    std::string execute(const std::string& line);
+    std::string statsCommand();
+    std::string connectionsCommand(size_t limit);
+    std::string tunablesCommand();
+    std::string setCommand(const std::string& name, const std::string& value);
+
+private:
+    std::string path_;
+    std::vector<EpollServer*> servers_;
+    ServerTunables& tunables_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+#endif // ADMIN_SERVER_H
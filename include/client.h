@@ -19,6 +19,7 @@ private:
     bool connected;          // 是否处于连接状态
     struct sockaddr_in server_addr; // 服务器地址
     int timeout_seconds;
+    bool verbose;            // 是否打印每条请求和响应
 
 public:
     Client(const std::string &ip, int port);
@@ -28,6 +29,7 @@ public:
     int sendRequest(const std::string &request);  // 发送请求
     int receiveResponse();  // 处理接收
     bool isConnected() const; // 判断是否处于连接状态
+    void setVerbose(bool verbose); // 设置是否打印每条请求和响应
     
 private:
     bool setSocketTimeout(int timeout_seconds); // 设置socket超时
@@ -0,0 +1,18 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C(Castagnoli)校验
+// x86使用SSE4.2的crc32指令(运行时检测)，ARMv8在编译器开启CRC扩展时使用crc32c指令，
+// 其他平台使用查表法(slicing-by-8)。crc参数为上一段数据的结果，可分段连续计算。
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+// 查表实现，用于没有硬件指令的平台以及基准对比
+uint32_t crc32cSoftware(const void* data, size_t length, uint32_t crc = 0);
+
+// 当前是否使用硬件指令
+bool crc32cHardwareAvailable();
+
+#endif // CRC32C_H
@@ -0,0 +1,123 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "crc32c.h"
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 报文格式: 4字节长度字段(网络字节序) + 数据
+// 服务器、客户端和压测工具共用这里的编解码，micro_bench直接测量这些函数
+const size_t kFrameHeaderSize = sizeof(uint32_t);
+
+// 写入长度字段
+inline void encodeFrameHeader(char* out, uint32_t length) {
+    uint32_t net_length = htonl(length);
+    memcpy(out, &net_length, sizeof(net_length));
+}
+
+// 读取长度字段，返回主机字节序的数据长度
+inline uint32_t decodeFrameHeader(const char* in) {
+    uint32_t net_length;
+    memcpy(&net_length, in, sizeof(net_length));
+    return ntohl(net_length);
+}
+
+// 构建完整报文(长度字段 + 数据)，复用out已分配的内存
+inline void buildFrame(const std::string& payload, std::vector<char>& out) {
+    out.resize(kFrameHeaderSize + payload.size());
+    encodeFrameHeader(out.data(), static_cast<uint32_t>(payload.size()));
+    memcpy(out.data() + kFrameHeaderSize, payload.data(), payload.size());
+}
+
+// 压测载荷: 8字节序号 + 数据，回射时按序号和数据逐字节校验
+inline bool verifyEchoPayload(const char* payload, size_t length, uint64_t expected_seq,
+                              std::string_view body) {
+    if (length != sizeof(uint64_t) + body.size()) {
+        return false;
+    }
+    uint64_t seq;
+    memcpy(&seq, payload, sizeof(seq));
+    return seq == expected_seq && memcmp(body.data(), payload + sizeof(uint64_t), body.size()) == 0;
+}
+
+// 错误报文: 长度字段最高位置1，低31位为载荷长度，载荷为4字节错误码(网络字节序)
+// 服务器过载时发送后关闭连接，普通报文的长度不会用到最高位
+const uint32_t kErrorFrameFlag = 0x80000000u;
+
+enum FrameError : uint32_t {
+    kErrorOverloaded = 1,       // 缓冲区内存超过硬限制，拒绝新连接
+    kErrorFrameTooLarge = 2,    // 缓冲区内存超过硬限制，拒绝大报文
+};
+
+inline bool isErrorFrameHeader(uint32_t length) {
+    return (length & kErrorFrameFlag) != 0;
+}
+
+inline void buildErrorFrame(uint32_t code, std::vector<char>& out) {
+    out.resize(kFrameHeaderSize + sizeof(code));
+    encodeFrameHeader(out.data(), kErrorFrameFlag | sizeof(code));
+    encodeFrameHeader(out.data() + kFrameHeaderSize, code);
+}
+
+inline const char* frameErrorName(uint32_t code) {
+    switch (code) {
+        case kErrorOverloaded: return "overloaded";
+        case kErrorFrameTooLarge: return "frame too large";
+    }
+    return "unknown";
+}
+
+// 校验和尾部: 载荷最后4字节为其前面全部载荷的CRC32C(网络字节序)
+// 压测工具开启校验时附带，服务器可选地验证，回射端无需保留发送数据即可检测损坏
+const size_t kChecksumSize = sizeof(uint32_t);
+
+inline void encodeChecksum(char* out, uint32_t crc) {
+    uint32_t net_crc = htonl(crc);
+    memcpy(out, &net_crc, sizeof(net_crc));
+}
+
+// 验证载荷尾部的校验和
+inline bool verifyPayloadChecksum(const char* payload, size_t length) {
+    if (length < kChecksumSize) {
+        return false;
+    }
+    uint32_t net_crc;
+    memcpy(&net_crc, payload + length - kChecksumSize, sizeof(net_crc));
+    return crc32c(payload, length - kChecksumSize) == ntohl(net_crc);
+}
+
+// 带校验和的压测载荷: 8字节序号 + 数据 + CRC32C，按序号和校验和验证回射
+inline bool verifyEchoChecksum(const char* payload, size_t length, uint64_t expected_seq,
+                               size_t body_size) {
+    if (length != sizeof(uint64_t) + body_size + kChecksumSize) {
+        return false;
+    }
+    uint64_t seq;
+    memcpy(&seq, payload, sizeof(seq));
+    return seq == expected_seq && verifyPayloadChecksum(payload, length);
+}
+
+// 生成size字节的随机字母数字数据
+template <typename Rng>
+std::string generatePayload(Rng& rng, int size) {
+    static const char alphanum[] =
+        "0123456789"
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        "abcdefghijklmnopqrstuvwxyz";
+
+    std::string message;
+    message.reserve(size);
+
+    std::uniform_int_distribution<> dis(0, sizeof(alphanum) - 2);
+    for (int i = 0; i < size; ++i) {
+        message += alphanum[dis(rng)];
+    }
+    return message;
+}
+
+#endif // FRAME_H
@@ -0,0 +1,59 @@
+#ifndef KV_PROTOCOL_H
+#define KV_PROTOCOL_H
+
+#include "frame.h"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// KV命令载荷: 1字节命令 + 2字节键长度(网络字节序) + 键 + 值(仅SET)
+// 响应载荷: 1字节状态 + 值(仅GET命中)，按请求顺序返回，可流水线发送
+const char kKvGet = 'G';
+const char kKvSet = 'S';
+const char kKvDel = 'D';
+
+const char kKvOk = 'O';           // SET/DEL成功，GET命中
+const char kKvNotFound = 'N';     // GET/DEL键不存在
+const char kKvError = 'E';        // 格式错误或值超过上限
+
+const size_t kKvRequestHeaderSize = 3;
+const size_t kMaxKeyLength = 250;
+
+// 把一条KV命令(长度字段 + 载荷)追加到out末尾
+inline void appendKvRequest(char op, std::string_view key, std::string_view value, std::vector<char>& out) {
+    size_t payload_size = kKvRequestHeaderSize + key.size() + value.size();
+    size_t offset = out.size();
+    out.resize(offset + kFrameHeaderSize + payload_size);
+    char* p = out.data() + offset;
+    encodeFrameHeader(p, static_cast<uint32_t>(payload_size));
+    p += kFrameHeaderSize;
+    p[0] = op;
+    uint16_t net_key_length = htons(static_cast<uint16_t>(key.size()));
+    memcpy(p + 1, &net_key_length, sizeof(net_key_length));
+    memcpy(p + kKvRequestHeaderSize, key.data(), key.size());
+    if (!value.empty()) {
+        memcpy(p + kKvRequestHeaderSize + key.size(), value.data(), value.size());
+    }
+}
+
+// 解析KV命令载荷，格式错误返回false；key和value指向payload内部
+inline bool parseKvRequest(const char* payload, size_t length, char& op,
+                           std::string_view& key, std::string_view& value) {
+    if (length < kKvRequestHeaderSize) {
+        return false;
+    }
+    uint16_t net_key_length;
+    memcpy(&net_key_length, payload + 1, sizeof(net_key_length));
+    size_t key_length = ntohs(net_key_length);
+    if (key_length == 0 || key_length > kMaxKeyLength || length < kKvRequestHeaderSize + key_length) {
+        return false;
+    }
+    op = payload[0];
+    key = std::string_view(payload + kKvRequestHeaderSize, key_length);
+    value = std::string_view(payload + kKvRequestHeaderSize + key_length,
+                             length - kKvRequestHeaderSize - key_length);
+    return true;
+}
+
+#endif // KV_PROTOCOL_H
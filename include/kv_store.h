@@ -0,0 +1,104 @@
+#ifndef KV_STORE_H
+#define KV_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// 数据项: 头部 + 键 + 值，存放在slab的定长块中
+struct KvItem {
+    uint64_t hash;
+    uint32_t key_length;
+    uint32_t value_length;
+    uint8_t size_class;
+    bool in_use;
+    bool referenced;        // CLOCK访问位，命中时置位，淘汰指针经过时清除
+    char data[];            // 柔性数组，键在前值在后
+};
+
+// 分片运行统计，持有分片锁时更新，统计线程只读
+struct KvShardStats {
+    std::atomic<uint64_t> gets{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> sets{0};
+    std::atomic<uint64_t> deletes{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> set_failures{0};      // 值过大或该大小级别没有可用内存
+    std::atomic<uint64_t> items{0};
+    std::atomic<uint64_t> memory_bytes{0};      // 已分配的slab页
+};
+
+// 单个分片: 线性探测的开放寻址哈希表 + slab分配的数据项 + 按大小级别的CLOCK淘汰
+// 所有操作须持有mutex()
+class alignas(64) KvShard {
+public:
+    explicit KvShard(size_t memory_limit);
+    ~KvShard();
+
+    std::mutex& mutex() { return mutex_; }
+    const KvShardStats& stats() const { return stats_; }
+
+    // 命中时value指向分片内部，持有锁期间有效
+    bool get(uint64_t hash, std::string_view key, std::string_view& value);
+    bool set(uint64_t hash, std::string_view key, std::string_view value);
+    bool del(uint64_t hash, std::string_view key);
+
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        KvItem* item = nullptr;
+    };
+
+    struct SlabClass {
+        size_t chunk_size = 0;
+        size_t chunks_per_page = 0;
+        std::vector<char*> pages;
+        std::vector<KvItem*> free_chunks;
+        size_t clock_hand = 0;              // 下一个检查的块序号
+    };
+
+    int classFor(size_t size) const;        // 能容纳size字节的最小大小级别，-1表示超过页大小
+    KvItem* allocate(size_t size);          // 先用空闲块，再申请新页，内存用完时在同级别淘汰
+    KvItem* evict(SlabClass& slab_class);
+    void release(KvItem* item);             // 归还块，不修改哈希表
+    KvItem* chunkAt(const SlabClass& slab_class, size_t index) const;
+
+    long findSlot(uint64_t hash, std::string_view key) const;   // 不存在返回-1
+    void insertSlot(uint64_t hash, KvItem* item);
+    void eraseSlot(size_t index);           // 后移删除，不留墓碑
+    void eraseItem(KvItem* item);
+    void grow();
+
+private:
+    std::mutex mutex_;
+    size_t memory_limit_;
+    size_t pages_allocated_;
+    std::vector<SlabClass> classes_;
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t count_;
+    KvShardStats stats_;
+};
+
+// 键值存储: 每个事件循环线程一个分片，键按哈希值分到分片；
+// 流水线的一批命令按分片加锁一次后依次执行
+class KvStore {
+public:
+    KvStore(int shards, size_t memory_limit);
+
+    int shardCount() const { return static_cast<int>(shards_.size()); }
+    KvShard& shard(int index) { return *shards_[index]; }
+    const KvShard& shard(int index) const { return *shards_[index]; }
+    int shardFor(uint64_t hash) const { return static_cast<int>((hash >> 48) % shards_.size()); }
+
+    static uint64_t hashKey(std::string_view key);
+
+private:
+    std::vector<std::unique_ptr<KvShard>> shards_;
+};
+
+#endif // KV_STORE_H
@@ -0,0 +1,60 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 按本机字节序追加/读取定长值，用于统计结果在同一台机器的进程间传递
+template <typename T>
+inline void appendPod(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+inline bool readPod(const char*& data, const char* end, T& value) {
+    if (end - data < static_cast<long>(sizeof(T))) {
+        return false;
+    }
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+// HDR风格的延迟直方图(单位: 纳秒)
+// 小于2^precision_bits的值精确记录，之后每个2的幂区间再均分为2^(precision_bits-1)个桶，
+// 相对误差不超过 1/2^(precision_bits-1)。记录为O(1)，不分配内存，非线程安全(每线程一个)。
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(int64_t max_value = 60LL * 1000 * 1000 * 1000, int precision_bits = 7);
+
+    void record(int64_t value);                         // 记录一个值，超过上限按上限计
+    void merge(const LatencyHistogram& other);          // 合并另一个直方图(精度需一致)
+    void reset();                                       // 清空
+    void appendTo(std::vector<char>& out) const;        // 序列化后追加到out
+    bool readFrom(const char*& data, const char* end);  // 从data反序列化，范围或精度不一致时返回false
+
+    int64_t count() const { return total_count_; }
+    int64_t min() const { return total_count_ > 0 ? min_ : 0; }
+    int64_t max() const { return max_; }
+    double mean() const;
+    int64_t percentile(double p) const;                 // p取值0~100
+
+private:
+    int bucketIndex(int64_t value) const;               // 值 -> 桶下标
+    int64_t highestEquivalentValue(int index) const;    // 桶下标 -> 桶内最大值
+
+private:
+    int64_t max_value_;                 // 可记录的最大值
+    int precision_bits_;                // 精度位数
+    int sub_bucket_count_;              // 2^precision_bits
+    int sub_bucket_half_;               // 每个区间的桶数
+    std::vector<uint64_t> counts_;      // 各桶计数
+    int64_t total_count_;               // 总记录数
+    int64_t min_;                       // 最小值
+    int64_t max_;                       // 最大值
+    double sum_;                        // 总和，用于计算平均值
+};
+
+#endif // LATENCY_HISTOGRAM_H
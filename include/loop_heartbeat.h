@@ -0,0 +1,112 @@
+#ifndef LOOP_HEARTBEAT_H
+#define LOOP_HEARTBEAT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// 事件循环当前所处的阶段，供看门狗定位卡住的位置
+enum LoopStage {
+    STAGE_WAIT,         // 阻塞在epoll_wait，不算卡顿
+    STAGE_DISPATCH,     // epoll_wait返回后尚未进入具体处理
+    STAGE_ACCEPT,
+    STAGE_READ,         // 读取并处理报文
+    STAGE_WRITE,        // 发送积压数据
+    STAGE_CLOSE,
+    STAGE_FLUSH,        // 发布订阅: 统一发送转发报文
+    STAGE_HOUSEKEEPING  // 空闲检查、恢复暂停的连接、连接快照
+};
+
+inline const char* loopStageName(int stage) {
+    switch (stage) {
+        case STAGE_WAIT: return "wait";
+        case STAGE_DISPATCH: return "dispatch";
+        case STAGE_ACCEPT: return "accept";
+        case STAGE_READ: return "read";
+        case STAGE_WRITE: return "write";
+        case STAGE_CLOSE: return "close";
+        case STAGE_FLUSH: return "flush";
+        case STAGE_HOUSEKEEPING: return "housekeeping";
+    }
+    return "unknown";
+}
+
+// 按2的幂分桶的直方图，第i个桶统计[2^i, 2^(i+1))，0计入第0个桶
+// 只由一个线程写入，其他线程可随时读取
+class Log2Histogram {
+public:
+    static const int kBuckets = 48;
+
+    void record(uint64_t value) {
+        int bucket = value == 0 ? 0 : 63 - __builtin_clzll(value);
+        if (bucket >= kBuckets) {
+            bucket = kBuckets - 1;
+        }
+        buckets_[bucket].store(buckets_[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+    uint64_t bucket(int index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            total += bucket(i);
+        }
+        return total;
+    }
+    // 百分位所在桶的上界(不超过最大值)，精度为2倍
+    uint64_t percentile(double p) const {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(total * p / 100.0);
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += bucket(i);
+            if (seen > target) {
+                return std::min<uint64_t>((2ULL << i) - 1, max());
+            }
+        }
+        return max();
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> max_{0};
+};
+
+// 事件循环每轮发布的心跳，看门狗线程读取
+struct LoopHeartbeat {
+    std::atomic<int64_t> iteration_start_ns{0};  // 本轮开始时间(steady_clock)，阻塞等待期间为0
+    std::atomic<uint64_t> iteration{0};          // 轮次编号，看门狗据此对同一轮只报告一次
+    std::atomic<int> stage{STAGE_WAIT};
+    std::atomic<int> fd{-1};                     // 正在处理的连接，-1表示不针对单个连接
+    Log2Histogram iteration_ns;                  // 每轮(不含epoll_wait)耗时
+    Log2Histogram batch_events;                  // 每次epoll_wait返回的事件数
+
+    void beginIteration(int64_t now_ns, int events) {
+        iteration.store(iteration.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        batch_events.record(events > 0 ? events : 0);
+        mark(STAGE_DISPATCH, -1);
+        iteration_start_ns.store(now_ns, std::memory_order_release);
+    }
+    void endIteration(int64_t now_ns) {
+        int64_t start = iteration_start_ns.load(std::memory_order_relaxed);
+        if (start == 0) {
+            return;
+        }
+        iteration_ns.record(now_ns - start);
+        iteration_start_ns.store(0, std::memory_order_release);
+        stage.store(STAGE_WAIT, std::memory_order_relaxed);
+        fd.store(-1, std::memory_order_relaxed);
+    }
+    void mark(LoopStage current, int current_fd) {
+        stage.store(current, std::memory_order_relaxed);
+        fd.store(current_fd, std::memory_order_relaxed);
+    }
+};
+
+#endif // LOOP_HEARTBEAT_H
@@ -0,0 +1,33 @@
+#ifndef LOOP_WATCHDOG_H
+#define LOOP_WATCHDOG_H
+
+#include "server.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// 事件循环卡顿看门狗: 监控线程定期检查各worker的心跳，
+// 单轮处理超过阈值时输出所处阶段和连接，同一轮只报告一次
+// 被监控的worker须开启ServerConfig::loop_heartbeat
+class LoopWatchdog {
+public:
+    LoopWatchdog(const std::vector<EpollServer*>& servers, int threshold_ms);
+    ~LoopWatchdog();
+
+    void start();
+    void stop();
+    uint64_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+private:
+    std::vector<EpollServer*> servers_;
+    int64_t threshold_ns_;
+    std::vector<uint64_t> reported_;        // 各worker最近报告过的轮次
+    std::atomic<uint64_t> stalls_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+#endif // LOOP_WATCHDOG_H
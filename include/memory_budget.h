@@ -0,0 +1,47 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+// 缓冲区内存记账，同一进程的所有worker共享一个实例，无锁更新
+// 记录连接输入/输出缓冲区中持有的字节数:
+//   超过软限制时暂停持有量高于平均值的连接的读取，
+//   超过硬限制时拒绝新连接和大报文。限制为0表示不限制
+class MemoryBudget {
+public:
+    MemoryBudget(int64_t soft_limit = 0, int64_t hard_limit = 0)
+        : soft_limit_(soft_limit), hard_limit_(hard_limit) {}
+    
+    void add(int64_t delta) {
+        int64_t used = used_.fetch_add(delta, std::memory_order_relaxed) + delta;
+        int64_t peak = peak_.load(std::memory_order_relaxed);
+        while (used > peak && !peak_.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+        }
+    }
+    void addConnection(int delta) { connections_.fetch_add(delta, std::memory_order_relaxed); }
+    
+    int64_t used() const { return used_.load(std::memory_order_relaxed); }
+    int connections() const { return connections_.load(std::memory_order_relaxed); }
+    int64_t peak() const { return peak_.load(std::memory_order_relaxed); }
+    int64_t softLimit() const { return soft_limit_; }
+    int64_t hardLimit() const { return hard_limit_; }
+    
+    bool aboveSoft() const { return soft_limit_ > 0 && used() > soft_limit_; }
+    // 再占用extra字节后是否超过硬限制
+    bool aboveHard(int64_t extra = 0) const { return hard_limit_ > 0 && used() + extra > hard_limit_; }
+    // 每个连接平均持有的字节数，持有超过平均值的连接视为最大的消费者
+    int64_t average() const {
+        return used() / std::max(connections_.load(std::memory_order_relaxed), 1);
+    }
+    
+private:
+    const int64_t soft_limit_;
+    const int64_t hard_limit_;
+    std::atomic<int64_t> used_{0};
+    std::atomic<int64_t> peak_{0};
+    std::atomic<int> connections_{0};
+};
+
+#endif // MEMORY_BUDGET_H
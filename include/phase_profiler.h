@@ -0,0 +1,98 @@
+#ifndef PHASE_PROFILER_H
+#define PHASE_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 事件循环的处理阶段
+enum LoopPhase {
+    PHASE_WAIT,         // epoll_wait(含阻塞等待)
+    PHASE_RECV,         // recv系统调用
+    PHASE_FRAMING,      // 解析长度字段、校验和
+    PHASE_HANDLER,      // 回射/发布订阅/键值命令处理
+    PHASE_SEND,         // sendmsg系统调用
+    PHASE_COUNT
+};
+
+inline const char* loopPhaseName(int phase) {
+    switch (phase) {
+        case PHASE_WAIT: return "wait";
+        case PHASE_RECV: return "recv";
+        case PHASE_FRAMING: return "framing";
+        case PHASE_HANDLER: return "handler";
+        case PHASE_SEND: return "send";
+    }
+    return "unknown";
+}
+
+// 时间戳计数器，x86上为rdtsc，其他平台退化为steady_clock纳秒
+inline uint64_t readTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// 按循环轮次采样的分阶段耗时: 每sample_rounds轮中有一轮记录各阶段的时间戳差，
+// 未采样的轮次每个计时点只多一次分支判断；sample_rounds为0时完全关闭
+// 只由所属事件循环线程记录，统计字段可由其他线程读取
+class PhaseProfiler {
+public:
+    struct PhaseStats {
+        std::atomic<uint64_t> ticks{0};
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> max_ticks{0};
+    };
+
+    explicit PhaseProfiler(int sample_rounds = 0)
+        : sample_rounds_(sample_rounds), round_(0), active_(false) {}
+
+    bool enabled() const { return sample_rounds_ > 0; }
+    // 每轮循环开始时调用，决定本轮是否采样
+    void beginRound() {
+        active_ = sample_rounds_ > 0 && ++round_ % sample_rounds_ == 0;
+    }
+    uint64_t start() const { return active_ ? readTsc() : 0; }
+    void record(LoopPhase phase, uint64_t start_ticks) {
+        if (!active_) {
+            return;
+        }
+        uint64_t elapsed = readTsc() - start_ticks;
+        PhaseStats& stats = phases_[phase];
+        stats.ticks.store(stats.ticks.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+        stats.samples.store(stats.samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (elapsed > stats.max_ticks.load(std::memory_order_relaxed)) {
+            stats.max_ticks.store(elapsed, std::memory_order_relaxed);
+        }
+    }
+    const PhaseStats& stats(int phase) const { return phases_[phase]; }
+
+    // 每纳秒的计数，首次调用时对照steady_clock校准约20毫秒
+    static double ticksPerNs() {
+        static const double ticks_per_ns = [] {
+            auto begin = std::chrono::steady_clock::now();
+            uint64_t begin_ticks = readTsc();
+            while (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(20)) {
+            }
+            uint64_t end_ticks = readTsc();
+            double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+            return ns > 0 ? (end_ticks - begin_ticks) / ns : 1.0;
+        }();
+        return ticks_per_ns;
+    }
+
+private:
+    const int sample_rounds_;
+    uint64_t round_;
+    bool active_;
+    PhaseStats phases_[PHASE_COUNT];
+};
+
+#endif // PHASE_PROFILER_H
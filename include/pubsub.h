@@ -0,0 +1,55 @@
+#ifndef PUBSUB_H
+#define PUBSUB_H
+
+#include "frame.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 发布订阅模式的报文载荷: 1字节操作码 + 1字节主题长度 + 主题 + 数据
+//   订阅/取消订阅: 数据为空，服务器原样回复订阅报文作为确认
+//   发布: 服务器把整个发布报文原样转发给该主题的所有订阅者，发布者本身不收到回复
+const char kOpSubscribe = 'S';
+const char kOpUnsubscribe = 'U';
+const char kOpPublish = 'P';
+const size_t kMaxTopicLength = 255;
+
+// 构建发布订阅报文(长度字段 + 载荷)，复用out已分配的内存
+inline void buildPubSubFrame(char op, const std::string& topic, const char* data, size_t length,
+                             std::vector<char>& out) {
+    size_t payload_size = 2 + topic.size() + length;
+    out.resize(kFrameHeaderSize + payload_size);
+    char* p = out.data();
+    encodeFrameHeader(p, static_cast<uint32_t>(payload_size));
+    p += kFrameHeaderSize;
+    p[0] = op;
+    p[1] = static_cast<char>(topic.size());
+    memcpy(p + 2, topic.data(), topic.size());
+    if (length > 0) {
+        memcpy(p + 2 + topic.size(), data, length);
+    }
+}
+
+// 解析发布订阅载荷，格式错误返回false；topic和data指向payload内部
+inline bool parsePubSubPayload(const char* payload, size_t length, char& op,
+                               std::string_view& topic, std::string_view& data) {
+    if (length < 2) {
+        return false;
+    }
+    size_t topic_length = static_cast<unsigned char>(payload[1]);
+    if (topic_length == 0 || length < 2 + topic_length) {
+        return false;
+    }
+    op = payload[0];
+    topic = std::string_view(payload + 2, topic_length);
+    data = std::string_view(payload + 2 + topic_length, length - 2 - topic_length);
+    return true;
+}
+
+// 共享报文: 发布的报文只保存一份，各订阅者的发送队列持有引用，最后一个发送完时释放
+typedef std::shared_ptr<const std::vector<char>> SharedFrame;
+
+#endif // PUBSUB_H
@@ -1,8 +1,21 @@
 #ifndef EPOLL_SERVER_H
 #define EPOLL_SERVER_H
 
+#include "memory_budget.h"
+#include "pubsub.h"
+#include "kv_store.h"
+#include "phase_profiler.h"
+#include "loop_heartbeat.h"
 #include <string>
-#include <set>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
 
 // 简单文本协议 - echo服务器使用原始字节流
 struct EchoMessage {
@@ -10,12 +23,141 @@ struct EchoMessage {
     char data[];             // 柔性数组，数据内容
 };
 
+// 服务器工作模式
+enum ServerMode {
+    MODE_ECHO,      // 回射每个报文
+    MODE_PUBSUB,    // 发布订阅: 发布到主题的报文转发给所有订阅者
+    MODE_KV         // 键值存储: 执行GET/SET/DEL并按请求顺序回复
+};
+
+// 发送跟不上的订阅者(上次发送已阻塞或排队超过output_high_watermark)的处理策略
+enum SlowSubscriberPolicy {
+    SLOW_DROP,          // 丢弃新报文
+    SLOW_DISCONNECT,    // 断开连接
+    SLOW_BUFFER         // 总共排队最多subscriber_queue_limit个报文，超出后断开
+};
+
+// 按连接的诊断日志级别，出错的连接在LOG_WARN输出，连接建立/关闭在LOG_DEBUG输出
+enum LogLevel {
+    LOG_ERROR,
+    LOG_WARN,
+    LOG_INFO,
+    LOG_DEBUG
+};
+
+inline const char* logLevelName(int level) {
+    switch (level) {
+        case LOG_ERROR: return "error";
+        case LOG_WARN: return "warn";
+        case LOG_INFO: return "info";
+        case LOG_DEBUG: return "debug";
+    }
+    return "unknown";
+}
+
+inline bool parseLogLevel(const std::string& name, LogLevel& level) {
+    for (int i = LOG_ERROR; i <= LOG_DEBUG; ++i) {
+        if (name == logLevelName(i)) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+struct ServerTunables;
+class TrafficRecorder;
+
 // 服务器配置
 struct ServerConfig {
     int port = 8080;
     int max_events = 20000;
     int timeout_ms = 10000; // 10秒超时
     bool use_et_mode = true; // 使用边缘触发模式
+    bool reuse_port = false; // 多个worker各自监听同一端口(SO_REUSEPORT)，由内核分发连接
+    int listen_backlog = 128; // 监听队列长度，短连接高速率时过小会丢SYN
+    bool verify_checksum = false; // 验证载荷尾部的CRC32C，不匹配时断开连接
+    bool listen = true;      // 为false时不监听端口，只服务adoptConnection()加入的连接
+    int cpu = -1;            // 事件循环绑定的CPU，-1不绑定；绑定后统计连接是否在本CPU上收包
+    int busy_poll_us = 0;    // 阻塞前最多自旋轮询epoll的时间(微秒)，0关闭；窗口按命中情况自适应
+    int busy_poll_budget_percent = 50; // 自旋最多占用的CPU时间比例，超出后本秒内直接阻塞
+    int socket_busy_poll_us = 0;       // 连接上设置SO_BUSY_POLL/SO_PREFER_BUSY_POLL，0不设置
+    int budget_messages = 0; // 每个连接每轮最多处理的消息数，0不限制
+    int budget_bytes = 0;    // 每个连接每轮最多处理的字节数，0不限制；超出预算的连接进入就绪队列轮转
+    int output_high_watermark = 1024 * 1024; // 单个连接待发送数据超过该值时暂停读取，等对端读走回射
+    int large_frame_bytes = 64 * 1024;       // 内存超过硬限制时拒绝不小于该长度的报文
+    MemoryBudget* memory_budget = nullptr;   // 多个worker共享的缓冲区内存记账，nullptr时使用不限制的私有实例
+    ServerMode mode = MODE_ECHO;
+    SlowSubscriberPolicy slow_policy = SLOW_BUFFER;
+    int subscriber_queue_limit = 1024;       // SLOW_BUFFER下慢订阅者最多排队的报文数
+    KvStore* kv_store = nullptr;             // 多个worker共享的键值存储(每个worker一个分片)，nullptr时使用私有的单分片实例
+    size_t kv_memory = 64 * 1024 * 1024;     // 私有键值存储的slab内存上限
+    int kv_batch = 64;                       // 每次加锁执行的流水线命令数上限
+    int max_connections = 0;                 // 进程内连接数上限，超出时回复过载错误后关闭，0不限制
+    int idle_timeout_ms = 0;                 // 无收发超过该时间的连接被关闭，0不超时
+    LogLevel log_level = LOG_WARN;
+    int profile_sample_rounds = 0;           // 每N轮循环用rdtsc采样一轮各阶段耗时，0关闭
+    bool loop_heartbeat = false;             // 每轮发布心跳并记录轮耗时/批大小直方图，供LoopWatchdog监控
+    ServerTunables* tunables = nullptr;      // 多个worker共享的运行期可调参数，nullptr时使用按本配置初始化的私有实例
+    TrafficRecorder* recorder = nullptr;     // 多个worker共享的流量录制，nullptr时不录制
+};
+
+// 运行期可调参数，由管理端口修改，事件循环每次使用时读取，改动对已有连接立即生效
+// 初始值取自ServerConfig中的同名字段
+struct ServerTunables {
+    std::atomic<int> max_connections{0};
+    std::atomic<int> idle_timeout_ms{0};
+    std::atomic<int> budget_messages{0};
+    std::atomic<int> budget_bytes{0};
+    std::atomic<int> log_level{LOG_WARN};
+    
+    void initialize(const ServerConfig& config) {
+        max_connections.store(config.max_connections, std::memory_order_relaxed);
+        idle_timeout_ms.store(config.idle_timeout_ms, std::memory_order_relaxed);
+        budget_messages.store(config.budget_messages, std::memory_order_relaxed);
+        budget_bytes.store(config.budget_bytes, std::memory_order_relaxed);
+        log_level.store(config.log_level, std::memory_order_relaxed);
+    }
+};
+
+// 管理端口列出的单个连接，由事件循环线程在快照时填写
+struct ConnectionInfo {
+    int fd = -1;
+    std::string peer;               // 对端地址:端口
+    uint64_t bytes_received = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t messages = 0;
+    size_t buffered = 0;            // 输入缓冲区未处理和待发送的字节数
+    int64_t idle_ms = 0;            // 距上次收发的时间
+    bool paused = false;            // 因内存或输出积压暂停读取
+    uint32_t rtt_us = 0;            // TCP_INFO
+    uint32_t rtt_var_us = 0;
+    uint32_t snd_cwnd = 0;
+    uint32_t total_retrans = 0;
+};
+
+// 服务器运行统计，由事件循环线程更新，其他线程只读
+struct ServerStats {
+    std::atomic<uint64_t> accepted_connections{0};  // 累计接受的连接数
+    std::atomic<uint64_t> closed_connections{0};    // 累计关闭的连接数
+    std::atomic<uint64_t> accept_errors{0};         // accept失败次数(不含EAGAIN)
+    std::atomic<uint64_t> checksum_errors{0};       // 校验和不匹配的报文数
+    std::atomic<uint64_t> local_connections{0};     // 绑核时，收包CPU与本worker一致的连接数
+    std::atomic<uint64_t> remote_connections{0};    // 绑核时，收包CPU与本worker不一致的连接数
+    std::atomic<uint64_t> spin_rounds{0};           // 进入自旋轮询的次数
+    std::atomic<uint64_t> spin_hits{0};             // 自旋期间等到事件的次数
+    std::atomic<uint64_t> spin_ns{0};               // 自旋累计耗时
+    std::atomic<uint64_t> budget_deferrals{0};      // 用完预算后推迟处理的次数
+    std::atomic<uint64_t> reads_paused{0};          // 内存超过软限制时暂停读取的次数
+    std::atomic<uint64_t> rejected_connections{0};  // 内存超过硬限制时拒绝的连接数
+    std::atomic<uint64_t> rejected_frames{0};       // 内存超过硬限制时拒绝的大报文数
+    std::atomic<uint64_t> published{0};             // 收到的发布报文数
+    std::atomic<uint64_t> delivered{0};             // 放入订阅者发送队列的报文数
+    std::atomic<uint64_t> dropped{0};               // 因订阅者阻塞丢弃的报文数
+    std::atomic<uint64_t> slow_disconnects{0};      // 因发送跟不上断开的订阅者数
+    std::atomic<uint64_t> loop_rounds{0};           // 事件循环轮数
+    std::atomic<uint64_t> events_handled{0};        // epoll返回的事件总数
+    std::atomic<uint64_t> idle_closed{0};           // 因空闲超时关闭的连接数
 };
 
 class EpollServer {
@@ -25,28 +167,153 @@ public:
     
     bool initialize();
     void run();
-    void stop();
+    void stop();                    // 通知事件循环退出，可在信号处理或其他线程中调用
+    const ServerStats& stats() const { return stats_; }
+    const MemoryBudget& memoryBudget() const { return *memory_; }
+    const KvStore& kvStore() const { return *kv_; }
+    ServerTunables& tunables() { return *tunables_; }
+    const PhaseProfiler& profiler() const { return profiler_; }
+    const LoopHeartbeat& heartbeat() const { return heartbeat_; }
+    void wakeup();                  // 唤醒阻塞在epoll_wait中的事件循环，使修改的可调参数立即生效
+    // 由事件循环分批抓取连接快照，可在其他线程调用；事件循环timeout_ms内未完成时返回false
+    bool listConnections(std::vector<ConnectionInfo>& connections, int timeout_ms);
+    bool adoptConnection(int fd);   // 接管一个已建立的连接(如socketpair一端)，须在run()之前调用
+    // 为SO_REUSEPORT组挂载CBPF程序，在cpus[k]上收到的连接交给第k个监听套接字，
+    // 其他CPU按(cpu % cpus.size())分散；须在组内所有worker都initialize()之后对任一worker调用一次
+    bool attachCpuSteering(const std::vector<int>& cpus);
     
 private:
+    // 每个连接的输入/输出缓冲区，按fd下标存放
+    struct ClientBuffer {
+        bool open = false;
+        std::vector<char> input;        // 已接收未处理的数据
+        size_t input_offset = 0;        // input中已处理到的位置
+        std::vector<char> output;       // 待发送的回射数据
+        size_t output_offset = 0;       // output中已发送到的位置
+        int64_t accounted = 0;          // 已计入MemoryBudget的字节数
+        uint32_t events = 0;            // 当前注册的epoll事件
+        bool ready = false;             // 是否在就绪队列中
+        bool memory_paused = false;     // 因内存超过软限制暂停读取
+        std::deque<SharedFrame> shared_output;  // 待转发的发布报文，排在output之后发送
+        size_t shared_offset = 0;       // 队首报文已发送的字节数
+        size_t shared_bytes = 0;        // 队列中报文的总字节数
+        std::vector<std::string> topics;// 订阅的主题
+        bool flush_pending = false;     // 是否在待发送列表中
+        bool closing = false;           // 已决定断开，等待统一关闭
+        uint64_t bytes_received = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t messages = 0;
+        int64_t last_active_ms = 0;     // 上次收到或发出数据的循环时间
+        uint32_t trace_connection = 0;  // 流量录制中的连接编号
+        
+        size_t pendingOutput() const { return output.size() - output_offset + shared_bytes - shared_offset; }
+        // 计入MemoryBudget的字节数，按缓冲区容量计算，已处理但未释放的空间同样占用内存；
+        // 共享报文在创建时单独记账
+        size_t held() const { return input.capacity() + output.capacity(); }
+    };
+    
     bool setupListenSocket();       // 获取监听套接字
     bool setupEpoll();              // 创建epoll
+    void cleanup();                 // 关闭所有描述符
     void handleNewConnection();     // 处理新连接
-    void handleClientData(int fd);  // 处理客户端数据，回射
+    void openClient(int fd);        // 初始化连接缓冲区并加入epoll
+    ClientBuffer* findClient(int fd);               // 按fd直接索引连接，不存在返回nullptr
+    void handleClientData(int fd);  // 处理客户端数据，回射，每次最多处理一轮预算
+    void handleClientWrite(int fd); // 发送积压的回射数据
+    void serviceReadyList();        // 轮转处理用完预算但仍有数据的连接
+    void markReady(int fd);         // 加入就绪队列
     void handleClientClose(int fd); // 关闭连接
+    int waitEvents(struct epoll_event* events);     // 等待事件，开启busy-poll时先自旋
+    int busyPoll(struct epoll_event* events);       // 在自适应窗口内自旋，返回0表示未等到事件
     void addEpollEvent(int fd, uint32_t events);    // 添加epoll事件
+    void modifyEpollEvent(int fd, uint32_t events); // 修改epoll事件
     void removeEpollEvent(int fd);                  // 删除epoll事件
     
-    // 读取完整报文
-    int readCompleteMessage(int fd, std::string& message);
-    // 发送完整报文
-    bool sendCompleteMessage(int fd, const std::string& message);
+    bool canProcess(const ClientBuffer& client) const;  // 输出未积压，可以继续处理已缓存的报文
+    bool canRead(const ClientBuffer& client) const; // 可以处理且未因内存暂停recv
+    bool shouldPause(const ClientBuffer& client) const; // 超过软限制时是否暂停该连接的recv
+    void updateInterest(int fd, ClientBuffer& client);  // 按缓冲区状态调整关注事件
+    void account(ClientBuffer& client);             // 把缓冲区持有量的变化计入MemoryBudget
+    void resumePaused();                            // 内存回落到软限制以下后恢复读取
+    void closeIdle();                               // 关闭空闲超时的连接
+    void serviceSnapshot();                         // 为listConnections()抓取一批连接
+    void captureFrame(const ClientBuffer& client, const char* payload, uint32_t length);  // 录制一个完整报文
+    void flushCapture();                            // 把录制块交给后台写线程
+    void markStage(LoopStage stage, int fd) {      // 开启心跳时记录当前阶段和连接
+        if (config_.loop_heartbeat) {
+            heartbeat_.mark(stage, fd);
+        }
+    }
+    bool logEnabled(LogLevel level) const { return tunables_->log_level.load(std::memory_order_relaxed) >= level; }
+    
+    // 检查offset处的报文，返回载荷长度，0表示数据不完整，-1表示须关闭连接
+    int nextFrame(int fd, ClientBuffer& client, size_t offset);
+    // 从缓冲区处理一个完整报文并追加回射，返回载荷长度，0表示数据不完整，-1表示须关闭连接
+    int processMessage(int fd, ClientBuffer& client);
+    // 键值模式: 取出最多max_commands条完整命令，涉及的分片各加锁一次后按序执行，
+    // commands返回执行的命令数；返回载荷总长度，0表示数据不完整，-1表示须关闭连接
+    int processKvBatch(int fd, ClientBuffer& client, int max_commands, int& commands);
+    // 读取一批数据到输入缓冲区，返回1表示读到数据，0表示暂无数据，-1表示连接关闭或出错
+    int readInput(int fd, ClientBuffer& client);
+    // 尽量发送输出缓冲区，返回false表示发送出错
+    bool flushOutput(int fd, ClientBuffer& client);
+    // 尽力发送错误报文，调用者随后关闭连接
+    void sendErrorFrame(int fd, uint32_t code);
+    
+    // 发布订阅: 处理一个订阅/取消订阅/发布报文，返回false表示报文格式错误
+    bool handlePubSub(int fd, ClientBuffer& client, const char* frame, size_t frame_size);
+    void subscribe(int fd, ClientBuffer& client, std::string_view topic);
+    void unsubscribe(int fd, ClientBuffer& client, std::string_view topic);
+    void publish(std::string_view topic, const char* frame, size_t frame_size);
+    void deliver(int fd, const SharedFrame& frame);  // 按慢订阅者策略放入发送队列
+    void flushPending();                            // 统一发送本轮排队的转发报文，关闭被断开的订阅者
+    
+    // 一批流水线命令中解析出的一条
+    struct KvCommand {
+        char op;
+        std::string_view key;
+        std::string_view value;
+        uint64_t hash;
+        int shard;
+    };
     
 private:
     ServerConfig config_;                   // 服务器配置
     int listen_fd_;                         // 监听套接字描述符
     int epoll_fd_;                          // epoll描述符
-    bool running_;                          // 服务器是否在运行
-    std::set<int> client_buffers_;          // 客户端
+    int wakeup_fd_;                         // 用于唤醒epoll_wait的eventfd
+    std::atomic<bool> running_;             // 服务器是否在运行
+    MemoryBudget own_memory_;               // 未共享记账时使用的私有实例，须在缓冲区之后析构
+    MemoryBudget* memory_;                  // 缓冲区内存记账
+    std::vector<ClientBuffer> client_buffers_;  // 客户端缓冲区，按fd下标
+    ServerStats stats_;                     // 运行统计
+    std::deque<int> ready_list_;            // 缓冲区或内核中仍有待处理数据的连接，不会再收到通知
+    std::vector<int> paused_fds_;           // 因内存暂停读取的连接
+    std::unordered_map<std::string, std::vector<int>> topics_;  // 主题 -> 订阅者fd
+    std::vector<int> flush_list_;           // 本轮有转发报文待发送的连接
+    std::unique_ptr<KvStore> own_kv_;       // 未共享键值存储时使用的私有实例
+    KvStore* kv_;                           // 键值存储
+    std::vector<KvCommand> kv_batch_;       // 当前批次的命令，复用避免分配
+    std::vector<int> kv_shards_;            // 当前批次涉及的分片，升序加锁
+    ServerTunables own_tunables_;           // 未共享可调参数时使用的私有实例
+    ServerTunables* tunables_;              // 运行期可调参数
+    int64_t loop_time_ms_;                  // 本轮循环开始的时间，用于空闲计时
+    int64_t last_idle_check_ms_;            // 上次检查空闲连接的时间
+    std::mutex snapshot_mutex_;             // 保护以下快照状态
+    std::condition_variable snapshot_cv_;
+    std::atomic<bool> snapshot_requested_;  // 有未完成的连接快照请求
+    bool snapshot_done_;
+    size_t snapshot_cursor_;                // 下一批从该fd开始
+    std::vector<ConnectionInfo> snapshot_;
+    PhaseProfiler profiler_;                // 分阶段耗时采样
+    LoopHeartbeat heartbeat_;               // 看门狗读取的心跳
+    std::vector<char> capture_chunk_;       // 本worker未交出的录制记录
+    uint64_t capture_records_;              // capture_chunk_中的记录数
+    int64_t capture_flush_ms_;              // 上次交块的时间
+    int spin_window_us_;                    // 当前自旋窗口
+    int64_t budget_window_start_ns_;        // 自旋预算统计周期的起点
+    int64_t budget_spent_ns_;               // 本周期内已自旋的时间
+    std::vector<char> read_scratch_;        // 所有连接共用的接收缓冲区，只把实际收到的字节追加到连接
     // int total_recv;
     // int total_send;
 };
@@ -0,0 +1,82 @@
+#ifndef SIZE_DISTRIBUTION_H
+#define SIZE_DISTRIBUTION_H
+
+#include "latency_histogram.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 压测报文大小分布，main_pressure和main_stress共用。描述串:
+//   fixed:N                        固定N字节(默认)
+//   uniform:MIN,MAX                [MIN, MAX]均匀分布
+//   lognormal:MEDIAN,SIGMA[,MAX]   对数正态，中位数MEDIAN，ln(size)的标准差SIGMA，超过MAX(默认1MB)截断
+//   bimodal:SMALL,LARGE,P          以概率P取LARGE，否则取SMALL
+//   zipf:MIN,MAX[,THETA]           第k小的大小按1/k^THETA加权(默认0.99)，小报文占多数
+//   file:PATH                      经验直方图，每行"大小 权重"，#开头为注释
+// 构造时把分布离散成2^16项的分位数表，运行时用一次xorshift取表项，不做浮点运算
+class SizeDistribution {
+public:
+    static const int kTableBits = 16;
+    static const int kMaxSize = 1024 * 1024;    // 压测客户端接受的最大报文
+
+    explicit SizeDistribution(int fixed_size = 1024);
+
+    // 解析描述串并建表，失败时输出原因并返回false，原分布不变
+    bool parse(const std::string& spec);
+    bool fixed() const { return min_ == max_; }
+    int sample(uint64_t random) const { return table_[random >> (64 - kTableBits)]; }
+    int minSize() const { return min_; }
+    int maxSize() const { return max_; }
+    double meanSize() const { return mean_; }
+    const std::string& spec() const { return spec_; }
+
+private:
+    // 按权重的离散分布建分位数表
+    void buildTable(const std::vector<int>& sizes, const std::vector<double>& weights);
+
+private:
+    std::string spec_;
+    std::vector<int> table_;
+    int min_;
+    int max_;
+    double mean_;
+};
+
+// xorshift64*，每线程一个，抽样报文大小时代替mt19937
+class FastRng {
+public:
+    explicit FastRng(uint64_t seed) : state_(seed != 0 ? seed : 0x9e3779b97f4a7c15ULL) {}
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545f4914f6cdd1dULL;
+    }
+
+private:
+    uint64_t state_;
+};
+
+// 按报文大小分桶(2的幂)的吞吐和延迟，每线程一份，结束后合并
+struct SizeBucketStats {
+    static const int kBuckets = 21;             // 第i桶为[2^i, 2^(i+1))，最后一桶含1MB
+
+    long messages[kBuckets] = {};
+    long bytes[kBuckets] = {};
+    std::vector<LatencyHistogram> latency;
+
+    SizeBucketStats() : latency(kBuckets) {}
+    static int bucketFor(size_t size);
+    void record(size_t size, int64_t latency_ns);
+    void merge(const SizeBucketStats& other);
+    void reset();
+    void appendTo(std::vector<char>& out) const;
+    bool readFrom(const char*& data, const char* end);
+    // 输出非空桶的报文数、速率、吞吐和延迟分位数
+    void print(std::ostream& out, double duration_sec) const;
+    // 输出JSON数组(不含键名)，每个非空桶一个对象
+    void writeJson(std::ostream& out, double duration_sec) const;
+};
+
+#endif // SIZE_DISTRIBUTION_H
@@ -0,0 +1,34 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// USDT静态探针，provider为echo_server。系统有<sys/sdt.h>(systemtap-sdt-dev)时编译为一条nop
+// 加ELF note，未挂载时没有开销；没有该头文件时探针为空。例:
+//   bpftrace -e 'usdt:./main_server:echo_server:handler_start { @s[arg0] = nsecs; }
+//                usdt:./main_server:echo_server:handler_end { @ns = hist(nsecs - @s[arg0]); }'
+//   perf probe -x ./main_server sdt_echo_server:send && perf record -e sdt_echo_server:send
+//
+// 探针及参数:
+//   accept(fd)                      新连接加入事件循环
+//   wait_end(events)                epoll_wait返回
+//   recv(fd, bytes)                 一次recv读到数据
+//   frame_complete(fd, length)      缓冲区中出现一个完整且校验通过的报文
+//   handler_start(fd, count)        开始处理count个报文(键值模式为一批命令)
+//   handler_end(fd, count)
+//   send(fd, bytes)                 一次sendmsg发出数据
+//   close(fd)                       连接关闭
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define ECHO_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef ECHO_HAVE_SDT
+#define TRACE_PROBE1(name, a) DTRACE_PROBE1(echo_server, name, a)
+#define TRACE_PROBE2(name, a, b) DTRACE_PROBE2(echo_server, name, a, b)
+#else
+#define TRACE_PROBE1(name, a) ((void)0)
+#define TRACE_PROBE2(name, a, b) ((void)0)
+#endif
+
+#endif // TRACE_H
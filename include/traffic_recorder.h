@@ -0,0 +1,69 @@
+#ifndef TRAFFIC_RECORDER_H
+#define TRAFFIC_RECORDER_H
+
+#include "traffic_trace.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 服务器端流量录制: 各事件循环把收到的完整报文追加到自己的块缓冲区，
+// 块写满或定期交给后台线程写文件，事件循环只在交块时短暂加锁，从不等待磁盘
+// 后台线程跟不上、排队超过上限时丢弃整块并计数，不阻塞事件循环
+// 文件格式见traffic_trace.h，回放用main_pressure --replay
+class TrafficRecorder {
+public:
+    static const size_t kChunkBytes = 256 * 1024;   // 事件循环攒满该大小后交块
+
+    TrafficRecorder(const std::string& path, bool payloads, size_t max_queued_bytes = 64 * 1024 * 1024);
+    ~TrafficRecorder();
+
+    bool start();   // 创建文件、写入文件头并启动写线程
+    void stop();    // 写完已交的块，回填记录数后关闭文件；须在所有事件循环退出后调用
+
+    bool payloads() const { return payloads_; }
+    int64_t startNs() const { return start_ns_; }
+    uint32_t newConnection() { return next_connection_.fetch_add(1, std::memory_order_relaxed); }
+
+    // 追加一条记录到调用者的块缓冲区
+    void append(std::vector<char>& chunk, int64_t now_ns, uint32_t connection,
+                const char* payload, uint32_t length) const;
+    // 交出块缓冲区中的records条记录，chunk换成一个空的回收缓冲区
+    void submit(std::vector<char>& chunk, uint64_t records);
+
+    uint64_t records() const { return records_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t bytesWritten() const { return bytes_written_.load(std::memory_order_relaxed); }
+
+private:
+    struct Chunk {
+        std::vector<char> data;
+        uint64_t records;
+    };
+
+    void run();
+    bool writeAll(const char* data, size_t length);
+
+private:
+    std::string path_;
+    bool payloads_;
+    size_t max_queued_bytes_;
+    int fd_;
+    int64_t start_ns_;
+    std::atomic<uint32_t> next_connection_;
+    std::mutex mutex_;                      // 保护以下队列
+    std::condition_variable cv_;
+    std::deque<Chunk> queue_;               // 待写入的块
+    size_t queued_bytes_;
+    std::vector<std::vector<char>> free_;   // 写完回收的缓冲区
+    bool stopping_;
+    std::atomic<uint64_t> records_;         // 已写入的记录数
+    std::atomic<uint64_t> dropped_;         // 因排队超限丢弃的记录数
+    std::atomic<uint64_t> bytes_written_;
+    std::thread thread_;
+};
+
+#endif // TRAFFIC_RECORDER_H
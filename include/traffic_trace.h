@@ -0,0 +1,47 @@
+#ifndef TRAFFIC_TRACE_H
+#define TRAFFIC_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 流量录制文件格式，服务器录制、压测工具回放共用
+// 文件头之后是连续的记录，每条记录后可跟载荷(按8字节对齐补齐)，整个文件可直接mmap后顺序遍历
+// 字段均为主机字节序，录制和回放须在同一字节序的机器上
+// 多个worker各自成块写入，记录在文件中只按块有序，回放前须按时间排序
+const char kTraceMagic[8] = {'E', 'C', 'H', 'O', 'T', 'R', 'C', '1'};
+const uint32_t kTraceVersion = 1;
+const uint32_t kTraceHasPayloads = 1;   // 记录后跟报文载荷
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t records;               // 记录数，录制结束时回填
+    uint64_t connections;           // 连接编号上限，录制结束时回填
+};
+
+// 一个完整的请求报文
+struct TraceRecord {
+    uint64_t time_ns;               // 相对录制开始的时间
+    uint32_t connection;            // 录制期间分配的连接编号，不随fd复用
+    uint32_t length;                // 载荷长度(不含长度字段)
+};
+
+static_assert(sizeof(TraceFileHeader) == 32, "trace header layout");
+static_assert(sizeof(TraceRecord) == 16, "trace record layout");
+
+// 记录连同载荷在文件中占用的字节数
+inline size_t traceRecordSize(const TraceRecord& record, uint32_t flags) {
+    size_t size = sizeof(TraceRecord);
+    if (flags & kTraceHasPayloads) {
+        size += (static_cast<size_t>(record.length) + 7) & ~static_cast<size_t>(7);
+    }
+    return size;
+}
+
+inline bool validTraceHeader(const TraceFileHeader& header) {
+    return memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) == 0 && header.version == kTraceVersion;
+}
+
+#endif // TRAFFIC_TRACE_H
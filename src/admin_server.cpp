@@ -0,0 +1,353 @@
+#include "../include/admin_server.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+// 等待事件循环完成连接快照的最长时间
+static const int kSnapshotTimeoutMs = 2000;
+
+AdminServer::AdminServer(const std::string& path, const std::vector<EpollServer*>& servers, ServerTunables& tunables)
+    : path_(path), servers_(servers), tunables_(tunables), listen_fd_(-1), running_(false) {
+}
+
+AdminServer::~AdminServer() {
+    stop();
+}
+
+bool AdminServer::start() {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path_.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Admin socket path too long: " << path_ << std::endl;
+        return false;
+    }
+    strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ == -1) {
+        std::cerr << "Create admin socket failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    // 上次异常退出遗留的套接字文件
+    unlink(path_.c_str());
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        std::cerr << "Bind admin socket failed: " << strerror(errno) << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    if (listen(listen_fd_, 4) == -1) {
+        std::cerr << "Listen on admin socket failed: " << strerror(errno) << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        unlink(path_.c_str());
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&AdminServer::run, this);
+    std::cout << "Admin socket listening on " << path_ << std::endl;
+    return true;
+}
+
+void AdminServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ != -1) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+        unlink(path_.c_str());
+    }
+}
+
+void AdminServer::run() {
+    // 一次服务一个管理连接，轮询超时用于检查退出
+    while (running_) {
+        struct pollfd pfd;
+        pfd.fd = listen_fd_;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd == -1) {
+            continue;
+        }
+        serveClient(fd);
+        close(fd);
+    }
+}
+
+void AdminServer::serveClient(int fd) {
+    std::string buffer;
+    char chunk[1024];
+    while (running_) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        int ret = poll(&pfd, 1, 200);
+        if (ret == 0) {
+            continue;
+        }
+        if (ret < 0) {
+            return;
+        }
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return;
+        }
+        buffer.append(chunk, received);
+
+        size_t newline;
+        while ((newline = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line == "quit") {
+                return;
+            }
+            std::string response = execute(line);
+            size_t offset = 0;
+            while (offset < response.size()) {
+                ssize_t sent = send(fd, response.data() + offset, response.size() - offset, MSG_NOSIGNAL);
+                if (sent <= 0) {
+                    return;
+                }
+                offset += sent;
+            }
+        }
+        if (buffer.size() > 4096) {
+            return;     // 不是按行的命令
+        }
+    }
+}
+
+std::string AdminServer::execute(const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+    if (command.empty()) {
+        return "";
+    }
+    if (command == "stats") {
+        return statsCommand();
+    }
+    if (command == "connections") {
+        size_t limit = 100;
+        in >> limit;
+        return connectionsCommand(limit);
+    }
+    if (command == "get") {
+        return tunablesCommand();
+    }
+    if (command == "set") {
+        std::string name;
+        std::string value;
+        in >> name >> value;
+        return setCommand(name, value);
+    }
+    if (command == "help") {
+        return "stats | connections [N] | get | set NAME VALUE | quit\n"
+               "set names: max-connections, idle-timeout (ms), budget-msgs, budget-bytes, "
+               "log-level (error|warn|info|debug)\n";
+    }
+    return "ERR unknown command: " + command + "\n";
+}
+
+std::string AdminServer::statsCommand() {
+    std::ostringstream out;
+    uint64_t total_rounds = 0;
+    uint64_t total_events = 0;
+    for (size_t i = 0; i < servers_.size(); ++i) {
+        const ServerStats& stats = servers_[i]->stats();
+        uint64_t rounds = stats.loop_rounds.load(std::memory_order_relaxed);
+        uint64_t events = stats.events_handled.load(std::memory_order_relaxed);
+        uint64_t accepted = stats.accepted_connections.load(std::memory_order_relaxed);
+        uint64_t closed = stats.closed_connections.load(std::memory_order_relaxed);
+        uint64_t spin_rounds = stats.spin_rounds.load(std::memory_order_relaxed);
+        total_rounds += rounds;
+        total_events += events;
+        out << "worker " << i
+            << " rounds=" << rounds
+            << " events=" << events
+            << " events_per_round=" << std::fixed << std::setprecision(2)
+            << (rounds > 0 ? static_cast<double>(events) / rounds : 0.0)
+            << " accepted=" << accepted
+            << " closed=" << closed
+            << " active=" << accepted - closed
+            << " accept_errors=" << stats.accept_errors.load(std::memory_order_relaxed)
+            << " checksum_errors=" << stats.checksum_errors.load(std::memory_order_relaxed)
+            << " idle_closed=" << stats.idle_closed.load(std::memory_order_relaxed)
+            << " budget_deferrals=" << stats.budget_deferrals.load(std::memory_order_relaxed)
+            << " reads_paused=" << stats.reads_paused.load(std::memory_order_relaxed)
+            << " rejected_connections=" << stats.rejected_connections.load(std::memory_order_relaxed)
+            << " rejected_frames=" << stats.rejected_frames.load(std::memory_order_relaxed)
+            << " spin_rounds=" << spin_rounds
+            << " spin_hits=" << stats.spin_hits.load(std::memory_order_relaxed)
+            << " spin_ms=" << stats.spin_ns.load(std::memory_order_relaxed) / 1000000;
+        if (stats.published.load(std::memory_order_relaxed) > 0) {
+            out << " published=" << stats.published.load(std::memory_order_relaxed)
+                << " delivered=" << stats.delivered.load(std::memory_order_relaxed)
+                << " dropped=" << stats.dropped.load(std::memory_order_relaxed)
+                << " slow_disconnects=" << stats.slow_disconnects.load(std::memory_order_relaxed);
+        }
+        out << "\n";
+        const PhaseProfiler& profiler = servers_[i]->profiler();
+        if (profiler.enabled()) {
+            double ticks_per_ns = PhaseProfiler::ticksPerNs();
+            out << "worker " << i << " phases";
+            for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+                const PhaseProfiler::PhaseStats& stats = profiler.stats(phase);
+                uint64_t samples = stats.samples.load(std::memory_order_relaxed);
+                out << " " << loopPhaseName(phase) << "_samples=" << samples
+                    << " " << loopPhaseName(phase) << "_avg_ns="
+                    << static_cast<uint64_t>(samples > 0 ? stats.ticks.load(std::memory_order_relaxed) /
+                                                               ticks_per_ns / samples : 0)
+                    << " " << loopPhaseName(phase) << "_max_ns="
+                    << static_cast<uint64_t>(stats.max_ticks.load(std::memory_order_relaxed) / ticks_per_ns);
+            }
+            out << "\n";
+        }
+        // 开启心跳时输出轮耗时和批大小直方图的非空桶，桶下界为2的幂
+        const LoopHeartbeat& heartbeat = servers_[i]->heartbeat();
+        if (heartbeat.batch_events.count() > 0) {
+            out << "worker " << i << " loop_p50_ns=" << heartbeat.iteration_ns.percentile(50)
+                << " loop_p99_ns=" << heartbeat.iteration_ns.percentile(99)
+                << " loop_max_ns=" << heartbeat.iteration_ns.max()
+                << " batch_p50=" << heartbeat.batch_events.percentile(50)
+                << " batch_p99=" << heartbeat.batch_events.percentile(99)
+                << " batch_max=" << heartbeat.batch_events.max() << "\n";
+            out << "worker " << i << " loop_ns_hist";
+            for (int bucket = 0; bucket < Log2Histogram::kBuckets; ++bucket) {
+                if (heartbeat.iteration_ns.bucket(bucket) > 0) {
+                    out << " " << (bucket == 0 ? 0 : 1ULL << bucket) << ":" << heartbeat.iteration_ns.bucket(bucket);
+                }
+            }
+            out << "\n";
+            out << "worker " << i << " batch_hist";
+            for (int bucket = 0; bucket < Log2Histogram::kBuckets; ++bucket) {
+                if (heartbeat.batch_events.bucket(bucket) > 0) {
+                    out << " " << (bucket == 0 ? 0 : 1ULL << bucket) << ":" << heartbeat.batch_events.bucket(bucket);
+                }
+            }
+            out << "\n";
+        }
+    }
+
+    // 所有worker共享内存记账和键值存储
+    const MemoryBudget& memory = servers_.front()->memoryBudget();
+    out << "memory used=" << memory.used() << " peak=" << memory.peak()
+        << " soft=" << memory.softLimit() << " hard=" << memory.hardLimit()
+        << " connections=" << memory.connections() << "\n";
+    const KvStore& kv = servers_.front()->kvStore();
+    uint64_t kv_ops = 0;
+    for (int i = 0; i < kv.shardCount(); ++i) {
+        const KvShardStats& shard = kv.shard(i).stats();
+        kv_ops += shard.gets.load(std::memory_order_relaxed) + shard.sets.load(std::memory_order_relaxed) +
+                  shard.deletes.load(std::memory_order_relaxed);
+    }
+    if (kv_ops > 0) {
+        for (int i = 0; i < kv.shardCount(); ++i) {
+            const KvShardStats& shard = kv.shard(i).stats();
+            out << "kv shard " << i
+                << " gets=" << shard.gets.load(std::memory_order_relaxed)
+                << " hits=" << shard.hits.load(std::memory_order_relaxed)
+                << " sets=" << shard.sets.load(std::memory_order_relaxed)
+                << " deletes=" << shard.deletes.load(std::memory_order_relaxed)
+                << " items=" << shard.items.load(std::memory_order_relaxed)
+                << " evictions=" << shard.evictions.load(std::memory_order_relaxed)
+                << " set_failures=" << shard.set_failures.load(std::memory_order_relaxed)
+                << " slab_bytes=" << shard.memory_bytes.load(std::memory_order_relaxed) << "\n";
+        }
+    }
+    out << "total rounds=" << total_rounds << " events=" << total_events << "\n";
+    return out.str();
+}
+
+std::string AdminServer::connectionsCommand(size_t limit) {
+    std::ostringstream out;
+    out << std::left << std::setw(8) << "worker" << std::setw(8) << "fd" << std::setw(24) << "peer"
+        << std::right << std::setw(14) << "bytes_in" << std::setw(14) << "bytes_out"
+        << std::setw(12) << "messages" << std::setw(10) << "buffered" << std::setw(10) << "idle_ms"
+        << std::setw(10) << "rtt_us" << std::setw(10) << "rttvar" << std::setw(8) << "cwnd"
+        << std::setw(8) << "retrans" << "\n";
+    size_t listed = 0;
+    size_t total = 0;
+    for (size_t i = 0; i < servers_.size(); ++i) {
+        std::vector<ConnectionInfo> connections;
+        if (!servers_[i]->listConnections(connections, kSnapshotTimeoutMs)) {
+            out << "worker " << i << ": event loop did not respond\n";
+            continue;
+        }
+        total += connections.size();
+        for (const ConnectionInfo& info : connections) {
+            if (listed >= limit) {
+                break;
+            }
+            listed++;
+            out << std::left << std::setw(8) << i << std::setw(8) << info.fd << std::setw(24) << info.peer
+                << std::right << std::setw(14) << info.bytes_received << std::setw(14) << info.bytes_sent
+                << std::setw(12) << info.messages << std::setw(10) << info.buffered
+                << std::setw(10) << info.idle_ms << std::setw(10) << info.rtt_us
+                << std::setw(10) << info.rtt_var_us << std::setw(8) << info.snd_cwnd
+                << std::setw(8) << info.total_retrans << (info.paused ? "  paused" : "") << "\n";
+        }
+    }
+    out << listed << " of " << total << " connections listed\n";
+    return out.str();
+}
+
+std::string AdminServer::tunablesCommand() {
+    std::ostringstream out;
+    out << "max-connections " << tunables_.max_connections.load(std::memory_order_relaxed) << "\n"
+        << "idle-timeout " << tunables_.idle_timeout_ms.load(std::memory_order_relaxed) << "\n"
+        << "budget-msgs " << tunables_.budget_messages.load(std::memory_order_relaxed) << "\n"
+        << "budget-bytes " << tunables_.budget_bytes.load(std::memory_order_relaxed) << "\n"
+        << "log-level " << logLevelName(tunables_.log_level.load(std::memory_order_relaxed)) << "\n";
+    return out.str();
+}
+
+std::string AdminServer::setCommand(const std::string& name, const std::string& value) {
+    if (name == "log-level") {
+        LogLevel level;
+        if (!parseLogLevel(value, level)) {
+            return "ERR log level must be error, warn, info or debug\n";
+        }
+        tunables_.log_level.store(level, std::memory_order_relaxed);
+        return "OK\n";
+    }
+
+    char* end = nullptr;
+    long number = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number < 0 || number > 0x7fffffff) {
+        return "ERR value must be a non-negative integer\n";
+    }
+    if (name == "max-connections") {
+        tunables_.max_connections.store(static_cast<int>(number), std::memory_order_relaxed);
+    } else if (name == "idle-timeout") {
+        tunables_.idle_timeout_ms.store(static_cast<int>(number), std::memory_order_relaxed);
+        // 事件循环可能正阻塞在较长的epoll_wait中，唤醒后按新超时计算等待时间
+        for (EpollServer* server : servers_) {
+            server->wakeup();
+        }
+    } else if (name == "budget-msgs") {
+        tunables_.budget_messages.store(static_cast<int>(number), std::memory_order_relaxed);
+    } else if (name == "budget-bytes") {
+        tunables_.budget_bytes.store(static_cast<int>(number), std::memory_order_relaxed);
+    } else {
+        return "ERR unknown setting: " + name + "\n";
+    }
+    return "OK\n";
+}
@@ -1,4 +1,5 @@
 #include "../include/client.h"
+#include "../include/frame.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -10,7 +11,7 @@
 #include <fcntl.h>
 
 Client::Client(const std::string &ip, int port) 
-    : sockfd(-1), server_ip(ip), server_port(port), connected(false) {
+    : sockfd(-1), server_ip(ip), server_port(port), connected(false), verbose(true) {
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(port);
@@ -87,7 +88,9 @@ int Client::sendRequest(const std::string &request) {
         return -1;
     }
 
-    std::cout << "Sent request: " << request << " (" << request.length() << " bytes)" << std::endl;
+    if (verbose) {
+        std::cout << "Sent request: " << request << " (" << request.length() << " bytes)" << std::endl;
+    }
 
     return len;
 }
@@ -102,23 +105,17 @@ int Client::receiveResponse(){
         return -1;
     }
     
-    std::cout << "Received response: " << response << " (" << response.length() << " bytes)" << std::endl;
+    if (verbose) {
+        std::cout << "Received response: " << response << " (" << response.length() << " bytes)" << std::endl;
+    }
     return len;
 }
 
 int Client::sendCompleteMessage(const std::string& message) {
-    // 计算整个结构体的大小
-    size_t total_size = sizeof(int) + message.length();
-    
-    // 分配内存来构建完整的结构体
-    std::vector<char> buffer(total_size);
-    
-    // 设置长度字段（网络字节序）
-    int msg_length = htonl(message.length());
-    memcpy(buffer.data(), &msg_length, sizeof(msg_length));
-    
-    // 拷贝数据内容
-    memcpy(buffer.data() + sizeof(msg_length), message.data(), message.length());
+    // 构建完整报文: 长度字段 + 数据
+    std::vector<char> buffer;
+    buildFrame(message, buffer);
+    size_t total_size = buffer.size();
     
     // 一次性发送整个结构体
     ssize_t bytes_sent = send(sockfd, buffer.data(), total_size, 0);
@@ -180,4 +177,8 @@ int Client::receiveCompleteMessage(std::string& message) {
 
 bool Client::isConnected() const {
     return connected;
+}
+
+void Client::setVerbose(bool verbose) {
+    this->verbose = verbose;
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "../include/crc32c.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM 1
+#endif
+
+static const uint32_t kPolynomial = 0x82F63B78;    // CRC32C反射多项式
+
+// slicing-by-8查表: table[k][b]为字节b后再跟k个零字节的CRC
+struct Crc32cTable {
+    uint32_t table[8][256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (kPolynomial & (0 - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+static const Crc32cTable& crcTable() {
+    static const Crc32cTable table;
+    return table;
+}
+
+static uint32_t updateSoftware(const uint8_t* p, size_t length, uint32_t crc) {
+    const uint32_t (*t)[256] = crcTable().table;
+    while (length >= 8) {
+        uint32_t low;
+        uint32_t high;
+        memcpy(&low, p, sizeof(low));
+        memcpy(&high, p + 4, sizeof(high));
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^
+              t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^
+              t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(CRC32C_X86)
+__attribute__((target("sse4.2")))
+static uint32_t updateHardware(const uint8_t* p, size_t length, uint32_t crc) {
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+        p += 8;
+        length -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (length--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+
+static bool detectHardware() {
+    return __builtin_cpu_supports("sse4.2");
+}
+#elif defined(CRC32C_ARM)
+static uint32_t updateHardware(const uint8_t* p, size_t length, uint32_t crc) {
+    while (length >= 8) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        crc = __crc32cd(crc, value);
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = __crc32cb(crc, *p++);
+    }
+    return crc;
+}
+
+static bool detectHardware() {
+    return true;
+}
+#else
+static uint32_t updateHardware(const uint8_t* p, size_t length, uint32_t crc) {
+    return updateSoftware(p, length, crc);
+}
+
+static bool detectHardware() {
+    return false;
+}
+#endif
+
+typedef uint32_t (*UpdateFunction)(const uint8_t*, size_t, uint32_t);
+
+// 首次调用时选定实现
+static UpdateFunction selectUpdate() {
+    static const UpdateFunction update = detectHardware() ? updateHardware : updateSoftware;
+    return update;
+}
+
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    return ~selectUpdate()(static_cast<const uint8_t*>(data), length, ~crc);
+}
+
+uint32_t crc32cSoftware(const void* data, size_t length, uint32_t crc) {
+    return ~updateSoftware(static_cast<const uint8_t*>(data), length, ~crc);
+}
+
+bool crc32cHardwareAvailable() {
+    return detectHardware();
+}
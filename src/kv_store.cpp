@@ -0,0 +1,257 @@
+#include "../include/kv_store.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+// slab页大小，也是单个数据项(头部+键+值)的上限
+static const size_t kPageSize = 1024 * 1024;
+// 最小块大小与相邻级别的增长系数
+static const size_t kMinChunkSize = 64;
+static const double kGrowthFactor = 1.25;
+static const size_t kInitialSlots = 1024;
+
+KvShard::KvShard(size_t memory_limit)
+    : memory_limit_(std::max(memory_limit, kPageSize)), pages_allocated_(0),
+      slots_(kInitialSlots), mask_(kInitialSlots - 1), count_(0) {
+    // 块大小按8字节对齐，最后一级正好是一页
+    size_t size = kMinChunkSize;
+    while (size < kPageSize) {
+        SlabClass slab_class;
+        slab_class.chunk_size = size;
+        slab_class.chunks_per_page = kPageSize / size;
+        classes_.push_back(std::move(slab_class));
+        size = std::max(size + 8, static_cast<size_t>(size * kGrowthFactor) & ~static_cast<size_t>(7));
+    }
+    SlabClass largest;
+    largest.chunk_size = kPageSize;
+    largest.chunks_per_page = 1;
+    classes_.push_back(std::move(largest));
+}
+
+KvShard::~KvShard() {
+    for (auto& slab_class : classes_) {
+        for (char* page : slab_class.pages) {
+            free(page);
+        }
+    }
+}
+
+bool KvShard::get(uint64_t hash, std::string_view key, std::string_view& value) {
+    stats_.gets.fetch_add(1, std::memory_order_relaxed);
+    long index = findSlot(hash, key);
+    if (index < 0) {
+        return false;
+    }
+    KvItem* item = slots_[index].item;
+    item->referenced = true;
+    value = std::string_view(item->data + item->key_length, item->value_length);
+    stats_.hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool KvShard::set(uint64_t hash, std::string_view key, std::string_view value) {
+    stats_.sets.fetch_add(1, std::memory_order_relaxed);
+
+    // 先删除旧值再分配，避免分配时淘汰到正在替换的数据项
+    long index = findSlot(hash, key);
+    if (index >= 0) {
+        KvItem* old_item = slots_[index].item;
+        eraseSlot(index);
+        release(old_item);
+    }
+
+    KvItem* item = allocate(sizeof(KvItem) + key.size() + value.size());
+    if (item == nullptr) {
+        stats_.set_failures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    item->hash = hash;
+    item->key_length = static_cast<uint32_t>(key.size());
+    item->value_length = static_cast<uint32_t>(value.size());
+    item->referenced = false;
+    memcpy(item->data, key.data(), key.size());
+    memcpy(item->data + key.size(), value.data(), value.size());
+    insertSlot(hash, item);
+    return true;
+}
+
+bool KvShard::del(uint64_t hash, std::string_view key) {
+    stats_.deletes.fetch_add(1, std::memory_order_relaxed);
+    long index = findSlot(hash, key);
+    if (index < 0) {
+        return false;
+    }
+    KvItem* item = slots_[index].item;
+    eraseSlot(index);
+    release(item);
+    return true;
+}
+
+int KvShard::classFor(size_t size) const {
+    auto it = std::lower_bound(classes_.begin(), classes_.end(), size,
+                               [](const SlabClass& slab_class, size_t s) { return slab_class.chunk_size < s; });
+    if (it == classes_.end()) {
+        return -1;
+    }
+    return static_cast<int>(it - classes_.begin());
+}
+
+KvItem* KvShard::allocate(size_t size) {
+    int class_index = classFor(size);
+    if (class_index < 0) {
+        return nullptr;
+    }
+    SlabClass& slab_class = classes_[class_index];
+
+    if (slab_class.free_chunks.empty() && (pages_allocated_ + 1) * kPageSize <= memory_limit_) {
+        // 申请新页并切成定长块
+        char* page = static_cast<char*>(malloc(kPageSize));
+        if (page != nullptr) {
+            slab_class.pages.push_back(page);
+            pages_allocated_++;
+            stats_.memory_bytes.store(pages_allocated_ * kPageSize, std::memory_order_relaxed);
+            for (size_t i = slab_class.chunks_per_page; i > 0; --i) {
+                KvItem* chunk = reinterpret_cast<KvItem*>(page + (i - 1) * slab_class.chunk_size);
+                chunk->in_use = false;
+                chunk->size_class = static_cast<uint8_t>(class_index);
+                slab_class.free_chunks.push_back(chunk);
+            }
+        }
+    }
+
+    KvItem* item = nullptr;
+    if (!slab_class.free_chunks.empty()) {
+        item = slab_class.free_chunks.back();
+        slab_class.free_chunks.pop_back();
+    } else {
+        // 内存已到上限: 在同一大小级别内淘汰，不在级别之间移动页
+        item = evict(slab_class);
+        if (item == nullptr) {
+            return nullptr;
+        }
+    }
+    item->in_use = true;
+    item->size_class = static_cast<uint8_t>(class_index);
+    stats_.items.fetch_add(1, std::memory_order_relaxed);
+    return item;
+}
+
+KvItem* KvShard::evict(SlabClass& slab_class) {
+    size_t total = slab_class.pages.size() * slab_class.chunks_per_page;
+    if (total == 0) {
+        return nullptr;
+    }
+    // CLOCK: 访问位为1的给第二次机会，最多转两圈必然找到
+    for (size_t scanned = 0; scanned < 2 * total; ++scanned) {
+        KvItem* item = chunkAt(slab_class, slab_class.clock_hand);
+        slab_class.clock_hand = (slab_class.clock_hand + 1) % total;
+        if (!item->in_use) {
+            continue;
+        }
+        if (item->referenced) {
+            item->referenced = false;
+            continue;
+        }
+        eraseItem(item);
+        item->in_use = false;
+        stats_.items.fetch_sub(1, std::memory_order_relaxed);
+        stats_.evictions.fetch_add(1, std::memory_order_relaxed);
+        return item;
+    }
+    return nullptr;
+}
+
+void KvShard::release(KvItem* item) {
+    item->in_use = false;
+    classes_[item->size_class].free_chunks.push_back(item);
+    stats_.items.fetch_sub(1, std::memory_order_relaxed);
+}
+
+KvItem* KvShard::chunkAt(const SlabClass& slab_class, size_t index) const {
+    char* page = slab_class.pages[index / slab_class.chunks_per_page];
+    return reinterpret_cast<KvItem*>(page + (index % slab_class.chunks_per_page) * slab_class.chunk_size);
+}
+
+long KvShard::findSlot(uint64_t hash, std::string_view key) const {
+    size_t index = hash & mask_;
+    while (slots_[index].item != nullptr) {
+        const Slot& slot = slots_[index];
+        if (slot.hash == hash && slot.item->key_length == key.size() &&
+            memcmp(slot.item->data, key.data(), key.size()) == 0) {
+            return static_cast<long>(index);
+        }
+        index = (index + 1) & mask_;
+    }
+    return -1;
+}
+
+void KvShard::insertSlot(uint64_t hash, KvItem* item) {
+    // 负载因子超过0.7时扩容
+    if ((count_ + 1) * 10 > slots_.size() * 7) {
+        grow();
+    }
+    size_t index = hash & mask_;
+    while (slots_[index].item != nullptr) {
+        index = (index + 1) & mask_;
+    }
+    slots_[index].hash = hash;
+    slots_[index].item = item;
+    count_++;
+}
+
+void KvShard::eraseSlot(size_t index) {
+    // 把后面探测链上的项前移填补空位，保证查找遇到空槽即可停止
+    size_t hole = index;
+    size_t next = index;
+    while (true) {
+        next = (next + 1) & mask_;
+        if (slots_[next].item == nullptr) {
+            break;
+        }
+        size_t home = slots_[next].hash & mask_;
+        // home在(hole, next]之间(循环意义下)时该项不能前移
+        bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (stays) {
+            continue;
+        }
+        slots_[hole] = slots_[next];
+        hole = next;
+    }
+    slots_[hole] = Slot();
+    count_--;
+}
+
+void KvShard::eraseItem(KvItem* item) {
+    size_t index = item->hash & mask_;
+    while (slots_[index].item != nullptr) {
+        if (slots_[index].item == item) {
+            eraseSlot(index);
+            return;
+        }
+        index = (index + 1) & mask_;
+    }
+}
+
+void KvShard::grow() {
+    std::vector<Slot> old_slots(slots_.size() * 2);
+    old_slots.swap(slots_);
+    mask_ = slots_.size() - 1;
+    count_ = 0;
+    for (const Slot& slot : old_slots) {
+        if (slot.item != nullptr) {
+            insertSlot(slot.hash, slot.item);
+        }
+    }
+}
+
+KvStore::KvStore(int shards, size_t memory_limit) {
+    shards = std::max(shards, 1);
+    for (int i = 0; i < shards; ++i) {
+        shards_.emplace_back(new KvShard(memory_limit / shards));
+    }
+}
+
+uint64_t KvStore::hashKey(std::string_view key) {
+    return std::hash<std::string_view>()(key);
+}
@@ -0,0 +1,126 @@
+#include "../include/latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram(int64_t max_value, int precision_bits)
+    : max_value_(max_value), precision_bits_(precision_bits),
+      sub_bucket_count_(1 << precision_bits), sub_bucket_half_(1 << (precision_bits - 1)),
+      total_count_(0), min_(std::numeric_limits<int64_t>::max()), max_(0), sum_(0) {
+    counts_.assign(bucketIndex(max_value_) + 1, 0);
+}
+
+int LatencyHistogram::bucketIndex(int64_t value) const {
+    if (value < sub_bucket_count_) {
+        return static_cast<int>(value);
+    }
+    // 最高位决定所在的2的幂区间，区间内再取precision_bits位作为子桶
+    int msb = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+    int shift = msb - (precision_bits_ - 1);
+    int sub = static_cast<int>(value >> shift);
+    return sub_bucket_count_ + (shift - 1) * sub_bucket_half_ + (sub - sub_bucket_half_);
+}
+
+int64_t LatencyHistogram::highestEquivalentValue(int index) const {
+    if (index < sub_bucket_count_) {
+        return index;
+    }
+    int offset = index - sub_bucket_count_;
+    int shift = offset / sub_bucket_half_ + 1;
+    int64_t sub = offset % sub_bucket_half_ + sub_bucket_half_;
+    return (sub << shift) + (1LL << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t value) {
+    if (value < 0) {
+        value = 0;
+    } else if (value > max_value_) {
+        value = max_value_;
+    }
+    counts_[bucketIndex(value)]++;
+    total_count_++;
+    sum_ += value;
+    if (value < min_) {
+        min_ = value;
+    }
+    if (value > max_) {
+        max_ = value;
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    size_t n = std::min(counts_.size(), other.counts_.size());
+    for (size_t i = 0; i < n; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    // 对方范围更大时，超出部分计入最后一个桶
+    for (size_t i = n; i < other.counts_.size(); ++i) {
+        counts_.back() += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    sum_ += other.sum_;
+    if (other.total_count_ > 0) {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, std::min(other.max_, max_value_));
+    }
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_count_ = 0;
+    min_ = std::numeric_limits<int64_t>::max();
+    max_ = 0;
+    sum_ = 0;
+}
+
+void LatencyHistogram::appendTo(std::vector<char>& out) const {
+    appendPod(out, max_value_);
+    appendPod(out, precision_bits_);
+    appendPod(out, total_count_);
+    appendPod(out, min_);
+    appendPod(out, max_);
+    appendPod(out, sum_);
+    const char* bytes = reinterpret_cast<const char*>(counts_.data());
+    out.insert(out.end(), bytes, bytes + counts_.size() * sizeof(uint64_t));
+}
+
+bool LatencyHistogram::readFrom(const char*& data, const char* end) {
+    int64_t max_value;
+    int precision_bits;
+    if (!readPod(data, end, max_value) || !readPod(data, end, precision_bits) ||
+        max_value != max_value_ || precision_bits != precision_bits_) {
+        return false;
+    }
+    size_t counts_bytes = counts_.size() * sizeof(uint64_t);
+    if (!readPod(data, end, total_count_) || !readPod(data, end, min_) || !readPod(data, end, max_) ||
+        !readPod(data, end, sum_) || static_cast<size_t>(end - data) < counts_bytes) {
+        reset();
+        return false;
+    }
+    memcpy(counts_.data(), data, counts_bytes);
+    data += counts_bytes;
+    return true;
+}
+
+double LatencyHistogram::mean() const {
+    return total_count_ > 0 ? sum_ / total_count_ : 0;
+}
+
+int64_t LatencyHistogram::percentile(double p) const {
+    if (total_count_ == 0) {
+        return 0;
+    }
+    p = std::min(std::max(p, 0.0), 100.0);
+    // 至少需要覆盖的记录数(向上取整，至少为1)
+    int64_t target = static_cast<int64_t>(std::ceil(p / 100.0 * total_count_));
+    target = std::max<int64_t>(target, 1);
+
+    int64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(highestEquivalentValue(static_cast<int>(i)), max_);
+        }
+    }
+    return max_;
+}
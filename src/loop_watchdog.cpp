@@ -0,0 +1,56 @@
+#include "../include/loop_watchdog.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+LoopWatchdog::LoopWatchdog(const std::vector<EpollServer*>& servers, int threshold_ms)
+    : servers_(servers), threshold_ns_(std::max(threshold_ms, 1) * 1000000LL),
+      reported_(servers.size(), 0), stalls_(0), running_(false) {
+}
+
+LoopWatchdog::~LoopWatchdog() {
+    stop();
+}
+
+void LoopWatchdog::start() {
+    running_ = true;
+    thread_ = std::thread(&LoopWatchdog::run, this);
+}
+
+void LoopWatchdog::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void LoopWatchdog::run() {
+    // 检查间隔取阈值的1/4，卡顿在超过阈值后最多再过1/4阈值被发现
+    auto interval = std::chrono::nanoseconds(std::max<int64_t>(threshold_ns_ / 4, 1000000));
+    while (running_) {
+        std::this_thread::sleep_for(interval);
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        for (size_t i = 0; i < servers_.size(); ++i) {
+            const LoopHeartbeat& heartbeat = servers_[i]->heartbeat();
+            int64_t start = heartbeat.iteration_start_ns.load(std::memory_order_acquire);
+            if (start == 0 || now - start < threshold_ns_) {
+                continue;
+            }
+            uint64_t iteration = heartbeat.iteration.load(std::memory_order_relaxed);
+            if (iteration == reported_[i]) {
+                continue;
+            }
+            reported_[i] = iteration;
+            stalls_.fetch_add(1, std::memory_order_relaxed);
+            int stage = heartbeat.stage.load(std::memory_order_relaxed);
+            int fd = heartbeat.fd.load(std::memory_order_relaxed);
+            std::cerr << "[Watchdog] Event loop " << i << " stalled " << (now - start) / 1000000
+                      << " ms in " << loopStageName(stage);
+            if (fd >= 0) {
+                std::cerr << " on fd " << fd;
+            }
+            std::cerr << std::endl;
+        }
+    }
+}
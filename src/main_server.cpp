@@ -1,17 +1,239 @@
 #include "../include/server.h"
+#include "../include/admin_server.h"
+#include "../include/loop_watchdog.h"
+#include "../include/traffic_recorder.h"
+#include <sched.h>
 #include <iostream>
 #include <csignal>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
 
-EpollServer* g_server = nullptr;
+std::vector<EpollServer*> g_servers;
+std::atomic<bool> g_running{true};
 
 void signalHandler(int signal) {
     std::cout << "\nReceived signal " << signal << ", shutting down server..." << std::endl;
-    if (g_server) {
-        g_server->stop();
+    g_running = false;
+    for (EpollServer* server : g_servers) {
+        server->stop();
     }
 }
 
-int main() {
+// 每隔interval秒汇总所有worker的连接统计，输出接受速率
+void statsReporter(int interval, const LoopWatchdog* watchdog, const TrafficRecorder* recorder) {
+    uint64_t last_accepted = 0;
+    uint64_t last_closed = 0;
+    uint64_t last_published = 0;
+    uint64_t last_delivered = 0;
+    uint64_t last_kv_ops = 0;
+    auto last_time = std::chrono::steady_clock::now();
+    auto next_time = last_time + std::chrono::seconds(interval);
+    
+    while (g_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_time) {
+            continue;
+        }
+        next_time += std::chrono::seconds(interval);
+        
+        uint64_t accepted = 0;
+        uint64_t closed = 0;
+        uint64_t errors = 0;
+        uint64_t checksum_errors = 0;
+        uint64_t local = 0;
+        uint64_t remote = 0;
+        uint64_t spin_rounds = 0;
+        uint64_t spin_hits = 0;
+        uint64_t deferrals = 0;
+        uint64_t paused = 0;
+        uint64_t published = 0;
+        uint64_t delivered = 0;
+        uint64_t dropped = 0;
+        uint64_t slow_disconnects = 0;
+        uint64_t rejected = 0;
+        for (EpollServer* server : g_servers) {
+            accepted += server->stats().accepted_connections.load(std::memory_order_relaxed);
+            closed += server->stats().closed_connections.load(std::memory_order_relaxed);
+            errors += server->stats().accept_errors.load(std::memory_order_relaxed);
+            checksum_errors += server->stats().checksum_errors.load(std::memory_order_relaxed);
+            local += server->stats().local_connections.load(std::memory_order_relaxed);
+            remote += server->stats().remote_connections.load(std::memory_order_relaxed);
+            spin_rounds += server->stats().spin_rounds.load(std::memory_order_relaxed);
+            spin_hits += server->stats().spin_hits.load(std::memory_order_relaxed);
+            deferrals += server->stats().budget_deferrals.load(std::memory_order_relaxed);
+            paused += server->stats().reads_paused.load(std::memory_order_relaxed);
+            published += server->stats().published.load(std::memory_order_relaxed);
+            delivered += server->stats().delivered.load(std::memory_order_relaxed);
+            dropped += server->stats().dropped.load(std::memory_order_relaxed);
+            slow_disconnects += server->stats().slow_disconnects.load(std::memory_order_relaxed);
+            rejected += server->stats().rejected_connections.load(std::memory_order_relaxed) +
+                        server->stats().rejected_frames.load(std::memory_order_relaxed);
+        }
+        double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_time).count() / 1000.0;
+        std::cout << "[Stats] Accepted/s: " << static_cast<uint64_t>((accepted - last_accepted) / elapsed)
+                  << ", Closed/s: " << static_cast<uint64_t>((closed - last_closed) / elapsed)
+                  << ", Active: " << accepted - closed
+                  << ", Accept errors: " << errors
+                  << ", Checksum errors: " << checksum_errors;
+        if (local + remote > 0) {
+            std::cout << ", Steered locally: " << local << "/" << local + remote;
+        }
+        if (spin_rounds > 0) {
+            std::cout << ", Spin hit: " << spin_hits * 100 / spin_rounds << "% of " << spin_rounds;
+        }
+        if (deferrals > 0) {
+            std::cout << ", Budget deferrals: " << deferrals;
+        }
+        // 所有worker共享同一份内存记账
+        const MemoryBudget& memory = g_servers.front()->memoryBudget();
+        std::cout << ", Buffered: " << memory.used() / 1024 << " KB (peak " << memory.peak() / 1024 << " KB)";
+        if (paused + rejected > 0) {
+            std::cout << ", Reads paused: " << paused << ", Rejected: " << rejected;
+        }
+        if (published > 0) {
+            std::cout << ", Published/s: " << static_cast<uint64_t>((published - last_published) / elapsed)
+                      << ", Delivered/s: " << static_cast<uint64_t>((delivered - last_delivered) / elapsed)
+                      << ", Dropped: " << dropped << ", Slow disconnects: " << slow_disconnects;
+        }
+        // 所有worker共享同一个键值存储，各分片分别统计
+        const KvStore& kv = g_servers.front()->kvStore();
+        uint64_t gets = 0;
+        uint64_t hits = 0;
+        uint64_t kv_ops = 0;
+        uint64_t items = 0;
+        uint64_t evictions = 0;
+        uint64_t kv_memory = 0;
+        for (int i = 0; i < kv.shardCount(); ++i) {
+            const KvShardStats& shard = kv.shard(i).stats();
+            gets += shard.gets.load(std::memory_order_relaxed);
+            hits += shard.hits.load(std::memory_order_relaxed);
+            kv_ops += shard.gets.load(std::memory_order_relaxed) + shard.sets.load(std::memory_order_relaxed) +
+                      shard.deletes.load(std::memory_order_relaxed);
+            items += shard.items.load(std::memory_order_relaxed);
+            evictions += shard.evictions.load(std::memory_order_relaxed);
+            kv_memory += shard.memory_bytes.load(std::memory_order_relaxed);
+        }
+        if (kv_ops > 0) {
+            std::cout << ", KV ops/s: " << static_cast<uint64_t>((kv_ops - last_kv_ops) / elapsed)
+                      << ", Hit ratio: " << (gets > 0 ? hits * 100 / gets : 0) << "%"
+                      << ", Items: " << items << ", Evictions: " << evictions
+                      << ", Slab: " << kv_memory / (1024 * 1024) << " MB";
+        }
+        // 分阶段平均耗时，所有worker的采样合并
+        if (g_servers.front()->profiler().enabled()) {
+            double ticks_per_ns = PhaseProfiler::ticksPerNs();
+            std::cout << ", Phase avg ns (max us):";
+            for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+                uint64_t ticks = 0;
+                uint64_t samples = 0;
+                uint64_t max_ticks = 0;
+                for (EpollServer* server : g_servers) {
+                    const PhaseProfiler::PhaseStats& stats = server->profiler().stats(phase);
+                    ticks += stats.ticks.load(std::memory_order_relaxed);
+                    samples += stats.samples.load(std::memory_order_relaxed);
+                    max_ticks = std::max(max_ticks, stats.max_ticks.load(std::memory_order_relaxed));
+                }
+                std::cout << " " << loopPhaseName(phase) << "="
+                          << static_cast<uint64_t>(samples > 0 ? ticks / ticks_per_ns / samples : 0) << " ("
+                          << static_cast<uint64_t>(max_ticks / ticks_per_ns / 1000) << ")";
+            }
+        }
+        // 每轮耗时和批大小取各worker中最差的一个
+        if (watchdog != nullptr) {
+            uint64_t loop_p99 = 0;
+            uint64_t loop_max = 0;
+            uint64_t batch_p50 = 0;
+            uint64_t batch_p99 = 0;
+            uint64_t batch_max = 0;
+            for (EpollServer* server : g_servers) {
+                const LoopHeartbeat& heartbeat = server->heartbeat();
+                loop_p99 = std::max(loop_p99, heartbeat.iteration_ns.percentile(99));
+                loop_max = std::max(loop_max, heartbeat.iteration_ns.max());
+                batch_p50 = std::max(batch_p50, heartbeat.batch_events.percentile(50));
+                batch_p99 = std::max(batch_p99, heartbeat.batch_events.percentile(99));
+                batch_max = std::max(batch_max, heartbeat.batch_events.max());
+            }
+            std::cout << ", Loop p99/max us: " << loop_p99 / 1000 << "/" << loop_max / 1000
+                      << ", Batch p50/p99/max: " << batch_p50 << "/" << batch_p99 << "/" << batch_max
+                      << ", Stalls: " << watchdog->stalls();
+        }
+        if (recorder != nullptr) {
+            std::cout << ", Captured: " << recorder->records() << " (" << recorder->dropped() << " dropped)";
+        }
+        std::cout << std::endl;
+        last_kv_ops = kv_ops;
+        last_accepted = accepted;
+        last_closed = closed;
+        last_published = published;
+        last_delivered = delivered;
+        last_time = now;
+    }
+}
+
+// 进程允许运行的CPU(taskset或cgroup cpuset限制后的集合)，绑定到集合外的CPU会失败
+static std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        for (int cpu = 0; cpu < static_cast<int>(std::thread::hardware_concurrency()); ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -p PORT        Listen port (default: 8080)" << std::endl;
+    std::cout << "  -w WORKERS     Event loop threads sharing the port via SO_REUSEPORT (default: 1)" << std::endl;
+    std::cout << "  -e EVENTS      Max events per epoll_wait (default: 20000)" << std::endl;
+    std::cout << "  -t MS          epoll_wait timeout in milliseconds (default: 10000)" << std::endl;
+    std::cout << "  -b BACKLOG     Listen backlog (default: 128)" << std::endl;
+    std::cout << "  -i SECONDS     Print accept/close rates every SECONDS (default: 0, off)" << std::endl;
+    std::cout << "  --verify-crc   Check the CRC32C trailer of every message (main_pressure --crc)" << std::endl;
+    std::cout << "  --pin          Pin worker i to the i-th allowed CPU and steer connections to the worker on" << std::endl;
+    std::cout << "                 the CPU that received them (reuseport CBPF + SO_INCOMING_CPU)" << std::endl;
+    std::cout << "  --busy-poll US Spin on epoll for up to US microseconds before blocking (default: 0, off)" << std::endl;
+    std::cout << "  --busy-poll-budget PCT  Max share of CPU time spent spinning (default: 50)" << std::endl;
+    std::cout << "  --so-busy-poll US       Set SO_BUSY_POLL/SO_PREFER_BUSY_POLL on connections" << std::endl;
+    std::cout << "  --budget-msgs N         Max messages handled per connection per loop round (default: 0, unlimited)" << std::endl;
+    std::cout << "  --budget-bytes N        Max bytes handled per connection per loop round (default: 0, unlimited)" << std::endl;
+    std::cout << "  --mem-soft MB  Pause reads of the largest connections above MB of buffered data (default: 0, off)" << std::endl;
+    std::cout << "  --mem-hard MB  Reject new connections and large messages above MB of buffered data (default: 0, off)" << std::endl;
+    std::cout << "  --pubsub       Publish/subscribe mode instead of echo (single worker)" << std::endl;
+    std::cout << "  --slow-policy drop|disconnect|buffer  Subscribers whose socket is full (default: buffer)" << std::endl;
+    std::cout << "  --slow-queue N Messages queued per blocked subscriber with buffer policy (default: 1024)" << std::endl;
+    std::cout << "  --kv           Key-value mode: GET/SET/DEL on the framed protocol, one shard per worker" << std::endl;
+    std::cout << "  --kv-memory MB Slab memory for keys and values across all shards (default: 64)" << std::endl;
+    std::cout << "  --kv-batch N   Pipelined commands executed per shard lock (default: 64)" << std::endl;
+    std::cout << "  --max-conns N  Reject connections beyond N across all workers (default: 0, unlimited)" << std::endl;
+    std::cout << "  --idle-timeout MS       Close connections with no traffic for MS milliseconds (default: 0, off)" << std::endl;
+    std::cout << "  --log-level error|warn|info|debug  Per-connection diagnostics (default: warn)" << std::endl;
+    std::cout << "  --profile N    Sample per-phase rdtsc timings (wait/recv/framing/handler/send) every N loop rounds" << std::endl;
+    std::cout << "  --watchdog MS  Report event loop iterations that run longer than MS, with stage and fd" << std::endl;
+    std::cout << "  --capture FILE Record frame sizes and arrival times per connection for main_pressure --replay" << std::endl;
+    std::cout << "  --capture-payloads      Also record frame payloads in the capture" << std::endl;
+    std::cout << "  --admin PATH   Unix socket for live tuning and introspection (try: echo help | nc -U PATH)" << std::endl;
+    std::cout << "  --lt           Use level-triggered mode (default: edge-triggered)" << std::endl;
+    std::cout << "  --help         Show this help message" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
     // 注册信号处理
     signal(SIGINT, signalHandler);
     // signal(SIGTERM, signalHandler);
@@ -22,19 +244,225 @@ int main() {
     config.max_events = 20000;
     config.timeout_ms = 10000;
     config.use_et_mode = true;
+    int workers = 1;
+    int stats_interval = 0;
+    bool pin_workers = false;
+    int64_t memory_soft_mb = 0;
+    int64_t memory_hard_mb = 0;
+    int64_t kv_memory_mb = 64;
+    std::string admin_path;
+    int watchdog_ms = 0;
+    std::string capture_path;
+    bool capture_payloads = false;
     
-    // 创建服务器实例
-    EpollServer server(config);
-    g_server = &server;
+    // 解析命令行参数
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+        } else if (arg == "-w" && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (arg == "-e" && i + 1 < argc) {
+            config.max_events = std::atoi(argv[++i]);
+        } else if (arg == "-t" && i + 1 < argc) {
+            config.timeout_ms = std::atoi(argv[++i]);
+        } else if (arg == "-b" && i + 1 < argc) {
+            config.listen_backlog = std::atoi(argv[++i]);
+        } else if (arg == "-i" && i + 1 < argc) {
+            stats_interval = std::atoi(argv[++i]);
+        } else if (arg == "--verify-crc") {
+            config.verify_checksum = true;
+        } else if (arg == "--busy-poll" && i + 1 < argc) {
+            config.busy_poll_us = std::atoi(argv[++i]);
+        } else if (arg == "--busy-poll-budget" && i + 1 < argc) {
+            config.busy_poll_budget_percent = std::atoi(argv[++i]);
+        } else if (arg == "--so-busy-poll" && i + 1 < argc) {
+            config.socket_busy_poll_us = std::atoi(argv[++i]);
+        } else if (arg == "--budget-msgs" && i + 1 < argc) {
+            config.budget_messages = std::atoi(argv[++i]);
+        } else if (arg == "--budget-bytes" && i + 1 < argc) {
+            config.budget_bytes = std::atoi(argv[++i]);
+        } else if (arg == "--mem-soft" && i + 1 < argc) {
+            memory_soft_mb = std::atoll(argv[++i]);
+        } else if (arg == "--mem-hard" && i + 1 < argc) {
+            memory_hard_mb = std::atoll(argv[++i]);
+        } else if (arg == "--pubsub") {
+            config.mode = MODE_PUBSUB;
+        } else if (arg == "--slow-policy" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy == "drop") {
+                config.slow_policy = SLOW_DROP;
+            } else if (policy == "disconnect") {
+                config.slow_policy = SLOW_DISCONNECT;
+            } else if (policy == "buffer") {
+                config.slow_policy = SLOW_BUFFER;
+            } else {
+                std::cerr << "Unknown slow subscriber policy: " << policy << std::endl;
+                return 1;
+            }
+        } else if (arg == "--slow-queue" && i + 1 < argc) {
+            config.subscriber_queue_limit = std::atoi(argv[++i]);
+        } else if (arg == "--kv") {
+            config.mode = MODE_KV;
+        } else if (arg == "--kv-memory" && i + 1 < argc) {
+            kv_memory_mb = std::atoll(argv[++i]);
+        } else if (arg == "--kv-batch" && i + 1 < argc) {
+            config.kv_batch = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-conns" && i + 1 < argc) {
+            config.max_connections = std::atoi(argv[++i]);
+        } else if (arg == "--idle-timeout" && i + 1 < argc) {
+            config.idle_timeout_ms = std::atoi(argv[++i]);
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            if (!parseLogLevel(argv[++i], config.log_level)) {
+                std::cerr << "Unknown log level: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--profile" && i + 1 < argc) {
+            config.profile_sample_rounds = std::atoi(argv[++i]);
+        } else if (arg == "--watchdog" && i + 1 < argc) {
+            watchdog_ms = std::atoi(argv[++i]);
+            config.loop_heartbeat = watchdog_ms > 0;
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else if (arg == "--capture-payloads") {
+            capture_payloads = true;
+        } else if (arg == "--admin" && i + 1 < argc) {
+            admin_path = argv[++i];
+        } else if (arg == "--pin") {
+            pin_workers = true;
+        } else if (arg == "--lt") {
+            config.use_et_mode = false;
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (workers < 1) {
+        workers = 1;
+    }
+    // 主题表属于单个事件循环，多个worker之间不转发
+    if (config.mode == MODE_PUBSUB && workers > 1) {
+        std::cerr << "Warning: pub/sub topics are per event loop, using 1 worker" << std::endl;
+        workers = 1;
+    }
+    config.reuse_port = workers > 1;
+    
+    // 所有worker共享缓冲区内存记账，限制针对整个进程
+    MemoryBudget memory(memory_soft_mb * 1024 * 1024, memory_hard_mb * 1024 * 1024);
+    config.memory_budget = &memory;
+    
+    // 连接由内核分给任意worker，键值存储按worker数分片、所有worker共享
+    KvStore kv_store(workers, kv_memory_mb * 1024 * 1024);
+    config.kv_store = &kv_store;
     
-    // 初始化服务器
-    if (!server.initialize()) {
-        std::cerr << "Server initialization failed" << std::endl;
-        return 1;
+    // 所有worker共享运行期可调参数，管理端口修改后全部生效
+    ServerTunables tunables;
+    tunables.initialize(config);
+    config.tunables = &tunables;
+    
+    // 所有worker共享一个录制文件，由后台线程写入
+    std::unique_ptr<TrafficRecorder> recorder;
+    if (!capture_path.empty()) {
+        recorder.reset(new TrafficRecorder(capture_path, capture_payloads));
+        if (!recorder->start()) {
+            return 1;
+        }
+        config.recorder = recorder.get();
+    }
+    
+    std::vector<int> cpus;
+    if (pin_workers) {
+        cpus = allowedCpus();
+        if (workers > static_cast<int>(cpus.size())) {
+            std::cerr << "Warning: " << workers << " workers on " << cpus.size()
+                      << " allowed CPUs, only the first " << cpus.size() << " receive steered connections" << std::endl;
+        }
     }
     
-    // 运行服务器
-    server.run();
+    // 创建服务器实例，每个worker一个事件循环
+    std::vector<std::unique_ptr<EpollServer>> servers;
+    for (int i = 0; i < workers; ++i) {
+        ServerConfig worker_config = config;
+        if (pin_workers) {
+            worker_config.cpu = cpus[i % cpus.size()];
+        }
+        servers.emplace_back(new EpollServer(worker_config));
+        
+        // 初始化服务器
+        if (!servers.back()->initialize()) {
+            std::cerr << "Server initialization failed" << std::endl;
+            return 1;
+        }
+        g_servers.push_back(servers.back().get());
+    }
+    
+    // 所有worker加入reuseport组后挂载按CPU分发的程序，组内下标即worker编号
+    if (pin_workers && workers > 1) {
+        std::vector<int> steered(cpus.begin(), cpus.begin() + std::min<size_t>(workers, cpus.size()));
+        if (servers[0]->attachCpuSteering(steered)) {
+            std::cout << "Connections steered by receiving CPU across " << workers << " workers" << std::endl;
+        } else {
+            std::cerr << "Falling back to SO_INCOMING_CPU preference only" << std::endl;
+        }
+    }
+    
+    std::unique_ptr<AdminServer> admin;
+    if (!admin_path.empty()) {
+        admin.reset(new AdminServer(admin_path, g_servers, tunables));
+        if (!admin->start()) {
+            return 1;
+        }
+    }
+    
+    std::unique_ptr<LoopWatchdog> watchdog;
+    if (watchdog_ms > 0) {
+        watchdog.reset(new LoopWatchdog(g_servers, watchdog_ms));
+        watchdog->start();
+    }
+    
+    std::thread reporter;
+    if (stats_interval > 0) {
+        reporter = std::thread(statsReporter, stats_interval, watchdog.get(), recorder.get());
+    }
+    
+    // 运行服务器，第一个worker在主线程运行
+    std::vector<std::thread> threads;
+    for (int i = 1; i < workers; ++i) {
+        threads.emplace_back(&EpollServer::run, servers[i].get());
+    }
+    servers[0]->run();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    g_running = false;
+    if (reporter.joinable()) {
+        reporter.join();
+    }
+    if (admin) {
+        admin->stop();
+    }
+    if (watchdog) {
+        watchdog->stop();
+    }
+    // 事件循环退出时已交出剩余的录制块
+    if (recorder) {
+        recorder->stop();
+    }
+    
+    if (pin_workers) {
+        uint64_t local = 0;
+        uint64_t total = 0;
+        for (auto& server : servers) {
+            local += server->stats().local_connections;
+            total += server->stats().local_connections + server->stats().remote_connections;
+        }
+        std::cout << "Connections steered locally: " << local << "/" << total << std::endl;
+    }
+    g_servers.clear();
     
     return 0;
-}
\ No newline at end of file
+}
@@ -1,25 +1,75 @@
 #include "../include/server.h"
+#include "../include/frame.h"
+#include "../include/kv_protocol.h"
+#include "../include/trace.h"
+#include "../include/traffic_recorder.h"
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstring>
 #include <iostream>
 #include <cerrno>
 #include <vector>
+#include <chrono>
+#include <algorithm>
+
+// 每次recv最多读取的字节数
+static const size_t kReadChunk = 64 * 1024;
+// 缓冲区清空时容量超过此值则释放，空闲连接不长期占用大块内存
+static const size_t kRetainBufferBytes = 4096;
+
+// 清空已处理完的缓冲区，大缓冲区直接释放
+static void releaseDrained(std::vector<char>& buffer) {
+    if (buffer.capacity() > kRetainBufferBytes) {
+        std::vector<char>().swap(buffer);
+    } else {
+        buffer.clear();
+    }
+}
+
+static int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t steadyNowMs() {
+    return steadyNowNs() / 1000000;
+}
 
 EpollServer::EpollServer(const ServerConfig& config) 
-    : config_(config), listen_fd_(-1), epoll_fd_(-1), running_(false) {
+    : config_(config), listen_fd_(-1), epoll_fd_(-1), wakeup_fd_(-1), running_(false),
+      memory_(config.memory_budget != nullptr ? config.memory_budget : &own_memory_),
+      kv_(config.kv_store),
+      tunables_(config.tunables != nullptr ? config.tunables : &own_tunables_),
+      loop_time_ms_(0), last_idle_check_ms_(0), snapshot_requested_(false), snapshot_done_(false),
+      snapshot_cursor_(0), profiler_(config.profile_sample_rounds), capture_records_(0), capture_flush_ms_(0),
+      spin_window_us_(config.busy_poll_us), budget_window_start_ns_(0), budget_spent_ns_(0),
+      read_scratch_(kReadChunk) {
+    if (kv_ == nullptr) {
+        own_kv_.reset(new KvStore(1, config_.kv_memory));
+        kv_ = own_kv_.get();
+    }
+    own_tunables_.initialize(config_);
+    loop_time_ms_ = steadyNowMs();
+    last_idle_check_ms_ = loop_time_ms_;
 }
 
 EpollServer::~EpollServer() {
     stop();
+    cleanup();
 }
 
 bool EpollServer::initialize() {
-    if (!setupListenSocket()) {
+    if (config_.listen && !setupListenSocket()) {
         std::cerr << "Failed to setup listen socket" << std::endl;
         return false;
     }
@@ -30,7 +80,13 @@ bool EpollServer::initialize() {
         return false;
     }
     
-    std::cout << "Server initialized on port " << config_.port << std::endl;
+    // 在run()之前置位，保证run()开始前收到的stop()不会丢失
+    running_ = true;
+    if (config_.listen) {
+        std::cout << "Server initialized on port " << config_.port << std::endl;
+    } else {
+        std::cout << "Server initialized without listen socket" << std::endl;
+    }
     return true;
 }
 
@@ -50,6 +106,20 @@ bool EpollServer::setupListenSocket() {
         return false;
     }
     
+    // 多worker模式下每个worker独立监听同一端口
+    if (config_.reuse_port &&
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        std::cerr << "Set SO_REUSEPORT failed: " << strerror(errno) << std::endl;
+        close(listen_fd_);
+        return false;
+    }
+    
+    // 绑核时告知内核本监听套接字偏好的CPU，未挂载CBPF程序时reuseport也会优先选择它
+    if (config_.cpu >= 0 &&
+        setsockopt(listen_fd_, SOL_SOCKET, SO_INCOMING_CPU, &config_.cpu, sizeof(config_.cpu)) < 0) {
+        std::cerr << "Set SO_INCOMING_CPU failed: " << strerror(errno) << std::endl;
+    }
+    
     // 绑定地址
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
@@ -64,7 +134,7 @@ bool EpollServer::setupListenSocket() {
     }
     
     // 开始监听
-    if (listen(listen_fd_, 128) < 0) {
+    if (listen(listen_fd_, config_.listen_backlog) < 0) {
         std::cerr << "Listen failed: " << strerror(errno) << std::endl;
         close(listen_fd_);
         return false;
@@ -95,24 +165,57 @@ bool EpollServer::setupEpoll() {
     }
     
     // 添加监听socket到epoll
-    addEpollEvent(listen_fd_, EPOLLIN | (config_.use_et_mode ? EPOLLET : 0));
+    if (listen_fd_ != -1) {
+        addEpollEvent(listen_fd_, EPOLLIN | (config_.use_et_mode ? EPOLLET : 0));
+    }
+    
+    // stop()通过eventfd唤醒事件循环
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ == -1) {
+        std::cerr << "Create eventfd failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    addEpollEvent(wakeup_fd_, EPOLLIN);
     
     return true;
 }
 
 void EpollServer::run() {
-    if (listen_fd_ == -1 || epoll_fd_ == -1) {
+    if ((config_.listen && listen_fd_ == -1) || epoll_fd_ == -1) {
         std::cerr << "Server not initialized" << std::endl;
         return;
     }
     
-    running_ = true;
+    // 先绑核再分配事件数组等内存，按首次访问策略这些页面会落在本CPU所在的NUMA节点
+    if (config_.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(config_.cpu, &set);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (ret != 0) {
+            std::cerr << "Pin event loop to CPU " << config_.cpu << " failed: " << strerror(ret) << std::endl;
+        }
+    }
+    
     struct epoll_event events[config_.max_events];
     
     std::cout << "Server started, waiting for connections..." << std::endl;
     
     while (running_) {
-        int num_events = epoll_wait(epoll_fd_, events, config_.max_events, config_.timeout_ms);
+        // 上一轮到此结束，阻塞等待期间看门狗不计时
+        if (config_.loop_heartbeat) {
+            heartbeat_.endIteration(steadyNowNs());
+        }
+        profiler_.beginRound();
+        uint64_t wait_start = profiler_.start();
+        int num_events = waitEvents(events);
+        profiler_.record(PHASE_WAIT, wait_start);
+        TRACE_PROBE1(wait_end, num_events);
+        int64_t now_ns = steadyNowNs();
+        loop_time_ms_ = now_ns / 1000000;
+        if (config_.loop_heartbeat) {
+            heartbeat_.beginIteration(now_ns, num_events);
+        }
         
         if (num_events == -1) {
             if (errno == EINTR) {
@@ -121,9 +224,27 @@ void EpollServer::run() {
             std::cerr << "Epoll wait failed: " << strerror(errno) << std::endl;
             break;
         }
+        stats_.loop_rounds.fetch_add(1, std::memory_order_relaxed);
+        stats_.events_handled.fetch_add(num_events, std::memory_order_relaxed);
+        
+        // 空闲检查最多每秒一次，与有无事件无关
+        int idle_timeout_ms = tunables_->idle_timeout_ms.load(std::memory_order_relaxed);
+        if (idle_timeout_ms > 0 && loop_time_ms_ - last_idle_check_ms_ >= std::min(idle_timeout_ms, 1000)) {
+            last_idle_check_ms_ = loop_time_ms_;
+            markStage(STAGE_HOUSEKEEPING, -1);
+            closeIdle();
+        }
+        if (snapshot_requested_.load(std::memory_order_acquire)) {
+            markStage(STAGE_HOUSEKEEPING, -1);
+            serviceSnapshot();
+        }
+        // 流量小时录制块迟迟攒不满，至少每秒交一次
+        if (capture_records_ > 0 && loop_time_ms_ - capture_flush_ms_ >= 1000) {
+            flushCapture();
+        }
         
-        if (num_events == 0) {
-            // 超时，可以在这里处理超时逻辑
+        if (num_events == 0 && ready_list_.empty()) {
+            // 超时
             continue;
         }
         
@@ -131,24 +252,114 @@ void EpollServer::run() {
             int fd = events[i].data.fd;
             uint32_t event_type = events[i].events;
             
-            if (fd == listen_fd_) {
+            if (fd == wakeup_fd_) {
+                // stop()唤醒，循环条件会处理退出
+                uint64_t value;
+                ssize_t ret = read(wakeup_fd_, &value, sizeof(value));
+                (void)ret;
+            } else if (fd == listen_fd_) {
                 // 新连接
                 handleNewConnection();
-            } else if (event_type & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
-                // 客户端数据可读或错误
-                if (event_type & (EPOLLERR | EPOLLHUP)) {
-                    handleClientClose(fd);
-                } else {
+            } else if ((event_type & (EPOLLERR | EPOLLHUP)) ||
+                       ((event_type & EPOLLRDHUP) && !(event_type & EPOLLIN))) {
+                // 连接出错，或暂停读取期间对端关闭(未暂停时由读到EOF处理)
+                handleClientClose(fd);
+            } else {
+                // 客户端可写或数据可读
+                if (event_type & EPOLLOUT) {
+                    handleClientWrite(fd);
+                }
+                if (event_type & EPOLLIN) {
                     handleClientData(fd);
                 }
             }
         }
+        
+        // 新事件处理完后再轮转一遍仍有待处理数据的连接，然后统一发送本轮的转发报文
+        serviceReadyList();
+        if (!flush_list_.empty()) {
+            flushPending();
+        }
+        if (!paused_fds_.empty()) {
+            markStage(STAGE_HOUSEKEEPING, -1);
+            resumePaused();
+        }
+    }
+    if (config_.recorder != nullptr) {
+        flushCapture();
+    }
+}
+
+int EpollServer::waitEvents(struct epoll_event* events) {
+    if (config_.busy_poll_us > 0 && ready_list_.empty()) {
+        int num_events = busyPoll(events);
+        if (num_events != 0) {
+            return num_events;
+        }
+    }
+    // 就绪队列非空或连接快照未完成时只检查新事件，不阻塞；开启空闲超时时最多阻塞1秒
+    int timeout_ms = config_.timeout_ms;
+    if (!ready_list_.empty() || snapshot_requested_.load(std::memory_order_relaxed)) {
+        timeout_ms = 0;
+    } else if (tunables_->idle_timeout_ms.load(std::memory_order_relaxed) > 0) {
+        timeout_ms = timeout_ms < 0 ? 1000 : std::min(timeout_ms, 1000);
+    }
+    return epoll_wait(epoll_fd_, events, config_.max_events, timeout_ms);
+}
+
+int EpollServer::busyPoll(struct epoll_event* events) {
+    // CPU预算: 每秒最多自旋 budget_percent% 的时间，用完后直接阻塞，空闲实例不会一直占满CPU
+    int64_t start = steadyNowNs();
+    if (start - budget_window_start_ns_ >= 1000000000LL) {
+        budget_window_start_ns_ = start;
+        budget_spent_ns_ = 0;
+    }
+    if (budget_spent_ns_ >= 10000000LL * config_.busy_poll_budget_percent) {
+        return 0;
+    }
+    
+    int64_t deadline = start + spin_window_us_ * 1000LL;
+    int num_events = 0;
+    int64_t now = start;
+    do {
+        num_events = epoll_wait(epoll_fd_, events, config_.max_events, 0);
+        now = steadyNowNs();
+    } while (num_events == 0 && now < deadline && running_);
+    
+    budget_spent_ns_ += now - start;
+    stats_.spin_rounds.fetch_add(1, std::memory_order_relaxed);
+    stats_.spin_ns.fetch_add(now - start, std::memory_order_relaxed);
+    
+    // 自适应窗口: 命中则加倍(不超过上限)，落空则减半，负载低时退化为只轮询一次后阻塞
+    if (num_events > 0) {
+        stats_.spin_hits.fetch_add(1, std::memory_order_relaxed);
+        spin_window_us_ = std::min(spin_window_us_ * 2, config_.busy_poll_us);
+    } else if (num_events == 0) {
+        spin_window_us_ = std::max(spin_window_us_ / 2, 1);
     }
+    return num_events;
 }
 
 void EpollServer::stop() {
     running_ = false;
     
+    // 只做异步信号安全的操作，资源由事件循环退出后的cleanup()释放
+    wakeup();
+}
+
+void EpollServer::wakeup() {
+    if (wakeup_fd_ != -1) {
+        uint64_t value = 1;
+        ssize_t ret = write(wakeup_fd_, &value, sizeof(value));
+        (void)ret;
+    }
+}
+
+void EpollServer::cleanup() {
+    if (epoll_fd_ == -1 && listen_fd_ == -1) {
+        return;
+    }
+    
     if (epoll_fd_ != -1) {
         close(epoll_fd_);
         epoll_fd_ = -1;
@@ -160,15 +371,25 @@ void EpollServer::stop() {
     }
     
     // 关闭所有客户端连接
-    for (auto& client : client_buffers_) {
-        close(client);
+    for (size_t fd = 0; fd < client_buffers_.size(); ++fd) {
+        if (client_buffers_[fd].open) {
+            memory_->add(-client_buffers_[fd].accounted);
+            memory_->addConnection(-1);
+            close(fd);
+        }
     }
     client_buffers_.clear();
     
+    if (wakeup_fd_ != -1) {
+        close(wakeup_fd_);
+        wakeup_fd_ = -1;
+    }
+    
     std::cout << "Server stopped" << std::endl;
 }
 
 void EpollServer::handleNewConnection() {
+    markStage(STAGE_ACCEPT, listen_fd_);
     struct sockaddr_in client_addr;
     socklen_t client_len = sizeof(client_addr);
     
@@ -180,126 +401,832 @@ void EpollServer::handleNewConnection() {
                 break;
             } else {
                 std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+                stats_.accept_errors.fetch_add(1, std::memory_order_relaxed);
                 break;
             }
         }
         
+        // 内存超过硬限制或连接数达到上限时回复错误报文后立即关闭
+        int max_connections = tunables_->max_connections.load(std::memory_order_relaxed);
+        if (memory_->aboveHard() || (max_connections > 0 && memory_->connections() >= max_connections)) {
+            sendErrorFrame(client_fd, kErrorOverloaded);
+            close(client_fd);
+            stats_.rejected_connections.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        stats_.accepted_connections.fetch_add(1, std::memory_order_relaxed);
+        
+        // 绑核时记录连接是否由本CPU收包，衡量按CPU分发的效果
+        if (config_.cpu >= 0) {
+            int incoming_cpu = -1;
+            socklen_t len = sizeof(incoming_cpu);
+            if (getsockopt(client_fd, SOL_SOCKET, SO_INCOMING_CPU, &incoming_cpu, &len) == 0 &&
+                incoming_cpu == config_.cpu) {
+                stats_.local_connections.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                stats_.remote_connections.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        
         // 设置为非阻塞模式
         int flags = fcntl(client_fd, F_GETFL, 0);
         fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
         
-        // 添加到epoll
-        uint32_t events = EPOLLIN | (config_.use_et_mode ? EPOLLET : 0);
-        addEpollEvent(client_fd, events);
+        // 内核在收包路径上忙轮询网卡队列，减少中断唤醒延迟
+        if (config_.socket_busy_poll_us > 0) {
+            setsockopt(client_fd, SOL_SOCKET, SO_BUSY_POLL,
+                       &config_.socket_busy_poll_us, sizeof(config_.socket_busy_poll_us));
+#ifdef SO_PREFER_BUSY_POLL
+            int prefer = 1;
+            setsockopt(client_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+#endif
+        }
         
-        // 初始化客户端缓冲区
-        client_buffers_.insert(client_fd);
+        // 初始化客户端缓冲区并添加到epoll
+        openClient(client_fd);
         
-        // std::cout << "New client connected: " << inet_ntoa(client_addr.sin_addr) 
-        //           << ":" << ntohs(client_addr.sin_port) << std::endl;
+        if (logEnabled(LOG_DEBUG)) {
+            std::cout << "New client connected: " << inet_ntoa(client_addr.sin_addr)
+                      << ":" << ntohs(client_addr.sin_port) << " (fd " << client_fd << ")" << std::endl;
+        }
     }
 }
 
+bool EpollServer::attachCpuSteering(const std::vector<int>& cpus) {
+    if (listen_fd_ == -1 || cpus.empty()) {
+        std::cerr << "Server not initialized" << std::endl;
+        return false;
+    }
+    
+    // A = 收包CPU; 依次比较A == cpus[k]，相等返回k；都不相等时返回A % cpus.size()
+    std::vector<struct sock_filter> code;
+    code.push_back({ BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) });
+    for (size_t k = 0; k < cpus.size(); ++k) {
+        code.push_back({ BPF_JMP | BPF_JEQ | BPF_K, 0, 1, static_cast<uint32_t>(cpus[k]) });
+        code.push_back({ BPF_RET | BPF_K, 0, 0, static_cast<uint32_t>(k) });
+    }
+    code.push_back({ BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(cpus.size()) });
+    code.push_back({ BPF_RET | BPF_A, 0, 0, 0 });
+    struct sock_fprog prog;
+    prog.len = static_cast<unsigned short>(code.size());
+    prog.filter = code.data();
+    
+    if (setsockopt(listen_fd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+        std::cerr << "Attach reuseport CBPF failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EpollServer::adoptConnection(int fd) {
+    if (epoll_fd_ == -1) {
+        std::cerr << "Server not initialized" << std::endl;
+        return false;
+    }
+    
+    // 与accept得到的连接一样设为非阻塞并加入epoll
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    openClient(fd);
+    stats_.accepted_connections.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void EpollServer::openClient(int fd) {
+    if (static_cast<size_t>(fd) >= client_buffers_.size()) {
+        client_buffers_.resize(fd + 1);
+    }
+    ClientBuffer& client = client_buffers_[fd];
+    client = ClientBuffer();
+    client.open = true;
+    client.last_active_ms = loop_time_ms_;
+    if (config_.recorder != nullptr) {
+        client.trace_connection = config_.recorder->newConnection();
+    }
+    client.events = EPOLLIN | EPOLLRDHUP | (config_.use_et_mode ? EPOLLET : 0);
+    addEpollEvent(fd, client.events);
+    memory_->addConnection(1);
+    TRACE_PROBE1(accept, fd);
+}
+
+EpollServer::ClientBuffer* EpollServer::findClient(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= client_buffers_.size() || !client_buffers_[fd].open) {
+        return nullptr;
+    }
+    return &client_buffers_[fd];
+}
+
 void EpollServer::handleClientData(int fd) {
-    std::string received_data;
-    int msg_len = 0;
+    ClientBuffer* client = findClient(fd);
+    if (client == nullptr) {
+        return;
+    }
+    markStage(STAGE_READ, fd);
+    
+    int messages = 0;
+    long bytes = 0;
+    int budget_messages = tunables_->budget_messages.load(std::memory_order_relaxed);
+    int budget_bytes = tunables_->budget_bytes.load(std::memory_order_relaxed);
     // std::cout << "handle data" << std::endl;
-    while ((msg_len = readCompleteMessage(fd, received_data)) > 0) {
-        // 回射数据
-        if (sendCompleteMessage(fd, received_data)) {
-            // std::cout << "Echoed " << received_data.length() << " bytes to client " << fd << std::endl;
-        } else {
-            std::cerr << "Failed to send echo to client " << fd << std::endl;
+    while (canProcess(*client)) {
+        // 先处理缓冲区里已完整的报文，再从内核读取下一批；因内存暂停的连接也继续处理，只停止recv
+        int msg_len = 0;
+        while (canProcess(*client) &&
+               !(budget_messages > 0 && messages >= budget_messages) &&
+               !(budget_bytes > 0 && bytes >= budget_bytes)) {
+            int handled = 1;
+            if (config_.mode == MODE_KV) {
+                int max_commands = config_.kv_batch;
+                if (budget_messages > 0) {
+                    max_commands = std::min(max_commands, budget_messages - messages);
+                }
+                msg_len = processKvBatch(fd, *client, max_commands, handled);
+            } else {
+                msg_len = processMessage(fd, *client);
+            }
+            if (msg_len <= 0) {
+                break;
+            }
+            messages += handled;
+            client->messages += handled;
+            bytes += msg_len;
+        }
+        if (msg_len < 0) {
+            handleClientClose(fd);
+            return;
+        }
+        if (!flushOutput(fd, *client)) {
+            if (logEnabled(LOG_WARN)) {
+                std::cerr << "Failed to send echo to client " << fd << std::endl;
+            }
+            handleClientClose(fd);
+            return;
+        }
+        
+        // 预算用完时让出事件循环，由就绪队列在下一轮继续处理
+        if ((budget_messages > 0 && messages >= budget_messages) ||
+            (budget_bytes > 0 && bytes >= budget_bytes)) {
+            stats_.budget_deferrals.fetch_add(1, std::memory_order_relaxed);
+            markReady(fd);
+            break;
+        }
+        if (!canRead(*client)) {
+            break;
+        }
+        
+        int ret = readInput(fd, *client);
+        if (ret < 0) {
+            // 读取失败或连接关闭
             handleClientClose(fd);
+            return;
+        }
+        account(*client);
+        if (ret == 0) {
+            break;
+        }
+        
+        if (shouldPause(*client)) {
+            client->memory_paused = true;
+            paused_fds_.push_back(fd);
+            stats_.reads_paused.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    // 输入已全部处理时归还大缓冲区，暂停读取的连接不必等到下次读取
+    if (client->input_offset == client->input.size()) {
+        releaseDrained(client->input);
+        client->input_offset = 0;
+    }
+    account(*client);
+    updateInterest(fd, *client);
+}
+
+void EpollServer::handleClientWrite(int fd) {
+    ClientBuffer* client = findClient(fd);
+    if (client == nullptr) {
+        return;
+    }
+    markStage(STAGE_WRITE, fd);
+    if (!flushOutput(fd, *client)) {
+        if (logEnabled(LOG_WARN)) {
+            std::cerr << "Failed to send echo to client " << fd << std::endl;
         }
-    } 
-    if (msg_len < 0) {
-        // 读取失败或连接关闭
         handleClientClose(fd);
+        return;
+    }
+    account(*client);
+    // 暂停读取的连接不关注EPOLLIN，输出回落后由就绪队列继续处理已缓存的报文
+    if (client->memory_paused && canProcess(*client) && client->input_offset < client->input.size()) {
+        markReady(fd);
+    }
+    updateInterest(fd, *client);
+}
+
+bool EpollServer::canProcess(const ClientBuffer& client) const {
+    return client.pendingOutput() < static_cast<size_t>(config_.output_high_watermark);
+}
+
+bool EpollServer::canRead(const ClientBuffer& client) const {
+    return !client.memory_paused && canProcess(client);
+}
+
+bool EpollServer::shouldPause(const ClientBuffer& client) const {
+    // 超过软限制时，持有量高于平均值的连接暂停读取，已接收的数据留待恢复后处理；
+    // 不可能所有连接都高于平均值，总有连接继续推进。
+    // 其余连接合计未超过软限制时，暂停只会让自身未收完的报文永远收不完，因此继续读取，
+    // 由硬限制拒绝过大的报文
+    if (!memory_->aboveSoft()) {
+        return false;
+    }
+    int64_t held = static_cast<int64_t>(client.held());
+    return held > memory_->average() && memory_->used() - held > memory_->softLimit();
+}
+
+void EpollServer::updateInterest(int fd, ClientBuffer& client) {
+    uint32_t events = EPOLLRDHUP | (config_.use_et_mode ? EPOLLET : 0);
+    if (canRead(client)) {
+        events |= EPOLLIN;
+    }
+    if (client.pendingOutput() > 0) {
+        events |= EPOLLOUT;
+    }
+    if (events == client.events) {
+        return;
+    }
+    // 恢复读取时输入缓冲区里可能已有完整报文，内核中的数据也不会再产生新的边沿
+    if ((events & EPOLLIN) && !(client.events & EPOLLIN)) {
+        markReady(fd);
+    }
+    modifyEpollEvent(fd, events);
+    client.events = events;
+}
+
+void EpollServer::account(ClientBuffer& client) {
+    int64_t held = static_cast<int64_t>(client.held());
+    if (held != client.accounted) {
+        memory_->add(held - client.accounted);
+        client.accounted = held;
+    }
+}
+
+void EpollServer::resumePaused() {
+    // 内存回落到软限制以下，或不再是需要暂停的最大消费者时恢复读取
+    size_t kept = 0;
+    for (int fd : paused_fds_) {
+        ClientBuffer* client = findClient(fd);
+        if (client == nullptr || !client->memory_paused) {
+            continue;
+        }
+        if (shouldPause(*client)) {
+            paused_fds_[kept++] = fd;
+            continue;
+        }
+        client->memory_paused = false;
+        updateInterest(fd, *client);
+    }
+    paused_fds_.resize(kept);
+}
+
+void EpollServer::closeIdle() {
+    int64_t deadline = loop_time_ms_ - tunables_->idle_timeout_ms.load(std::memory_order_relaxed);
+    for (size_t fd = 0; fd < client_buffers_.size(); ++fd) {
+        const ClientBuffer& client = client_buffers_[fd];
+        if (client.open && client.last_active_ms < deadline) {
+            if (logEnabled(LOG_INFO)) {
+                std::cout << "Closing idle client " << fd << std::endl;
+            }
+            stats_.idle_closed.fetch_add(1, std::memory_order_relaxed);
+            handleClientClose(static_cast<int>(fd));
+        }
+    }
+}
+
+bool EpollServer::listConnections(std::vector<ConnectionInfo>& connections, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(snapshot_mutex_);
+    snapshot_.clear();
+    snapshot_cursor_ = 0;
+    snapshot_done_ = false;
+    snapshot_requested_.store(true, std::memory_order_release);
+    wakeup();
+    if (!snapshot_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return snapshot_done_; })) {
+        // 事件循环未运行或过忙，放弃本次请求
+        snapshot_requested_.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    connections.swap(snapshot_);
+    return true;
+}
+
+void EpollServer::serviceSnapshot() {
+    // 每轮循环只抓取一批连接，连接很多时快照分摊到多轮，不长时间占用事件循环
+    const size_t kSnapshotBatch = 256;
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    if (!snapshot_requested_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    size_t end = std::min(snapshot_cursor_ + kSnapshotBatch, client_buffers_.size());
+    for (size_t fd = snapshot_cursor_; fd < end; ++fd) {
+        const ClientBuffer& client = client_buffers_[fd];
+        if (!client.open) {
+            continue;
+        }
+        ConnectionInfo info;
+        info.fd = static_cast<int>(fd);
+        info.bytes_received = client.bytes_received;
+        info.bytes_sent = client.bytes_sent;
+        info.messages = client.messages;
+        info.buffered = client.input.size() - client.input_offset + client.pendingOutput();
+        info.idle_ms = loop_time_ms_ - client.last_active_ms;
+        info.paused = !canRead(client);
+        
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        if (getpeername(info.fd, (struct sockaddr*)&addr, &addr_len) == 0 && addr.sin_family == AF_INET) {
+            char ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+            info.peer = std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+        } else {
+            info.peer = "-";
+        }
+        struct tcp_info tcp;
+        socklen_t tcp_len = sizeof(tcp);
+        if (getsockopt(info.fd, IPPROTO_TCP, TCP_INFO, &tcp, &tcp_len) == 0) {
+            info.rtt_us = tcp.tcpi_rtt;
+            info.rtt_var_us = tcp.tcpi_rttvar;
+            info.snd_cwnd = tcp.tcpi_snd_cwnd;
+            info.total_retrans = tcp.tcpi_total_retrans;
+        }
+        snapshot_.push_back(info);
+    }
+    snapshot_cursor_ = end;
+    if (snapshot_cursor_ >= client_buffers_.size()) {
+        snapshot_done_ = true;
+        snapshot_requested_.store(false, std::memory_order_relaxed);
+        snapshot_cv_.notify_all();
+    }
+}
+
+void EpollServer::markReady(int fd) {
+    ClientBuffer* client = findClient(fd);
+    if (client != nullptr && !client->ready) {
+        client->ready = true;
+        ready_list_.push_back(fd);
+    }
+}
+
+void EpollServer::serviceReadyList() {
+    // 每个连接本轮只处理一次，仍未处理完的重新排到队尾
+    size_t count = ready_list_.size();
+    for (size_t i = 0; i < count && !ready_list_.empty(); ++i) {
+        int fd = ready_list_.front();
+        ready_list_.pop_front();
+        ClientBuffer* client = findClient(fd);
+        if (client == nullptr || !client->ready) {
+            continue;   // 已关闭
+        }
+        client->ready = false;
+        handleClientData(fd);
     }
 }
 
 void EpollServer::handleClientClose(int fd) {
+    ClientBuffer* client = findClient(fd);
+    if (client == nullptr) {
+        return;
+    }
+    TRACE_PROBE1(close, fd);
+    markStage(STAGE_CLOSE, fd);
+    while (!client->topics.empty()) {
+        std::string topic = client->topics.back();
+        unsubscribe(fd, *client, topic);
+    }
+    memory_->add(-client->accounted);
+    memory_->addConnection(-1);
+    *client = ClientBuffer();   // 释放缓冲区内存
+    
     removeEpollEvent(fd);
     close(fd);
-    client_buffers_.erase(fd);
-    // std::cout << "Client " << fd << " disconnected" << std::endl;
+    stats_.closed_connections.fetch_add(1, std::memory_order_relaxed);
+    if (logEnabled(LOG_DEBUG)) {
+        std::cout << "Client " << fd << " disconnected" << std::endl;
+    }
 }
 
-int EpollServer::readCompleteMessage(int fd, std::string& message) {
-    // 读取消息头（长度字段）
-    int msg_length;
-    ssize_t bytes_received = recv(fd, &msg_length, sizeof(msg_length), 0);
+int EpollServer::nextFrame(int fd, ClientBuffer& client, size_t offset) {
+    uint64_t framing_start = profiler_.start();
+    size_t available = client.input.size() - offset;
+    if (available < kFrameHeaderSize) {
+        return 0;
+    }
+    const char* frame = client.input.data() + offset;
+    uint32_t msg_length = decodeFrameHeader(frame);
     
-    if (bytes_received == 0) {
-        // std::cerr << "Connection closed by client" << std::endl;
-        return -1;
-    } else if (bytes_received < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-          // 非阻塞模式下没有数据可读
-          return 0;
+    if (msg_length == 0 || isErrorFrameHeader(msg_length)) {
+        if (logEnabled(LOG_WARN)) {
+            std::cerr << "Invalid message length: " << msg_length << std::endl;
         }
-        std::cerr << "Receive message header failed: " << strerror(errno) << std::endl;
-        return -1;
-    } else if (bytes_received != sizeof(msg_length)) {
-        std::cerr << "Incomplete message header received" << std::endl;
         return -1;
     }
     
-    // 转换为主机字节序
-    msg_length = ntohl(msg_length);
+    size_t frame_size = kFrameHeaderSize + msg_length;
+    if (available < frame_size) {
+        // 内存超过硬限制时不再为大报文继续缓存，回复错误报文后断开
+        if (msg_length >= static_cast<uint32_t>(config_.large_frame_bytes) &&
+            memory_->aboveHard(frame_size - available)) {
+            if (logEnabled(LOG_WARN)) {
+                std::cerr << "Rejecting " << msg_length << " byte message from client " << fd
+                          << ": memory over hard limit" << std::endl;
+            }
+            stats_.rejected_frames.fetch_add(1, std::memory_order_relaxed);
+            sendErrorFrame(fd, kErrorFrameTooLarge);
+            return -1;
+        }
+        return 0;
+    }
     
-    if (msg_length <= 0) {
-        std::cerr << "Invalid message length: " << msg_length << std::endl;
+    const char* payload = frame + kFrameHeaderSize;
+    if (config_.verify_checksum && !verifyPayloadChecksum(payload, msg_length)) {
+        if (logEnabled(LOG_WARN)) {
+            std::cerr << "Checksum mismatch from client " << fd << std::endl;
+        }
+        stats_.checksum_errors.fetch_add(1, std::memory_order_relaxed);
         return -1;
     }
+    profiler_.record(PHASE_FRAMING, framing_start);
+    TRACE_PROBE2(frame_complete, fd, msg_length);
+    if (config_.recorder != nullptr) {
+        captureFrame(client, payload, msg_length);
+    }
+    return static_cast<int>(msg_length);
+}
+
+void EpollServer::captureFrame(const ClientBuffer& client, const char* payload, uint32_t length) {
+    config_.recorder->append(capture_chunk_, steadyNowNs(), client.trace_connection, payload, length);
+    if (++capture_records_ == 1) {
+        capture_flush_ms_ = loop_time_ms_;
+    }
+    if (capture_chunk_.size() >= TrafficRecorder::kChunkBytes) {
+        flushCapture();
+    }
+}
+
+void EpollServer::flushCapture() {
+    config_.recorder->submit(capture_chunk_, capture_records_);
+    capture_records_ = 0;
+    capture_flush_ms_ = loop_time_ms_;
+}
+
+int EpollServer::processMessage(int fd, ClientBuffer& client) {
+    int msg_length = nextFrame(fd, client, client.input_offset);
+    if (msg_length <= 0) {
+        return msg_length;
+    }
+    const char* frame = client.input.data() + client.input_offset;
+    size_t frame_size = kFrameHeaderSize + msg_length;
     
-    // 读取消息体
-    std::vector<char> buffer(msg_length);
-    int bytes_cnt = 0;
-    while(bytes_cnt < msg_length){
-      bytes_received = recv(fd, buffer.data(), msg_length, 0);
-      if (bytes_received < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-          // 非阻塞模式下没有数据可读
-          continue;
+    TRACE_PROBE2(handler_start, fd, 1);
+    uint64_t handler_start = profiler_.start();
+    if (config_.mode == MODE_PUBSUB) {
+        if (!handlePubSub(fd, client, frame, frame_size)) {
+            if (logEnabled(LOG_WARN)) {
+                std::cerr << "Invalid pub/sub message from client " << fd << std::endl;
+            }
+            return -1;
         }
-        std::cerr << "Read message body failed: " << strerror(errno) << std::endl;
-        return -1;
-      }
-      bytes_cnt += bytes_received;
+    } else {
+        // 回射: 原样追加长度字段和数据
+        client.output.insert(client.output.end(), frame, frame + frame_size);
     }
-    // total_recv += msg_length;
-    // std::cout << total_recv << std::endl;
-    message.assign(buffer.data(), msg_length);
+    profiler_.record(PHASE_HANDLER, handler_start);
+    TRACE_PROBE2(handler_end, fd, 1);
+    client.input_offset += frame_size;
     return msg_length;
 }
 
-bool EpollServer::sendCompleteMessage(int fd, const std::string& message) {
-    // 计算整个结构体的大小
-    size_t total_size = sizeof(int) + message.length();
+int EpollServer::processKvBatch(int fd, ClientBuffer& client, int max_commands, int& commands) {
+    // 先解析出一批完整命令，再一次性加锁执行，摊薄加锁开销
+    kv_batch_.clear();
+    kv_shards_.clear();
+    size_t offset = client.input_offset;
+    int total = 0;
+    int msg_length = 0;
+    while (static_cast<int>(kv_batch_.size()) < max_commands &&
+           (msg_length = nextFrame(fd, client, offset)) > 0) {
+        KvCommand command;
+        const char* payload = client.input.data() + offset + kFrameHeaderSize;
+        if (!parseKvRequest(payload, msg_length, command.op, command.key, command.value) ||
+            (command.op != kKvGet && command.op != kKvSet && command.op != kKvDel)) {
+            if (logEnabled(LOG_WARN)) {
+                std::cerr << "Invalid kv command from client " << fd << std::endl;
+            }
+            return -1;
+        }
+        command.hash = KvStore::hashKey(command.key);
+        command.shard = kv_->shardFor(command.hash);
+        kv_batch_.push_back(command);
+        kv_shards_.push_back(command.shard);
+        offset += kFrameHeaderSize + msg_length;
+        total += msg_length;
+    }
+    if (msg_length < 0) {
+        return -1;
+    }
+    commands = static_cast<int>(kv_batch_.size());
+    if (kv_batch_.empty()) {
+        return 0;
+    }
     
-    // 分配内存来构建完整的结构体
-    std::vector<char> buffer(total_size);
+    // 按分片序号升序加锁，多个worker同时锁多个分片时不会死锁
+    TRACE_PROBE2(handler_start, fd, commands);
+    uint64_t handler_start = profiler_.start();
+    std::sort(kv_shards_.begin(), kv_shards_.end());
+    kv_shards_.erase(std::unique(kv_shards_.begin(), kv_shards_.end()), kv_shards_.end());
+    for (int shard : kv_shards_) {
+        kv_->shard(shard).mutex().lock();
+    }
+    for (const KvCommand& command : kv_batch_) {
+        KvShard& shard = kv_->shard(command.shard);
+        char status = kKvOk;
+        std::string_view value;
+        if (command.op == kKvGet) {
+            if (!shard.get(command.hash, command.key, value)) {
+                status = kKvNotFound;
+            }
+        } else if (command.op == kKvSet) {
+            if (!shard.set(command.hash, command.key, command.value)) {
+                status = kKvError;
+            }
+        } else if (!shard.del(command.hash, command.key)) {
+            status = kKvNotFound;
+        }
+        // 响应直接写入输出缓冲区: 长度字段 + 状态 + 值
+        size_t response_offset = client.output.size();
+        client.output.resize(response_offset + kFrameHeaderSize + 1 + value.size());
+        char* response = client.output.data() + response_offset;
+        encodeFrameHeader(response, static_cast<uint32_t>(1 + value.size()));
+        response[kFrameHeaderSize] = status;
+        if (!value.empty()) {
+            memcpy(response + kFrameHeaderSize + 1, value.data(), value.size());
+        }
+    }
+    for (auto it = kv_shards_.rbegin(); it != kv_shards_.rend(); ++it) {
+        kv_->shard(*it).mutex().unlock();
+    }
+    profiler_.record(PHASE_HANDLER, handler_start);
+    TRACE_PROBE2(handler_end, fd, commands);
     
-    // 设置长度字段（网络字节序）
-    int msg_length = htonl(message.length());
-    memcpy(buffer.data(), &msg_length, sizeof(msg_length));
+    client.input_offset = offset;
+    return total;
+}
+
+int EpollServer::readInput(int fd, ClientBuffer& client) {
+    // 丢弃已处理的数据，未处理部分移到缓冲区头部
+    if (client.input_offset == client.input.size()) {
+        releaseDrained(client.input);
+        client.input_offset = 0;
+    } else if (client.input_offset > 0) {
+        client.input.erase(client.input.begin(), client.input.begin() + client.input_offset);
+        client.input_offset = 0;
+    }
     
-    // 拷贝数据内容
-    memcpy(buffer.data() + sizeof(msg_length), message.data(), message.length());
+    // 先读到共用的接收缓冲区，连接缓冲区只按实际收到的字节增长，
+    // 避免每次为整块预留并填零、读到EAGAIN时仍占着64KB
+    uint64_t recv_start = profiler_.start();
+    ssize_t bytes_received = recv(fd, read_scratch_.data(), read_scratch_.size(), 0);
+    profiler_.record(PHASE_RECV, recv_start);
+    if (bytes_received > 0) {
+        client.input.insert(client.input.end(), read_scratch_.data(), read_scratch_.data() + bytes_received);
+    }
+    
+    if (bytes_received == 0) {
+        // std::cerr << "Connection closed by client" << std::endl;
+        return -1;
+    } else if (bytes_received < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // 非阻塞模式下没有数据可读
+            return 0;
+        }
+        if (logEnabled(LOG_WARN)) {
+            std::cerr << "Receive message failed: " << strerror(errno) << std::endl;
+        }
+        return -1;
+    }
+    TRACE_PROBE2(recv, fd, bytes_received);
+    client.bytes_received += bytes_received;
+    client.last_active_ms = loop_time_ms_;
+    return 1;
+}
+
+bool EpollServer::flushOutput(int fd, ClientBuffer& client) {
+    const int kMaxIov = 64;
     
-    // 一次性发送整个结构体
-    ssize_t bytes_sent = send(fd, buffer.data(), total_size, 0);
-    if (bytes_sent != static_cast<ssize_t>(total_size)) {
-        std::cerr << "Send message struct failed: " << strerror(errno) << std::endl;
+    while (client.pendingOutput() > 0) {
+        // 自身的回射数据在前，转发的共享报文在后，一次系统调用发出
+        struct iovec iov[kMaxIov];
+        int iovcnt = 0;
+        if (client.output_offset < client.output.size()) {
+            iov[iovcnt].iov_base = client.output.data() + client.output_offset;
+            iov[iovcnt].iov_len = client.output.size() - client.output_offset;
+            iovcnt++;
+        }
+        size_t skip = client.shared_offset;
+        for (auto it = client.shared_output.begin(); it != client.shared_output.end() && iovcnt < kMaxIov; ++it) {
+            iov[iovcnt].iov_base = const_cast<char*>((*it)->data()) + skip;
+            iov[iovcnt].iov_len = (*it)->size() - skip;
+            iovcnt++;
+            skip = 0;
+        }
+        
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        uint64_t send_start = profiler_.start();
+        ssize_t bytes_sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        profiler_.record(PHASE_SEND, send_start);
+        if (bytes_sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 发送缓冲区已满，剩余数据等可写事件
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (logEnabled(LOG_WARN)) {
+                std::cerr << "Send message failed: " << strerror(errno) << std::endl;
+            }
+            return false;
+        }
+        TRACE_PROBE2(send, fd, bytes_sent);
+        client.bytes_sent += bytes_sent;
+        client.last_active_ms = loop_time_ms_;
+        
+        size_t sent = bytes_sent;
+        size_t own = std::min(sent, client.output.size() - client.output_offset);
+        client.output_offset += own;
+        sent -= own;
+        if (client.output_offset == client.output.size()) {
+            releaseDrained(client.output);
+            client.output_offset = 0;
+        }
+        // 发送完的共享报文出队，最后一个引用释放时内存归还
+        while (sent > 0) {
+            size_t remaining = client.shared_output.front()->size() - client.shared_offset;
+            if (sent < remaining) {
+                client.shared_offset += sent;
+                break;
+            }
+            sent -= remaining;
+            client.shared_bytes -= client.shared_output.front()->size();
+            client.shared_output.pop_front();
+            client.shared_offset = 0;
+        }
+    }
+    return true;
+}
+
+void EpollServer::sendErrorFrame(int fd, uint32_t code) {
+    std::vector<char> frame;
+    buildErrorFrame(code, frame);
+    ssize_t ret = send(fd, frame.data(), frame.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    (void)ret;
+}
+
+bool EpollServer::handlePubSub(int fd, ClientBuffer& client, const char* frame, size_t frame_size) {
+    char op;
+    std::string_view topic;
+    std::string_view data;
+    if (!parsePubSubPayload(frame + kFrameHeaderSize, frame_size - kFrameHeaderSize, op, topic, data)) {
         return false;
     }
-    // total_send += message.length();
-    // std::cout << total_send << std::endl;
+    switch (op) {
+        case kOpSubscribe:
+            subscribe(fd, client, topic);
+            break;
+        case kOpUnsubscribe:
+            unsubscribe(fd, client, topic);
+            break;
+        case kOpPublish:
+            publish(topic, frame, frame_size);
+            return true;
+        default:
+            return false;
+    }
+    // 订阅和取消订阅原样回复作为确认
+    client.output.insert(client.output.end(), frame, frame + frame_size);
     return true;
 }
 
+void EpollServer::subscribe(int fd, ClientBuffer& client, std::string_view topic) {
+    if (std::find(client.topics.begin(), client.topics.end(), topic) != client.topics.end()) {
+        return;
+    }
+    client.topics.emplace_back(topic);
+    topics_[client.topics.back()].push_back(fd);
+}
+
+void EpollServer::unsubscribe(int fd, ClientBuffer& client, std::string_view topic) {
+    auto own = std::find(client.topics.begin(), client.topics.end(), topic);
+    if (own == client.topics.end()) {
+        return;
+    }
+    auto it = topics_.find(*own);
+    if (it != topics_.end()) {
+        std::vector<int>& subscribers = it->second;
+        auto pos = std::find(subscribers.begin(), subscribers.end(), fd);
+        if (pos != subscribers.end()) {
+            *pos = subscribers.back();
+            subscribers.pop_back();
+        }
+        if (subscribers.empty()) {
+            topics_.erase(it);
+        }
+    }
+    client.topics.erase(own);
+}
+
+void EpollServer::publish(std::string_view topic, const char* frame, size_t frame_size) {
+    stats_.published.fetch_add(1, std::memory_order_relaxed);
+    auto it = topics_.find(std::string(topic));
+    if (it == topics_.end()) {
+        return;
+    }
+    
+    // 报文只复制一份，按实际大小记账一次，最后一个订阅者发送完时归还
+    MemoryBudget* memory = memory_;
+    memory->add(frame_size);
+    SharedFrame shared(new std::vector<char>(frame, frame + frame_size),
+                       [memory](const std::vector<char>* buffer) {
+                           memory->add(-static_cast<int64_t>(buffer->size()));
+                           delete buffer;
+                       });
+    for (int fd : it->second) {
+        deliver(fd, shared);
+    }
+}
+
+void EpollServer::deliver(int fd, const SharedFrame& frame) {
+    ClientBuffer* client = findClient(fd);
+    if (client == nullptr || client->closing) {
+        return;
+    }
+    
+    // 上次发送已阻塞(正在等待可写)或排队数据已超过水位的订阅者视为慢订阅者，
+    // 后者防止一批发布在统一发送前无限排队
+    if ((client->events & EPOLLOUT) ||
+        client->pendingOutput() >= static_cast<size_t>(config_.output_high_watermark)) {
+        if (config_.slow_policy == SLOW_DROP) {
+            stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (config_.slow_policy == SLOW_DISCONNECT ||
+            client->shared_output.size() >= static_cast<size_t>(config_.subscriber_queue_limit)) {
+            // 不在转发过程中修改订阅表，由flushPending()统一关闭
+            client->closing = true;
+            stats_.slow_disconnects.fetch_add(1, std::memory_order_relaxed);
+            if (!client->flush_pending) {
+                client->flush_pending = true;
+                flush_list_.push_back(fd);
+            }
+            return;
+        }
+    }
+    
+    client->shared_output.push_back(frame);
+    client->shared_bytes += frame->size();
+    stats_.delivered.fetch_add(1, std::memory_order_relaxed);
+    if (!client->flush_pending) {
+        client->flush_pending = true;
+        flush_list_.push_back(fd);
+    }
+}
+
+void EpollServer::flushPending() {
+    // 同一轮内发布的多个报文合并到一次sendmsg
+    for (int fd : flush_list_) {
+        ClientBuffer* client = findClient(fd);
+        if (client == nullptr || !client->flush_pending) {
+            continue;
+        }
+        client->flush_pending = false;
+        markStage(STAGE_FLUSH, fd);
+        if (client->closing) {
+            handleClientClose(fd);
+            continue;
+        }
+        // 正在等待可写的连接由EPOLLOUT继续发送
+        if (!(client->events & EPOLLOUT) && !flushOutput(fd, *client)) {
+            if (logEnabled(LOG_WARN)) {
+                std::cerr << "Failed to forward to client " << fd << std::endl;
+            }
+            handleClientClose(fd);
+            continue;
+        }
+        account(*client);
+        updateInterest(fd, *client);
+    }
+    flush_list_.clear();
+}
+
 void EpollServer::addEpollEvent(int fd, uint32_t events) {
     struct epoll_event ev;
     ev.events = events;
@@ -310,6 +1237,16 @@ void EpollServer::addEpollEvent(int fd, uint32_t events) {
     }
 }
 
+void EpollServer::modifyEpollEvent(int fd, uint32_t events) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.fd = fd;
+    
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == -1) {
+        std::cerr << "Modify epoll event failed for fd " << fd << ": " << strerror(errno) << std::endl;
+    }
+}
+
 void EpollServer::removeEpollEvent(int fd) {
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) == -1) {
         std::cerr << "Remove epoll event failed for fd " << fd << ": " << strerror(errno) << std::endl;
@@ -0,0 +1,238 @@
+#include "../include/size_distribution.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// 解析逗号分隔的数值参数
+static std::vector<double> parseArgs(const std::string& text) {
+    std::vector<double> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(std::atof(item.c_str()));
+    }
+    return values;
+}
+
+static int clampSize(double size) {
+    return static_cast<int>(std::min<double>(std::max<double>(std::lround(size), 1), SizeDistribution::kMaxSize));
+}
+
+SizeDistribution::SizeDistribution(int fixed_size)
+    : min_(0), max_(0), mean_(0) {
+    int size = clampSize(fixed_size);
+    spec_ = "fixed:" + std::to_string(size);
+    buildTable(std::vector<int>(1, size), std::vector<double>(1, 1.0));
+}
+
+bool SizeDistribution::parse(const std::string& spec) {
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string rest = colon == std::string::npos ? "" : spec.substr(colon + 1);
+    std::vector<double> args = parseArgs(rest);
+    std::vector<int> sizes;
+    std::vector<double> weights;
+
+    if (kind == "fixed" && args.size() == 1) {
+        sizes.push_back(clampSize(args[0]));
+        weights.push_back(1.0);
+    } else if (kind == "uniform" && args.size() == 2 && args[0] <= args[1]) {
+        for (int size = clampSize(args[0]); size <= clampSize(args[1]); ++size) {
+            sizes.push_back(size);
+            weights.push_back(1.0);
+        }
+    } else if (kind == "lognormal" && (args.size() == 2 || args.size() == 3) && args[0] > 0 && args[1] > 0) {
+        // 每个整数大小的概率取对数正态CDF在[size-0.5, size+0.5)上的增量
+        double mu = std::log(args[0]);
+        double sigma = args[1];
+        int max_size = clampSize(args.size() == 3 ? args[2] : kMaxSize);
+        auto cdf = [mu, sigma](double x) { return 0.5 * std::erfc(-(std::log(x) - mu) / (sigma * std::sqrt(2.0))); };
+        double previous = 0;
+        for (int size = 1; size <= max_size; ++size) {
+            double current = size == max_size ? 1.0 : cdf(size + 0.5);
+            if (current > previous) {
+                sizes.push_back(size);
+                weights.push_back(current - previous);
+            }
+            previous = current;
+        }
+    } else if (kind == "bimodal" && args.size() == 3 && args[2] >= 0 && args[2] <= 1) {
+        sizes.push_back(clampSize(args[0]));
+        weights.push_back(1.0 - args[2]);
+        sizes.push_back(clampSize(args[1]));
+        weights.push_back(args[2]);
+    } else if (kind == "zipf" && (args.size() == 2 || args.size() == 3) && args[0] <= args[1]) {
+        double theta = args.size() == 3 ? args[2] : 0.99;
+        int rank = 1;
+        for (int size = clampSize(args[0]); size <= clampSize(args[1]); ++size, ++rank) {
+            sizes.push_back(size);
+            weights.push_back(1.0 / std::pow(rank, theta));
+        }
+    } else if (kind == "file" && !rest.empty()) {
+        std::ifstream in(rest);
+        if (!in) {
+            std::cerr << "Open size histogram " << rest << " failed" << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            std::stringstream ls(line);
+            double size;
+            double weight = 1.0;
+            if (line.empty() || line[0] == '#' || !(ls >> size)) {
+                continue;
+            }
+            ls >> weight;
+            if (weight > 0) {
+                sizes.push_back(clampSize(size));
+                weights.push_back(weight);
+            }
+        }
+        if (sizes.empty()) {
+            std::cerr << "Size histogram " << rest << " has no entries" << std::endl;
+            return false;
+        }
+        // 分位数表要求大小有序
+        std::vector<size_t> order(sizes.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] < sizes[b]; });
+        std::vector<int> sorted_sizes;
+        std::vector<double> sorted_weights;
+        for (size_t i : order) {
+            sorted_sizes.push_back(sizes[i]);
+            sorted_weights.push_back(weights[i]);
+        }
+        sizes.swap(sorted_sizes);
+        weights.swap(sorted_weights);
+    } else {
+        std::cerr << "Invalid size distribution: " << spec << std::endl;
+        return false;
+    }
+
+    double total = 0;
+    for (double weight : weights) {
+        total += weight;
+    }
+    if (sizes.empty() || total <= 0) {
+        std::cerr << "Invalid size distribution: " << spec << std::endl;
+        return false;
+    }
+    spec_ = spec;
+    buildTable(sizes, weights);
+    return true;
+}
+
+void SizeDistribution::buildTable(const std::vector<int>& sizes, const std::vector<double>& weights) {
+    // 第i项取(i+0.5)/N分位数处的大小，抽样即均匀选一项
+    const size_t entries = static_cast<size_t>(1) << kTableBits;
+    double total = 0;
+    for (double weight : weights) {
+        total += weight;
+    }
+    table_.resize(entries);
+    size_t j = 0;
+    double cumulative = weights[0];
+    double sum = 0;
+    for (size_t i = 0; i < entries; ++i) {
+        double target = (i + 0.5) / entries * total;
+        while (cumulative < target && j + 1 < sizes.size()) {
+            cumulative += weights[++j];
+        }
+        table_[i] = sizes[j];
+        sum += sizes[j];
+    }
+    min_ = *std::min_element(table_.begin(), table_.end());
+    max_ = *std::max_element(table_.begin(), table_.end());
+    mean_ = sum / entries;
+}
+
+int SizeBucketStats::bucketFor(size_t size) {
+    int bucket = size == 0 ? 0 : 63 - __builtin_clzll(size);
+    return std::min(bucket, kBuckets - 1);
+}
+
+void SizeBucketStats::record(size_t size, int64_t latency_ns) {
+    int bucket = bucketFor(size);
+    messages[bucket]++;
+    bytes[bucket] += size;
+    latency[bucket].record(latency_ns);
+}
+
+void SizeBucketStats::merge(const SizeBucketStats& other) {
+    for (int i = 0; i < kBuckets; ++i) {
+        messages[i] += other.messages[i];
+        bytes[i] += other.bytes[i];
+        latency[i].merge(other.latency[i]);
+    }
+}
+
+void SizeBucketStats::reset() {
+    for (int i = 0; i < kBuckets; ++i) {
+        messages[i] = 0;
+        bytes[i] = 0;
+        latency[i].reset();
+    }
+}
+
+void SizeBucketStats::appendTo(std::vector<char>& out) const {
+    appendPod(out, messages);
+    appendPod(out, bytes);
+    for (const LatencyHistogram& histogram : latency) {
+        histogram.appendTo(out);
+    }
+}
+
+bool SizeBucketStats::readFrom(const char*& data, const char* end) {
+    if (!readPod(data, end, messages) || !readPod(data, end, bytes)) {
+        return false;
+    }
+    for (LatencyHistogram& histogram : latency) {
+        if (!histogram.readFrom(data, end)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SizeBucketStats::print(std::ostream& out, double duration_sec) const {
+    out << "By message size:" << std::endl;
+    for (int i = 0; i < kBuckets; ++i) {
+        if (messages[i] == 0) {
+            continue;
+        }
+        out << "  [" << (1L << i) << ", " << (2L << i) << "): " << messages[i] << " msgs";
+        if (duration_sec > 0) {
+            out << ", " << static_cast<long>(messages[i] / duration_sec) << " msg/s, "
+                << bytes[i] / duration_sec / 1024 << " KB/s";
+        }
+        out << ", latency (us) p50=" << latency[i].percentile(50) / 1000.0
+            << " p99=" << latency[i].percentile(99) / 1000.0
+            << " max=" << latency[i].max() / 1000.0 << std::endl;
+    }
+}
+
+void SizeBucketStats::writeJson(std::ostream& out, double duration_sec) const {
+    out << "[";
+    bool first = true;
+    for (int i = 0; i < kBuckets; ++i) {
+        if (messages[i] == 0) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    {\"min_size\": " << (1L << i)
+            << ", \"max_size\": " << (2L << i) - 1
+            << ", \"messages\": " << messages[i]
+            << ", \"bytes\": " << bytes[i]
+            << ", \"messages_per_sec\": " << (duration_sec > 0 ? messages[i] / duration_sec : 0)
+            << ", \"latency_p50_us\": " << latency[i].percentile(50) / 1000.0
+            << ", \"latency_p99_us\": " << latency[i].percentile(99) / 1000.0
+            << ", \"latency_max_us\": " << latency[i].max() / 1000.0 << "}";
+    }
+    out << (first ? "]" : "\n  ]");
+}
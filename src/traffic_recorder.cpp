@@ -0,0 +1,156 @@
+#include "../include/traffic_recorder.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// 回收缓冲区最多保留的个数，多出的直接释放
+static const size_t kMaxFreeChunks = 16;
+
+TrafficRecorder::TrafficRecorder(const std::string& path, bool payloads, size_t max_queued_bytes)
+    : path_(path), payloads_(payloads), max_queued_bytes_(max_queued_bytes), fd_(-1), start_ns_(0),
+      next_connection_(0), queued_bytes_(0), stopping_(false), records_(0), dropped_(0), bytes_written_(0) {
+}
+
+TrafficRecorder::~TrafficRecorder() {
+    stop();
+}
+
+bool TrafficRecorder::start() {
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        std::cerr << "Open capture file " << path_ << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+    header.version = kTraceVersion;
+    header.flags = payloads_ ? kTraceHasPayloads : 0;
+    if (!writeAll(reinterpret_cast<const char*>(&header), sizeof(header))) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    start_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    thread_ = std::thread(&TrafficRecorder::run, this);
+    std::cout << "Capturing traffic to " << path_ << (payloads_ ? " (with payloads)" : "") << std::endl;
+    return true;
+}
+
+void TrafficRecorder::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+
+    // 回填文件头中的记录数和连接数
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+    header.version = kTraceVersion;
+    header.flags = payloads_ ? kTraceHasPayloads : 0;
+    header.records = records();
+    header.connections = next_connection_.load(std::memory_order_relaxed);
+    if (pwrite(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        std::cerr << "Write capture header failed: " << strerror(errno) << std::endl;
+    }
+    close(fd_);
+    fd_ = -1;
+    std::cout << "Captured " << header.records << " frames from " << header.connections << " connections to "
+              << path_ << " (" << dropped() << " dropped)" << std::endl;
+}
+
+void TrafficRecorder::append(std::vector<char>& chunk, int64_t now_ns, uint32_t connection,
+                             const char* payload, uint32_t length) const {
+    TraceRecord record;
+    record.time_ns = static_cast<uint64_t>(now_ns > start_ns_ ? now_ns - start_ns_ : 0);
+    record.connection = connection;
+    record.length = length;
+    size_t offset = chunk.size();
+    chunk.resize(offset + traceRecordSize(record, payloads_ ? kTraceHasPayloads : 0));
+    memcpy(chunk.data() + offset, &record, sizeof(record));
+    if (payloads_) {
+        // 补齐部分由resize填零
+        memcpy(chunk.data() + offset + sizeof(record), payload, length);
+    }
+}
+
+void TrafficRecorder::submit(std::vector<char>& chunk, uint64_t records) {
+    if (chunk.empty()) {
+        return;
+    }
+    std::vector<char> replacement;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queued_bytes_ + chunk.size() > max_queued_bytes_) {
+            dropped_.fetch_add(records, std::memory_order_relaxed);
+            chunk.clear();
+            return;
+        }
+        queued_bytes_ += chunk.size();
+        queue_.push_back(Chunk{std::move(chunk), records});
+        if (!free_.empty()) {
+            replacement = std::move(free_.back());
+            free_.pop_back();
+        }
+    }
+    cv_.notify_one();
+    chunk = std::move(replacement);
+    chunk.clear();
+    chunk.reserve(kChunkBytes);
+}
+
+void TrafficRecorder::run() {
+    // 写文件出错后不再写入，已写的记录数仍按完整的块回填，回放时忽略文件尾部
+    bool failed = false;
+    while (true) {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;     // 停止且已写完
+            }
+            chunk = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        if (!failed && writeAll(chunk.data.data(), chunk.data.size())) {
+            records_.fetch_add(chunk.records, std::memory_order_relaxed);
+            bytes_written_.fetch_add(chunk.data.size(), std::memory_order_relaxed);
+        } else {
+            failed = true;
+            dropped_.fetch_add(chunk.records, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_bytes_ -= chunk.data.size();
+        if (free_.size() < kMaxFreeChunks) {
+            chunk.data.clear();
+            free_.push_back(std::move(chunk.data));
+        }
+    }
+}
+
+bool TrafficRecorder::writeAll(const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd_, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Write capture file failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
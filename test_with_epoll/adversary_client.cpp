@@ -0,0 +1,204 @@
+#include "adversary_client.h"
+#include "../include/frame.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <iostream>
+#include <cerrno>
+#include <random>
+#include <thread>
+#include <algorithm>
+
+AdversaryClient::AdversaryClient(const ClientConfig& config, Profile profile)
+    : config_(config), profile_(profile), running_(false) {
+    std::mt19937 rng(std::random_device{}());
+    std::string payload = generatePayload(rng, std::max(config_.message_size, 1));
+    if (config_.checksum) {
+        // 服务器开启校验时异常客户端的完整报文也须通过校验，隔离测试只针对收发行为
+        char trailer[kChecksumSize];
+        encodeChecksum(trailer, crc32c(payload.data(), payload.size()));
+        payload.append(trailer, sizeof(trailer));
+    }
+    std::vector<char> frame;
+    buildFrame(payload, frame);
+    frame_.assign(frame.data(), frame.size());
+}
+
+AdversaryClient::~AdversaryClient() {
+    stopTest();
+    for (auto& conn : connections_) {
+        closeConnection(conn, false);
+    }
+}
+
+bool AdversaryClient::parseProfile(const std::string& name, Profile& profile) {
+    if (name == "slowloris") {
+        profile = SLOWLORIS;
+    } else if (name == "split-header") {
+        profile = SPLIT_HEADER;
+    } else if (name == "no-read") {
+        profile = NO_READ;
+    } else if (name == "rst") {
+        profile = RST_MID_FRAME;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* AdversaryClient::profileName(Profile profile) {
+    switch (profile) {
+        case SLOWLORIS: return "slowloris";
+        case SPLIT_HEADER: return "split-header";
+        case NO_READ: return "no-read";
+        case RST_MID_FRAME: return "rst";
+    }
+    return "unknown";
+}
+
+void AdversaryClient::runTest() {
+    running_ = true;
+    connections_.assign(std::max(config_.adversary_connections, 1), Connection());
+    for (auto& conn : connections_) {
+        openConnection(conn);
+    }
+
+    while (running_) {
+        for (auto& conn : connections_) {
+            if (conn.fd == -1 && !openConnection(conn)) {
+                continue;
+            }
+            step(conn);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(config_.adversary_interval_ms));
+    }
+
+    for (auto& conn : connections_) {
+        closeConnection(conn, false);
+    }
+}
+
+void AdversaryClient::stopTest() {
+    running_ = false;
+}
+
+bool AdversaryClient::openConnection(Connection& conn) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        std::cerr << "Create socket failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 每次发送单独成段，不被Nagle合并
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    if (profile_ == NO_READ) {
+        // 接收缓冲区尽量小，使服务器的回射尽快阻塞
+        int rcvbuf = 1;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config_.server_port);
+    inet_pton(AF_INET, config_.server_ip.c_str(), &server_addr.sin_addr);
+
+    // 阻塞连接，建立后再切换为非阻塞
+    if (connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) == -1) {
+        std::cerr << "Adversary connect failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    conn.fd = fd;
+    conn.offset = 0;
+    stats_.connections++;
+    return true;
+}
+
+void AdversaryClient::closeConnection(Connection& conn, bool reset) {
+    if (conn.fd == -1) {
+        return;
+    }
+    if (reset) {
+        struct linger lin;
+        lin.l_onoff = 1;
+        lin.l_linger = 0;
+        setsockopt(conn.fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+        stats_.resets++;
+    }
+    close(conn.fd);
+    conn.fd = -1;
+    conn.offset = 0;
+}
+
+bool AdversaryClient::sendBytes(Connection& conn, size_t length) {
+    length = std::min(length, frame_.size() - conn.offset);
+    ssize_t sent = send(conn.fd, frame_.data() + conn.offset, length, MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        stats_.server_closes++;
+        closeConnection(conn, false);
+        return false;
+    }
+    stats_.bytes_sent += sent;
+    conn.offset = (conn.offset + sent) % frame_.size();
+    return true;
+}
+
+bool AdversaryClient::drain(Connection& conn) {
+    char buffer[4096];
+    while (true) {
+        ssize_t received = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        stats_.server_closes++;
+        closeConnection(conn, false);
+        return false;
+    }
+}
+
+void AdversaryClient::step(Connection& conn) {
+    switch (profile_) {
+        case SLOWLORIS:
+            if (sendBytes(conn, 1)) {
+                drain(conn);
+            }
+            break;
+        case SPLIT_HEADER:
+            // 先发长度字段的前半部分，下一次再发其余部分
+            if (sendBytes(conn, conn.offset == 0 ? kFrameHeaderSize / 2 : frame_.size())) {
+                drain(conn);
+            }
+            break;
+        case NO_READ:
+            // 只写不读，每次最多写16个报文
+            for (int i = 0; i < 16; ++i) {
+                long before = stats_.bytes_sent;
+                if (!sendBytes(conn, frame_.size()) || stats_.bytes_sent == before) {
+                    break;
+                }
+            }
+            break;
+        case RST_MID_FRAME:
+            // 发送长度字段和一半数据后立即RST，然后重连
+            if (sendBytes(conn, kFrameHeaderSize + (frame_.size() - kFrameHeaderSize) / 2)) {
+                closeConnection(conn, true);
+                openConnection(conn);
+            }
+            break;
+    }
+}
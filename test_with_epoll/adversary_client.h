@@ -0,0 +1,58 @@
+#ifndef ADVERSARY_CLIENT_H
+#define ADVERSARY_CLIENT_H
+
+#include "pressure_client.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// 异常客户端统计
+struct AdversaryStats {
+    long connections = 0;       // 建立的连接数(含重连)
+    long server_closes = 0;     // 被服务器关闭或发送出错的次数
+    long resets = 0;            // 主动以RST中断的连接数
+    long bytes_sent = 0;
+};
+
+// 行为异常的客户端，与正常压测流量同时运行，用于检验服务器对连接间的隔离
+class AdversaryClient {
+public:
+    enum Profile {
+        SLOWLORIS,          // 每次只发送报文的一个字节
+        SPLIT_HEADER,       // 长度字段分两个TCP段发送
+        NO_READ,            // 只发送不读取，接收窗口被回射填满
+        RST_MID_FRAME       // 发送半个报文后以RST断开
+    };
+
+    AdversaryClient(const ClientConfig& config, Profile profile);
+    ~AdversaryClient();
+
+    void runTest();             // 持续运行直到stopTest()
+    void stopTest();
+    const AdversaryStats& stats() const { return stats_; }
+
+    static bool parseProfile(const std::string& name, Profile& profile);
+    static const char* profileName(Profile profile);
+
+private:
+    struct Connection {
+        int fd = -1;
+        size_t offset = 0;      // 当前报文已发送的字节数
+    };
+
+    bool openConnection(Connection& conn);
+    void closeConnection(Connection& conn, bool reset);
+    bool sendBytes(Connection& conn, size_t length);    // 从当前位置发送length字节，返回false表示连接已断开
+    bool drain(Connection& conn);                       // 读取并丢弃回射
+    void step(Connection& conn);                        // 按画像执行一次动作
+
+private:
+    ClientConfig config_;
+    Profile profile_;
+    std::atomic<bool> running_;
+    AdversaryStats stats_;
+    std::string frame_;                 // 完整报文: 长度字段 + 数据
+    std::vector<Connection> connections_;
+};
+
+#endif // ADVERSARY_CLIENT_H
@@ -0,0 +1,378 @@
+#include "churn_client.h"
+#include "../include/frame.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <iostream>
+#include <cerrno>
+#include <algorithm>
+
+void ChurnStats::merge(const ChurnStats& other) {
+    attempted += other.attempted;
+    completed += other.completed;
+    connect_failures += other.connect_failures;
+    io_failures += other.io_failures;
+    timeouts += other.timeouts;
+    echo_mismatches += other.echo_mismatches;
+    connect_latency.merge(other.connect_latency);
+    first_byte_latency.merge(other.first_byte_latency);
+    close_latency.merge(other.close_latency);
+    session_latency.merge(other.session_latency);
+    if (start_time == std::chrono::steady_clock::time_point() || other.start_time < start_time) {
+        start_time = other.start_time;
+    }
+    if (other.end_time > end_time) {
+        end_time = other.end_time;
+    }
+}
+
+void ChurnStats::reset() {
+    attempted = 0;
+    completed = 0;
+    connect_failures = 0;
+    io_failures = 0;
+    timeouts = 0;
+    echo_mismatches = 0;
+    connect_latency.reset();
+    first_byte_latency.reset();
+    close_latency.reset();
+    session_latency.reset();
+    start_time = std::chrono::steady_clock::time_point();
+    end_time = std::chrono::steady_clock::time_point();
+}
+
+ChurnClient::ChurnClient(const ClientConfig& config, int thread_id)
+    : config_(config), thread_id_(thread_id), epoll_fd_(-1), running_(false),
+      rng_(std::random_device{}() + thread_id) {
+}
+
+ChurnClient::~ChurnClient() {
+    stopTest();
+    for (int fd : active_fds_) {
+        close(fd);
+    }
+    active_fds_.clear();
+    if (epoll_fd_ != -1) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+bool ChurnClient::initialize() {
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ == -1) {
+        std::cerr << "Create epoll failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 所有会话发送同一条报文: 长度字段(网络字节序) + 数据
+    std::vector<char> frame;
+    buildFrame(generatePayload(rng_, std::max(config_.message_size, 1)), frame);
+    message_.assign(frame.data(), frame.size());
+    receive_scratch_.resize(std::max<size_t>(message_.size(), 4096));
+    return true;
+}
+
+void ChurnClient::runTest() {
+    if (epoll_fd_ == -1) {
+        std::cerr << "Churn client not initialized" << std::endl;
+        return;
+    }
+
+    running_ = true;
+    stats_.start_time = std::chrono::steady_clock::now();
+    last_timeout_check_ = stats_.start_time;
+
+    // 各线程错开相位，使合并后的连接间隔均匀
+    schedule_offset_ns_ = 1e9 / config_.churn_rate * thread_id_ / config_.num_threads;
+    next_start_time_ = stats_.start_time + std::chrono::nanoseconds(
+        static_cast<long long>(schedule_offset_ns_));
+
+    size_t max_sessions = std::max(config_.concurrent_connections, 1);
+    std::vector<struct epoll_event> events(max_sessions);
+
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+
+        // 发起所有到期的会话；达到并发上限时保留计划时间，延迟会计入排队时间
+        while (next_start_time_ <= now && active_fds_.size() < max_sessions) {
+            startSession(next_start_time_);
+            advanceSchedule();
+        }
+
+        int wait_ms = 100;
+        if (next_start_time_ <= now) {
+            wait_ms = 1;
+        } else {
+            auto until_next = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next_start_time_ - now).count();
+            wait_ms = static_cast<int>(std::min<long long>(until_next, 100));
+        }
+
+        int num_events = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), wait_ms);
+        if (num_events == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Epoll wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < num_events; ++i) {
+            int fd = events[i].data.fd;
+            if (static_cast<size_t>(fd) < sessions_.size() && sessions_[fd].fd == fd) {
+                handleEvent(sessions_[fd], events[i].events);
+            }
+        }
+
+        checkTimeouts();
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - stats_.start_time);
+        if (elapsed.count() >= config_.test_duration) {
+            break;
+        }
+    }
+
+    // 未完成的会话不计入结果
+    while (!active_fds_.empty()) {
+        abortSession(sessions_[active_fds_.back()]);
+    }
+    stats_.end_time = std::chrono::steady_clock::now();
+    running_ = false;
+}
+
+void ChurnClient::stopTest() {
+    running_ = false;
+}
+
+bool ChurnClient::startSession(std::chrono::steady_clock::time_point intended_time) {
+    stats_.attempted++;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd == -1) {
+        if (stats_.connect_failures++ == 0) {
+            std::cerr << "Create socket failed: " << strerror(errno) << std::endl;
+        }
+        return false;
+    }
+
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    // 以RST关闭连接，本端不进入TIME_WAIT，高速率下不会耗尽临时端口
+    if (config_.churn_rst_close) {
+        struct linger lin;
+        lin.l_onoff = 1;
+        lin.l_linger = 0;
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config_.server_port);
+    inet_pton(AF_INET, config_.server_ip.c_str(), &server_addr.sin_addr);
+
+    auto connect_start = std::chrono::steady_clock::now();
+    int ret = connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr));
+    if (ret == -1 && errno != EINPROGRESS) {
+        // 只打印第一次失败，避免高速率下刷屏
+        if (stats_.connect_failures++ == 0) {
+            std::cerr << "Connect failed: " << strerror(errno) << std::endl;
+        }
+        close(fd);
+        return false;
+    }
+
+    if (static_cast<size_t>(fd) >= sessions_.size()) {
+        sessions_.resize(fd + 1);
+    }
+    Session& session = sessions_[fd];
+    session.fd = fd;
+    session.state = CONNECTING;
+    session.send_offset = 0;
+    session.receive_length = 0;
+    session.intended_time = intended_time;
+    session.connect_start = connect_start;
+    session.list_index = active_fds_.size();
+    active_fds_.push_back(fd);
+
+    // 立即连接成功时同样由第一次EPOLLOUT进入handleConnect
+    struct epoll_event ev;
+    ev.events = EPOLLOUT | EPOLLET;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        std::cerr << "Add epoll event failed: " << strerror(errno) << std::endl;
+        stats_.connect_failures++;
+        releaseSession(session);
+        close(fd);
+        return false;
+    }
+    return true;
+}
+
+void ChurnClient::handleEvent(Session& session, uint32_t events) {
+    if (session.state == CONNECTING) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) || !handleConnect(session)) {
+            return;
+        }
+    }
+    if (session.state == SENDING && (events & EPOLLOUT)) {
+        if (!handleSend(session)) {
+            return;
+        }
+    }
+    if (session.state == RECEIVING && (events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+        handleReceive(session);
+    }
+}
+
+bool ChurnClient::handleConnect(Session& session) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(session.fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1 || error != 0) {
+        if (stats_.connect_failures++ == 0) {
+            std::cerr << "Connect failed: " << strerror(error ? error : errno) << std::endl;
+        }
+        abortSession(session);
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    stats_.connect_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - session.connect_start).count());
+    session.state = SENDING;
+    return true;
+}
+
+bool ChurnClient::handleSend(Session& session) {
+    while (session.send_offset < message_.size()) {
+        ssize_t sent = send(session.fd, message_.data() + session.send_offset,
+                            message_.size() - session.send_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 等待下一次EPOLLOUT
+                return false;
+            }
+            stats_.io_failures++;
+            abortSession(session);
+            return false;
+        }
+        session.send_offset += sent;
+    }
+
+    session.send_time = std::chrono::steady_clock::now();
+    session.state = RECEIVING;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = session.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, session.fd, &ev);
+    return true;
+}
+
+bool ChurnClient::handleReceive(Session& session) {
+    while (true) {
+        ssize_t received = recv(session.fd, receive_scratch_.data(), receive_scratch_.size(), 0);
+        if (received > 0) {
+            if (session.receive_length == 0) {
+                stats_.first_byte_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - session.send_time).count());
+            }
+            // 回射内容应与请求逐字节一致
+            size_t expected = std::min<size_t>(received, message_.size() - session.receive_length);
+            if (static_cast<size_t>(received) != expected ||
+                memcmp(receive_scratch_.data(), message_.data() + session.receive_length, expected) != 0) {
+                stats_.echo_mismatches++;
+                abortSession(session);
+                return false;
+            }
+            session.receive_length += received;
+            if (session.receive_length == message_.size()) {
+                finishSession(session);
+                return true;
+            }
+        } else if (received == 0) {
+            stats_.io_failures++;
+            abortSession(session);
+            return false;
+        } else {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            stats_.io_failures++;
+            abortSession(session);
+            return false;
+        }
+    }
+}
+
+void ChurnClient::finishSession(Session& session) {
+    int fd = session.fd;
+    releaseSession(session);
+
+    // close()会同时从epoll中移除该fd
+    auto close_start = std::chrono::steady_clock::now();
+    close(fd);
+    auto now = std::chrono::steady_clock::now();
+
+    stats_.close_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - close_start).count());
+    stats_.session_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - session.intended_time).count());
+    stats_.completed++;
+}
+
+void ChurnClient::abortSession(Session& session) {
+    int fd = session.fd;
+    releaseSession(session);
+    close(fd);
+}
+
+void ChurnClient::releaseSession(Session& session) {
+    // 与末尾元素交换后删除，保持active_fds_紧凑
+    int last_fd = active_fds_.back();
+    active_fds_[session.list_index] = last_fd;
+    sessions_[last_fd].list_index = session.list_index;
+    active_fds_.pop_back();
+    session.fd = -1;
+}
+
+void ChurnClient::checkTimeouts() {
+    // 进行中的会话数受并发上限约束，每10ms线性扫描一次即可
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_timeout_check_ < std::chrono::milliseconds(10)) {
+        return;
+    }
+    last_timeout_check_ = now;
+
+    auto timeout = std::chrono::milliseconds(config_.timeout_ms);
+    for (size_t i = 0; i < active_fds_.size(); ) {
+        Session& session = sessions_[active_fds_[i]];
+        if (now - session.connect_start > timeout) {
+            stats_.timeouts++;
+            abortSession(session);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void ChurnClient::advanceSchedule() {
+    // 每个线程承担 churn_rate/num_threads 的连接速率
+    double thread_rate = config_.churn_rate / config_.num_threads;
+    if (config_.poisson_arrivals) {
+        std::exponential_distribution<double> interval(thread_rate);
+        schedule_offset_ns_ += interval(rng_) * 1e9;
+    } else {
+        schedule_offset_ns_ += 1e9 / thread_rate;
+    }
+    next_start_time_ = stats_.start_time + std::chrono::nanoseconds(
+        static_cast<long long>(schedule_offset_ns_));
+}
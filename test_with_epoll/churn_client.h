@@ -0,0 +1,87 @@
+#ifndef CHURN_CLIENT_H
+#define CHURN_CLIENT_H
+
+#include "pressure_client.h"
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include "../include/latency_histogram.h"
+
+// 短连接测试统计: 每个会话为 连接 -> 一次请求 -> 关闭
+struct ChurnStats {
+    long attempted = 0;                 // 发起的连接数
+    long completed = 0;                 // 完整走完一次会话的连接数
+    long connect_failures = 0;          // 连接失败(含端口耗尽、被拒绝)
+    long io_failures = 0;               // 连接成功后收发出错或被对端关闭
+    long timeouts = 0;                  // 超时未完成的会话
+    long echo_mismatches = 0;           // 回射内容不一致
+    LatencyHistogram connect_latency;   // connect()到可写(握手完成)
+    LatencyHistogram first_byte_latency;// 请求发出到收到第一个字节
+    LatencyHistogram close_latency;     // close()调用耗时
+    LatencyHistogram session_latency;   // 计划开始时间到关闭完成，包含排队等待
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point end_time;
+
+    void merge(const ChurnStats& other);
+    void reset();
+};
+
+// 单线程短连接压测：按目标速率(连接/秒)开环发起会话，每个会话只发一条消息
+class ChurnClient {
+public:
+    ChurnClient(const ClientConfig& config, int thread_id = 0);
+    ~ChurnClient();
+
+    bool initialize();
+    void runTest();
+    void stopTest();
+    const ChurnStats& stats() const { return stats_; }
+
+private:
+    enum SessionState {
+        CONNECTING,
+        SENDING,
+        RECEIVING
+    };
+
+    struct Session {
+        int fd = -1;
+        SessionState state = CONNECTING;
+        size_t send_offset = 0;                 // 请求已发送的字节数
+        size_t receive_length = 0;              // 回射已接收的字节数
+        size_t list_index = 0;                  // 在active_fds_中的位置
+        std::chrono::steady_clock::time_point intended_time;   // 计划开始时间
+        std::chrono::steady_clock::time_point connect_start;   // 调用connect()的时间
+        std::chrono::steady_clock::time_point send_time;       // 请求发送完成的时间
+    };
+
+    bool startSession(std::chrono::steady_clock::time_point intended_time);
+    void handleEvent(Session& session, uint32_t events);
+    bool handleConnect(Session& session);
+    bool handleSend(Session& session);
+    bool handleReceive(Session& session);
+    void finishSession(Session& session);       // 会话完成，关闭并记录延迟
+    void abortSession(Session& session);        // 会话失败，直接关闭
+    void releaseSession(Session& session);
+    void checkTimeouts();
+    void advanceSchedule();
+
+private:
+    ClientConfig config_;
+    int thread_id_;
+    int epoll_fd_;
+    std::atomic<bool> running_;
+    ChurnStats stats_;
+    std::string message_;                       // 每个会话发送的完整报文(含长度字段)
+    std::vector<char> receive_scratch_;         // 接收缓冲区，所有会话共用
+    std::vector<Session> sessions_;             // 按fd下标索引
+    std::vector<int> active_fds_;               // 进行中的会话
+    std::chrono::steady_clock::time_point next_start_time_;    // 下一次计划发起连接的时间
+    double schedule_offset_ns_ = 0;                             // 相对start_time的计划偏移
+    std::chrono::steady_clock::time_point last_timeout_check_;
+    std::mt19937_64 rng_;                       // 泊松间隔随机数
+};
+
+#endif // CHURN_CLIENT_H
@@ -0,0 +1,41 @@
+#ifndef CLIENT_UTIL_H
+#define CLIENT_UTIL_H
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// 阻塞连接服务器并关闭Nagle，成功返回fd，失败返回-1
+// 大量连接同时失败时只需报告一次原因，report为false时不输出
+inline int connectBlocking(const std::string& server_ip, int server_port, bool report) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        std::cerr << "Create socket failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(server_port);
+    inet_pton(AF_INET, server_ip.c_str(), &server_addr.sin_addr);
+
+    if (connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) == -1) {
+        if (report) {
+            std::cerr << "Connect failed: " << strerror(errno) << std::endl;
+        }
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#endif // CLIENT_UTIL_H
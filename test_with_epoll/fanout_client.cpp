@@ -0,0 +1,329 @@
+#include "fanout_client.h"
+#include "client_util.h"
+#include "../include/pubsub.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <iostream>
+#include <cerrno>
+#include <algorithm>
+
+// 发布数据: 8字节序号 + 8字节计划发布时间(steady_clock纳秒) + 填充
+static const size_t kFanoutHeaderSize = 2 * sizeof(uint64_t);
+
+void FanoutStats::merge(const FanoutStats& other) {
+    subscribers += other.subscribers;
+    connect_failures += other.connect_failures;
+    published += other.published;
+    delivered += other.delivered;
+    gaps += other.gaps;
+    disconnects += other.disconnects;
+    invalid += other.invalid;
+    latency.merge(other.latency);
+    if (start_time == std::chrono::steady_clock::time_point() || other.start_time < start_time) {
+        start_time = other.start_time;
+    }
+    if (other.end_time > end_time) {
+        end_time = other.end_time;
+    }
+}
+
+void FanoutStats::reset() {
+    subscribers = 0;
+    connect_failures = 0;
+    published = 0;
+    delivered = 0;
+    gaps = 0;
+    disconnects = 0;
+    invalid = 0;
+    latency.reset();
+    start_time = std::chrono::steady_clock::time_point();
+    end_time = std::chrono::steady_clock::time_point();
+}
+
+FanoutClient::FanoutClient(const ClientConfig& config, int thread_id, int subscribers, bool publisher)
+    : config_(config), thread_id_(thread_id), subscriber_count_(subscribers), is_publisher_(publisher),
+      epoll_fd_(-1), running_(false), topic_("bench"), publish_fd_(-1), publish_offset_(0),
+      next_seq_(0), publish_rate_(config.rate > 0 ? config.rate : 1000),
+      rng_(std::random_device{}() + thread_id) {
+}
+
+FanoutClient::~FanoutClient() {
+    stopTest();
+    for (auto& subscriber : subscribers_) {
+        if (subscriber.fd != -1) {
+            close(subscriber.fd);
+        }
+    }
+    subscribers_.clear();
+    if (publish_fd_ != -1) {
+        close(publish_fd_);
+        publish_fd_ = -1;
+    }
+    if (epoll_fd_ != -1) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+bool FanoutClient::initialize() {
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ == -1) {
+        std::cerr << "Create epoll failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    receive_scratch_.resize(256 * 1024);
+    size_t body_size = std::max<size_t>(config_.message_size, kFanoutHeaderSize) - kFanoutHeaderSize;
+    body_ = generatePayload(rng_, static_cast<int>(body_size));
+
+    // 订阅请求在阻塞模式下发出，之后切换为非阻塞等待确认
+    buildPubSubFrame(kOpSubscribe, topic_, nullptr, 0, frame_);
+    for (int i = 0; i < subscriber_count_; ++i) {
+        int fd = connectBlocking(config_.server_ip, config_.server_port, stats_.connect_failures == 0);
+        if (fd == -1) {
+            stats_.connect_failures++;
+            continue;
+        }
+        if (send(fd, frame_.data(), frame_.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(frame_.size())) {
+            std::cerr << "Send subscribe failed: " << strerror(errno) << std::endl;
+            stats_.connect_failures++;
+            close(fd);
+            continue;
+        }
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+        if (static_cast<size_t>(fd) >= subscribers_.size()) {
+            subscribers_.resize(fd + 1);
+        }
+        subscribers_[fd].fd = fd;
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    if (is_publisher_) {
+        publish_fd_ = connectBlocking(config_.server_ip, config_.server_port, stats_.connect_failures == 0);
+        if (publish_fd_ == -1) {
+            return false;
+        }
+        int flags = fcntl(publish_fd_, F_GETFL, 0);
+        fcntl(publish_fd_, F_SETFL, flags | O_NONBLOCK);
+        struct epoll_event ev;
+        ev.events = EPOLLOUT | EPOLLET;
+        ev.data.fd = publish_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, publish_fd_, &ev);
+    }
+    return waitSubscribed();
+}
+
+bool FanoutClient::waitSubscribed() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.timeout_ms);
+    std::vector<struct epoll_event> events(1024);
+    while (stats_.subscribers + stats_.disconnects + stats_.connect_failures < subscriber_count_) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            std::cerr << "[Thread " << thread_id_ << "] Only " << stats_.subscribers << "/"
+                      << subscriber_count_ << " subscriptions confirmed" << std::endl;
+            return false;
+        }
+        int wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - now).count());
+        int num_events = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), wait_ms);
+        for (int i = 0; i < num_events; ++i) {
+            int fd = events[i].data.fd;
+            if (static_cast<size_t>(fd) < subscribers_.size() && subscribers_[fd].fd == fd) {
+                handleReceive(subscribers_[fd]);
+            }
+        }
+    }
+    return true;
+}
+
+void FanoutClient::runTest() {
+    if (epoll_fd_ == -1) {
+        std::cerr << "Fanout client not initialized" << std::endl;
+        return;
+    }
+
+    running_ = true;
+    stats_.start_time = std::chrono::steady_clock::now();
+    next_publish_time_ = stats_.start_time;
+    auto publish_end = stats_.start_time + std::chrono::seconds(config_.test_duration);
+    // 停止发布后再接收一段时间，收完在途的报文
+    auto test_end = publish_end + std::chrono::milliseconds(500);
+
+    std::vector<struct epoll_event> events(1024);
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= test_end) {
+            break;
+        }
+
+        int wait_ms = 100;
+        if (is_publisher_ && now < publish_end) {
+            publishDue(now);
+            if (!flushPublish()) {
+                std::cerr << "Publisher connection failed" << std::endl;
+                break;
+            }
+            auto until_next = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next_publish_time_ - now).count();
+            wait_ms = static_cast<int>(std::max<long long>(std::min<long long>(until_next, 100), 0));
+        }
+
+        int num_events = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), wait_ms);
+        if (num_events == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Epoll wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < num_events; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == publish_fd_) {
+                continue;   // 可写时由下一轮flushPublish()继续发送
+            }
+            if (static_cast<size_t>(fd) < subscribers_.size() && subscribers_[fd].fd == fd) {
+                handleReceive(subscribers_[fd]);
+            }
+        }
+    }
+    stats_.end_time = std::chrono::steady_clock::now();
+    running_ = false;
+}
+
+void FanoutClient::stopTest() {
+    running_ = false;
+}
+
+void FanoutClient::publishDue(std::chrono::steady_clock::time_point now) {
+    // 开环发布: 落后于计划时不丢弃，延迟从计划时间算起
+    std::vector<char> data(kFanoutHeaderSize + body_.size());
+    memcpy(data.data() + kFanoutHeaderSize, body_.data(), body_.size());
+    while (next_publish_time_ <= now) {
+        uint64_t intended_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            next_publish_time_.time_since_epoch()).count();
+        memcpy(data.data(), &next_seq_, sizeof(next_seq_));
+        memcpy(data.data() + sizeof(uint64_t), &intended_ns, sizeof(intended_ns));
+        buildPubSubFrame(kOpPublish, topic_, data.data(), data.size(), frame_);
+        publish_buffer_.insert(publish_buffer_.end(), frame_.begin(), frame_.end());
+
+        next_seq_++;
+        stats_.published++;
+        next_publish_time_ = stats_.start_time + std::chrono::nanoseconds(
+            static_cast<long long>(next_seq_ * 1e9 / publish_rate_));
+    }
+}
+
+bool FanoutClient::flushPublish() {
+    while (publish_offset_ < publish_buffer_.size()) {
+        ssize_t sent = send(publish_fd_, publish_buffer_.data() + publish_offset_,
+                            publish_buffer_.size() - publish_offset_, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            return false;
+        }
+        publish_offset_ += sent;
+    }
+    publish_buffer_.clear();
+    publish_offset_ = 0;
+    return true;
+}
+
+bool FanoutClient::handleReceive(Subscriber& subscriber) {
+    while (true) {
+        ssize_t received = recv(subscriber.fd, receive_scratch_.data(), receive_scratch_.size(), 0);
+        if (received > 0) {
+            auto now = std::chrono::steady_clock::now();
+            if (subscriber.pending.empty()) {
+                // 常见情况: 直接解析接收缓冲区，只保存不完整的尾部
+                size_t consumed = parseFrames(subscriber, receive_scratch_.data(), received, now);
+                if (subscriber.fd == -1) {
+                    return false;
+                }
+                subscriber.pending.assign(receive_scratch_.data() + consumed, receive_scratch_.data() + received);
+            } else {
+                subscriber.pending.insert(subscriber.pending.end(), receive_scratch_.data(),
+                                          receive_scratch_.data() + received);
+                size_t consumed = parseFrames(subscriber, subscriber.pending.data(), subscriber.pending.size(), now);
+                if (subscriber.fd == -1) {
+                    return false;
+                }
+                subscriber.pending.erase(subscriber.pending.begin(), subscriber.pending.begin() + consumed);
+            }
+        } else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            stats_.disconnects++;
+            closeSubscriber(subscriber);
+            return false;
+        } else if (errno != EINTR) {
+            return true;
+        }
+    }
+}
+
+size_t FanoutClient::parseFrames(Subscriber& subscriber, const char* data, size_t length,
+                                 std::chrono::steady_clock::time_point now) {
+    size_t offset = 0;
+    while (length - offset >= kFrameHeaderSize) {
+        uint32_t msg_length = decodeFrameHeader(data + offset);
+        if (isErrorFrameHeader(msg_length)) {
+            stats_.invalid++;
+            closeSubscriber(subscriber);
+            return length;
+        }
+        size_t frame_size = kFrameHeaderSize + msg_length;
+        if (length - offset < frame_size) {
+            break;
+        }
+
+        char op;
+        std::string_view topic;
+        std::string_view payload;
+        if (!parsePubSubPayload(data + offset + kFrameHeaderSize, msg_length, op, topic, payload) ||
+            topic != topic_) {
+            stats_.invalid++;
+        } else if (op == kOpSubscribe) {
+            if (!subscriber.subscribed) {
+                subscriber.subscribed = true;
+                stats_.subscribers++;
+            }
+        } else if (op == kOpPublish && payload.size() >= kFanoutHeaderSize) {
+            uint64_t seq;
+            uint64_t intended_ns;
+            memcpy(&seq, payload.data(), sizeof(seq));
+            memcpy(&intended_ns, payload.data() + sizeof(uint64_t), sizeof(intended_ns));
+            // 序号跳跃说明中间的报文被服务器丢弃
+            if (seq > subscriber.next_seq) {
+                stats_.gaps += seq - subscriber.next_seq;
+            }
+            subscriber.next_seq = seq + 1;
+            stats_.delivered++;
+            int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now.time_since_epoch()).count();
+            stats_.latency.record(now_ns - static_cast<int64_t>(intended_ns));
+        } else {
+            stats_.invalid++;
+        }
+        offset += frame_size;
+    }
+    return offset;
+}
+
+void FanoutClient::closeSubscriber(Subscriber& subscriber) {
+    if (subscriber.fd == -1) {
+        return;
+    }
+    close(subscriber.fd);
+    subscriber.fd = -1;
+    subscriber.pending.clear();
+}
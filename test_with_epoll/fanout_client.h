@@ -0,0 +1,78 @@
+#ifndef FANOUT_CLIENT_H
+#define FANOUT_CLIENT_H
+
+#include "pressure_client.h"
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include "../include/latency_histogram.h"
+
+// 发布订阅扇出测试统计
+struct FanoutStats {
+    long subscribers = 0;               // 订阅成功的连接数
+    long connect_failures = 0;          // 连接或订阅失败
+    long published = 0;                 // 发布的报文数
+    long delivered = 0;                 // 订阅者收到的报文数
+    long gaps = 0;                      // 按序号推算未送达的报文数(被丢弃或断开)
+    long disconnects = 0;               // 订阅连接被服务器断开
+    long invalid = 0;                   // 格式错误的报文
+    LatencyHistogram latency;           // 计划发布时间到订阅者收到
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point end_time;
+
+    void merge(const FanoutStats& other);
+    void reset();
+};
+
+// 单线程扇出压测：管理一部分订阅连接，发布线程另有一个发布连接按目标速率开环发布
+class FanoutClient {
+public:
+    FanoutClient(const ClientConfig& config, int thread_id, int subscribers, bool publisher);
+    ~FanoutClient();
+
+    bool initialize();      // 建立订阅连接并等到全部确认，之后才开始发布
+    void runTest();
+    void stopTest();
+    const FanoutStats& stats() const { return stats_; }
+
+private:
+    struct Subscriber {
+        int fd = -1;
+        bool subscribed = false;                // 已收到订阅确认
+        uint64_t next_seq = 0;                  // 期望的下一个序号
+        std::vector<char> pending;              // 上次未解析完的数据
+    };
+
+    bool waitSubscribed();                      // 等待所有订阅确认
+    bool handleReceive(Subscriber& subscriber); // 返回false表示连接已断开
+    size_t parseFrames(Subscriber& subscriber, const char* data, size_t length,
+                       std::chrono::steady_clock::time_point now);
+    void closeSubscriber(Subscriber& subscriber);
+    void publishDue(std::chrono::steady_clock::time_point now);   // 发布所有到期的报文
+    bool flushPublish();
+
+private:
+    ClientConfig config_;
+    int thread_id_;
+    int subscriber_count_;
+    bool is_publisher_;
+    int epoll_fd_;
+    std::atomic<bool> running_;
+    FanoutStats stats_;
+    std::vector<Subscriber> subscribers_;       // 按fd下标索引
+    std::vector<char> receive_scratch_;         // 接收缓冲区，所有订阅连接共用
+    std::string topic_;
+    std::string body_;                          // 发布数据中序号和时间戳之后的填充
+    int publish_fd_;
+    std::vector<char> publish_buffer_;          // 待发送的发布报文
+    size_t publish_offset_;
+    std::vector<char> frame_;                   // 构建报文的临时缓冲区
+    uint64_t next_seq_;
+    double publish_rate_;
+    std::chrono::steady_clock::time_point next_publish_time_;
+    std::mt19937 rng_;
+};
+
+#endif // FANOUT_CLIENT_H
@@ -0,0 +1,55 @@
+#ifndef KEY_DISTRIBUTION_H
+#define KEY_DISTRIBUTION_H
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+// 键编号分布: 均匀分布，或YCSB使用的Zipfian分布(Gray等人的方法，预先计算zeta(n))
+// theta越接近1越偏斜，0.99时前1%的键约占一半访问
+class KeyDistribution {
+public:
+    KeyDistribution(uint64_t keys, bool zipfian, double theta)
+        : keys_(keys > 0 ? keys : 1), zipfian_(zipfian), theta_(theta),
+          zetan_(0), alpha_(0), eta_(0), half_pow_theta_(0) {
+        if (!zipfian_) {
+            return;
+        }
+        for (uint64_t i = 1; i <= keys_; ++i) {
+            zetan_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+        }
+        double zeta2 = 1.0 + std::pow(0.5, theta_);
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1.0 - std::pow(2.0 / keys_, 1.0 - theta_)) / (1.0 - zeta2 / zetan_);
+        half_pow_theta_ = std::pow(0.5, theta_);
+    }
+
+    // 返回[0, keys)中的编号，Zipfian下编号越小越热
+    template <typename Rng>
+    uint64_t next(Rng& rng) {
+        if (!zipfian_) {
+            return std::uniform_int_distribution<uint64_t>(0, keys_ - 1)(rng);
+        }
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double uz = u * zetan_;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + half_pow_theta_) {
+            return 1;
+        }
+        uint64_t key = static_cast<uint64_t>(keys_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return key < keys_ ? key : keys_ - 1;
+    }
+
+private:
+    uint64_t keys_;
+    bool zipfian_;
+    double theta_;
+    double zetan_;
+    double alpha_;
+    double eta_;
+    double half_pow_theta_;
+};
+
+#endif // KEY_DISTRIBUTION_H
@@ -0,0 +1,270 @@
+#include "kv_client.h"
+#include "client_util.h"
+#include "../include/kv_protocol.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <cerrno>
+#include <algorithm>
+
+void KvStats::merge(const KvStats& other) {
+    connections += other.connections;
+    connect_failures += other.connect_failures;
+    gets += other.gets;
+    sets += other.sets;
+    hits += other.hits;
+    misses += other.misses;
+    errors += other.errors;
+    mismatches += other.mismatches;
+    disconnects += other.disconnects;
+    latency.merge(other.latency);
+    if (start_time == std::chrono::steady_clock::time_point() || other.start_time < start_time) {
+        start_time = other.start_time;
+    }
+    if (other.end_time > end_time) {
+        end_time = other.end_time;
+    }
+}
+
+void KvStats::reset() {
+    connections = 0;
+    connect_failures = 0;
+    gets = 0;
+    sets = 0;
+    hits = 0;
+    misses = 0;
+    errors = 0;
+    mismatches = 0;
+    disconnects = 0;
+    latency.reset();
+    start_time = std::chrono::steady_clock::time_point();
+    end_time = std::chrono::steady_clock::time_point();
+}
+
+KvClient::KvClient(const ClientConfig& config, int thread_id, int connections)
+    : config_(config), thread_id_(thread_id), connection_count_(connections), epoll_fd_(-1),
+      running_(false), distribution_(config.kv_keys, config.kv_distribution == "zipf", config.zipf_theta),
+      rng_(std::random_device{}() + thread_id) {
+}
+
+KvClient::~KvClient() {
+    stopTest();
+    for (auto& connection : connections_) {
+        if (connection.fd != -1) {
+            close(connection.fd);
+        }
+    }
+    connections_.clear();
+    if (epoll_fd_ != -1) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+bool KvClient::initialize() {
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ == -1) {
+        std::cerr << "Create epoll failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    receive_scratch_.resize(256 * 1024);
+    size_t value_size = std::max<size_t>(config_.message_size, sizeof(uint64_t));
+    value_ = generatePayload(rng_, static_cast<int>(value_size));
+
+    for (int i = 0; i < connection_count_; ++i) {
+        int fd = connectBlocking(config_.server_ip, config_.server_port, stats_.connect_failures == 0);
+        if (fd == -1) {
+            stats_.connect_failures++;
+            continue;
+        }
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+        if (static_cast<size_t>(fd) >= connections_.size()) {
+            connections_.resize(fd + 1);
+        }
+        connections_[fd].fd = fd;
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        stats_.connections++;
+    }
+    return stats_.connections > 0;
+}
+
+void KvClient::runTest() {
+    if (epoll_fd_ == -1) {
+        std::cerr << "KV client not initialized" << std::endl;
+        return;
+    }
+
+    running_ = true;
+    stats_.start_time = std::chrono::steady_clock::now();
+    auto test_end = stats_.start_time + std::chrono::seconds(config_.test_duration);
+    for (auto& connection : connections_) {
+        if (connection.fd != -1) {
+            issue(connection);
+            if (!flush(connection)) {
+                stats_.disconnects++;
+                closeConnection(connection);
+            }
+        }
+    }
+
+    std::vector<struct epoll_event> events(1024);
+    while (running_ && std::chrono::steady_clock::now() < test_end) {
+        int num_events = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), 100);
+        if (num_events == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Epoll wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < num_events; ++i) {
+            int fd = events[i].data.fd;
+            if (static_cast<size_t>(fd) >= connections_.size() || connections_[fd].fd != fd) {
+                continue;
+            }
+            Connection& connection = connections_[fd];
+            if ((events[i].events & EPOLLIN) && !handleReceive(connection)) {
+                continue;
+            }
+            // 收到响应后立即补足流水线，保持闭环
+            issue(connection);
+            if (!flush(connection)) {
+                stats_.disconnects++;
+                closeConnection(connection);
+            }
+        }
+    }
+    stats_.end_time = std::chrono::steady_clock::now();
+    running_ = false;
+}
+
+void KvClient::stopTest() {
+    running_ = false;
+}
+
+void KvClient::issue(Connection& connection) {
+    std::uniform_real_distribution<double> op_choice(0.0, 1.0);
+    auto now = std::chrono::steady_clock::now();
+    char key[32];
+    while (static_cast<int>(connection.in_flight.size()) < config_.pipeline_depth) {
+        Request request;
+        request.op = op_choice(rng_) < config_.kv_set_ratio ? kKvSet : kKvGet;
+        request.key_id = distribution_.next(rng_);
+        request.send_time = now;
+        int key_length = snprintf(key, sizeof(key), "key:%llu", static_cast<unsigned long long>(request.key_id));
+        if (request.op == kKvSet) {
+            // 值以键编号开头，GET命中时据此验证
+            memcpy(&value_[0], &request.key_id, sizeof(request.key_id));
+            appendKvRequest(kKvSet, std::string_view(key, key_length), value_, connection.output);
+            stats_.sets++;
+        } else {
+            appendKvRequest(kKvGet, std::string_view(key, key_length), std::string_view(), connection.output);
+            stats_.gets++;
+        }
+        connection.in_flight.push_back(request);
+    }
+}
+
+bool KvClient::flush(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.output_offset,
+                            connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            return false;
+        }
+        connection.output_offset += sent;
+    }
+    connection.output.clear();
+    connection.output_offset = 0;
+    return true;
+}
+
+bool KvClient::handleReceive(Connection& connection) {
+    while (true) {
+        ssize_t received = recv(connection.fd, receive_scratch_.data(), receive_scratch_.size(), 0);
+        if (received > 0) {
+            connection.pending.insert(connection.pending.end(), receive_scratch_.data(),
+                                      receive_scratch_.data() + received);
+            size_t consumed = parseResponses(connection, connection.pending.data(), connection.pending.size());
+            if (connection.fd == -1) {
+                return false;
+            }
+            connection.pending.erase(connection.pending.begin(), connection.pending.begin() + consumed);
+        } else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            stats_.disconnects++;
+            closeConnection(connection);
+            return false;
+        } else if (errno != EINTR) {
+            return true;
+        }
+    }
+}
+
+size_t KvClient::parseResponses(Connection& connection, const char* data, size_t length) {
+    auto now = std::chrono::steady_clock::now();
+    size_t offset = 0;
+    while (length - offset >= kFrameHeaderSize) {
+        uint32_t msg_length = decodeFrameHeader(data + offset);
+        if (isErrorFrameHeader(msg_length) || msg_length == 0 || connection.in_flight.empty()) {
+            if (isErrorFrameHeader(msg_length) && length - offset >= kFrameHeaderSize + sizeof(uint32_t)) {
+                uint32_t code = decodeFrameHeader(data + offset + kFrameHeaderSize);
+                std::cerr << "[Thread " << thread_id_ << "] Server error: " << frameErrorName(code) << std::endl;
+            }
+            stats_.errors++;
+            closeConnection(connection);
+            return length;
+        }
+        size_t frame_size = kFrameHeaderSize + msg_length;
+        if (length - offset < frame_size) {
+            break;
+        }
+
+        const Request& request = connection.in_flight.front();
+        const char* payload = data + offset + kFrameHeaderSize;
+        char status = payload[0];
+        if (status == kKvError) {
+            stats_.errors++;
+        } else if (request.op == kKvGet && status == kKvOk) {
+            uint64_t key_id = 0;
+            if (msg_length - 1 >= sizeof(key_id)) {
+                memcpy(&key_id, payload + 1, sizeof(key_id));
+            }
+            if (msg_length - 1 != value_.size() || key_id != request.key_id) {
+                stats_.mismatches++;
+            }
+            stats_.hits++;
+        } else if (request.op == kKvGet) {
+            stats_.misses++;
+        }
+        stats_.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - request.send_time).count());
+        connection.in_flight.pop_front();
+        offset += frame_size;
+    }
+    return offset;
+}
+
+void KvClient::closeConnection(Connection& connection) {
+    if (connection.fd == -1) {
+        return;
+    }
+    close(connection.fd);
+    connection.fd = -1;
+    connection.pending.clear();
+    connection.in_flight.clear();
+}
@@ -0,0 +1,80 @@
+#ifndef KV_CLIENT_H
+#define KV_CLIENT_H
+
+#include "pressure_client.h"
+#include "key_distribution.h"
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include "../include/latency_histogram.h"
+
+// 键值负载测试统计
+struct KvStats {
+    long connections = 0;               // 建立成功的连接数
+    long connect_failures = 0;
+    long gets = 0;
+    long sets = 0;
+    long hits = 0;                      // GET命中
+    long misses = 0;                    // GET未命中
+    long errors = 0;                    // 服务器回复错误状态(如值过大)
+    long mismatches = 0;                // GET返回的值与键不符
+    long disconnects = 0;               // 连接被服务器断开
+    LatencyHistogram latency;           // 命令发出到收到响应
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point end_time;
+
+    void merge(const KvStats& other);
+    void reset();
+};
+
+// 单线程键值压测: 每个连接闭环保持pipeline_depth条在途命令，键按配置的分布选取
+class KvClient {
+public:
+    KvClient(const ClientConfig& config, int thread_id, int connections);
+    ~KvClient();
+
+    bool initialize();
+    void runTest();
+    void stopTest();
+    const KvStats& stats() const { return stats_; }
+
+private:
+    // 已发送待响应的命令
+    struct Request {
+        char op;
+        uint64_t key_id;
+        std::chrono::steady_clock::time_point send_time;
+    };
+
+    struct Connection {
+        int fd = -1;
+        std::vector<char> output;           // 待发送的命令
+        size_t output_offset = 0;
+        std::vector<char> pending;          // 上次未解析完的响应
+        std::deque<Request> in_flight;      // 响应按发送顺序返回
+    };
+
+    void issue(Connection& connection);         // 补足在途命令
+    bool flush(Connection& connection);         // 返回false表示发送出错
+    bool handleReceive(Connection& connection); // 返回false表示连接已断开
+    size_t parseResponses(Connection& connection, const char* data, size_t length);
+    void closeConnection(Connection& connection);
+
+private:
+    ClientConfig config_;
+    int thread_id_;
+    int connection_count_;
+    int epoll_fd_;
+    std::atomic<bool> running_;
+    KvStats stats_;
+    std::vector<Connection> connections_;       // 按fd下标索引
+    std::vector<char> receive_scratch_;         // 接收缓冲区，所有连接共用
+    std::string value_;                         // SET的值: 8字节键编号 + 填充
+    KeyDistribution distribution_;
+    std::mt19937_64 rng_;
+};
+
+#endif // KV_CLIENT_H
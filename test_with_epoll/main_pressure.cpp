@@ -1,9 +1,14 @@
-#include "pressure_client.h"
+#include "pressure_test.h"
+#include <sys/resource.h>
+#include <arpa/inet.h>
 #include <iostream>
 #include <csignal>
 #include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sstream>
 
-PressureClient* g_client = nullptr;
+PressureTest* g_client = nullptr;
 
 void signalHandler(int signal) {
     std::cout << "\nReceived signal " << signal << ", stopping test..." << std::endl;
@@ -13,6 +18,49 @@ void signalHandler(int signal) {
     exit(0);
 }
 
+// 解析逗号分隔的本端地址，A.B.C.D-E表示最后一段从D到E的连续地址
+static bool parseSourceIps(const std::string& list, std::vector<std::string>& ips) {
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t dash = item.find('-');
+        size_t dot = item.rfind('.', dash);
+        if (dash == std::string::npos || dot == std::string::npos) {
+            ips.push_back(item);
+            continue;
+        }
+        std::string prefix = item.substr(0, dot + 1);
+        int first = std::atoi(item.substr(dot + 1, dash - dot - 1).c_str());
+        int last = std::atoi(item.substr(dash + 1).c_str());
+        if (first < 0 || last > 255 || first > last) {
+            std::cerr << "Invalid source address range: " << item << std::endl;
+            return false;
+        }
+        for (int i = first; i <= last; ++i) {
+            ips.push_back(prefix + std::to_string(i));
+        }
+    }
+    for (const std::string& ip : ips) {
+        struct in_addr addr;
+        if (inet_pton(AF_INET, ip.c_str(), &addr) != 1) {
+            std::cerr << "Invalid source address: " << ip << std::endl;
+            return false;
+        }
+    }
+    return !ips.empty();
+}
+
+// 几十万连接需要同样多的fd，把软限制提到硬限制
+static void raiseFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) == -1) {
+            std::cerr << "Raise open file limit failed: " << strerror(errno) << std::endl;
+        }
+    }
+}
+
 void printUsage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [options]" << std::endl;
     std::cout << "Options:" << std::endl;
@@ -22,7 +70,39 @@ void printUsage(const char* program_name) {
     std::cout << "  -n CONCURRENT Concurrent connections (default: 100)" << std::endl;
     std::cout << "  -m MESSAGES    Messages per connection (default: 10)" << std::endl;
     std::cout << "  -s SIZE        Message size in bytes (default: 1024)" << std::endl;
+    std::cout << "  --size-dist SPEC  Message size distribution instead of fixed -s:" << std::endl;
+    std::cout << "                 uniform:MIN,MAX  lognormal:MEDIAN,SIGMA[,MAX]  bimodal:SMALL,LARGE,P" << std::endl;
+    std::cout << "                 zipf:MIN,MAX[,THETA]  file:PATH (lines of \"size weight\")" << std::endl;
     std::cout << "  -t SECONDS     Test duration in seconds (default: 30)" << std::endl;
+    std::cout << "  -T THREADS     Worker threads, one epoll loop each (default: 1)" << std::endl;
+    std::cout << "  --rate RPS[,RPS...]  Open-loop constant rate; a list runs a rate sweep" << std::endl;
+    std::cout << "  --poisson      Poisson arrivals in open-loop mode (default: uniform)" << std::endl;
+    std::cout << "  --depth N      Requests kept in flight per connection (default: 1)" << std::endl;
+    std::cout << "  --timeout MS   Close connections idle this long with requests in flight (default: 5000)" << std::endl;
+    std::cout << "  --crc          Append a CRC32C trailer and verify echoes by checksum" << std::endl;
+    std::cout << "  --adversary LIST  Run a baseline, then each profile alongside normal traffic:" << std::endl;
+    std::cout << "                 slowloris,split-header,no-read,rst" << std::endl;
+    std::cout << "  --adversary-conns N     Misbehaving connections (default: 16)" << std::endl;
+    std::cout << "  --adversary-interval MS Delay between misbehaving actions (default: 10)" << std::endl;
+    std::cout << "  --json FILE    Also write the results to FILE as JSON" << std::endl;
+    std::cout << "  --churn CPS    Short-connection mode: connect, one request, close at CPS conn/s;" << std::endl;
+    std::cout << "                 -c caps sessions in flight" << std::endl;
+    std::cout << "  --graceful     Close churn connections with FIN instead of RST" << std::endl;
+    std::cout << "  --fanout N     Pub/sub fan-out mode (server --pubsub): N subscribers, one publisher" << std::endl;
+    std::cout << "                 at --rate messages/s (default: 1000)" << std::endl;
+    std::cout << "  --kv           Key-value mode (server --kv): closed-loop GET/SET with --depth pipelining," << std::endl;
+    std::cout << "                 -s sets the value size" << std::endl;
+    std::cout << "  --keys N       Key space size (default: 100000)" << std::endl;
+    std::cout << "  --key-dist uniform|zipf  Key popularity distribution (default: uniform)" << std::endl;
+    std::cout << "  --zipf-theta T Zipfian skew, below 1 (default: 0.99)" << std::endl;
+    std::cout << "  --set-ratio R  Fraction of commands that are SET (default: 0.1)" << std::endl;
+    std::cout << "  --replay FILE  Replay a server --capture trace open-loop over -c connections" << std::endl;
+    std::cout << "                 (recorded connection c goes to replay connection c % N)" << std::endl;
+    std::cout << "  --replay-speed X        Replay speed multiplier (default: 1)" << std::endl;
+    std::cout << "  --procs N      Fork N worker processes that start together and merge results;" << std::endl;
+    std::cout << "                 -c and --rate are split across them (echo load only)" << std::endl;
+    std::cout << "  --source-ip LIST  Bind connections to these local addresses, e.g. 127.0.0.2-50;" << std::endl;
+    std::cout << "                 with --procs each process takes one address in turn" << std::endl;
     std::cout << "  --help         Show this help message" << std::endl;
 }
 
@@ -31,6 +111,7 @@ int main(int argc, char* argv[]) {
     signal(SIGTERM, signalHandler);
     
     ClientConfig config;
+    SizeDistribution sizes;     // 只解析一次，所有线程和工作进程共用分位数表
     
     // 解析命令行参数
     for (int i = 1; i < argc; ++i) {
@@ -45,8 +126,94 @@ int main(int argc, char* argv[]) {
             config.messages_per_connection = std::atoi(argv[++i]);
         } else if (arg == "-s" && i + 1 < argc) {
             config.message_size = std::atoi(argv[++i]);
+        } else if (arg == "--size-dist" && i + 1 < argc) {
+            config.size_distribution = argv[++i];
+            if (!sizes.parse(config.size_distribution)) {
+                return 1;
+            }
+            config.sizes = &sizes;
         } else if (arg == "-t" && i + 1 < argc) {
             config.test_duration = std::atoi(argv[++i]);
+        } else if (arg == "-T" && i + 1 < argc) {
+            config.num_threads = std::atoi(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                if (!item.empty()) {
+                    config.rates.push_back(std::atof(item.c_str()));
+                }
+            }
+            if (!config.rates.empty()) {
+                config.rate = config.rates.front();
+            }
+        } else if (arg == "--poisson") {
+            config.poisson_arrivals = true;
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            config.timeout_ms = std::atoi(argv[++i]);
+        } else if (arg == "--adversary" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                AdversaryClient::Profile profile;
+                if (!AdversaryClient::parseProfile(item, profile)) {
+                    std::cerr << "Unknown adversary profile: " << item << std::endl;
+                    return 1;
+                }
+                config.adversary_profiles.push_back(item);
+            }
+        } else if (arg == "--adversary-conns" && i + 1 < argc) {
+            config.adversary_connections = std::atoi(argv[++i]);
+        } else if (arg == "--adversary-interval" && i + 1 < argc) {
+            config.adversary_interval_ms = std::atoi(argv[++i]);
+        } else if (arg == "--crc") {
+            config.checksum = true;
+        } else if (arg == "--json" && i + 1 < argc) {
+            config.json_output = argv[++i];
+        } else if (arg == "--churn" && i + 1 < argc) {
+            config.churn_rate = std::atof(argv[++i]);
+        } else if (arg == "--fanout" && i + 1 < argc) {
+            config.fanout_subscribers = std::atoi(argv[++i]);
+        } else if (arg == "--kv") {
+            config.kv = true;
+        } else if (arg == "--keys" && i + 1 < argc) {
+            config.kv_keys = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--key-dist" && i + 1 < argc) {
+            config.kv_distribution = argv[++i];
+            if (config.kv_distribution != "uniform" && config.kv_distribution != "zipf") {
+                std::cerr << "Unknown key distribution: " << config.kv_distribution << std::endl;
+                return 1;
+            }
+        } else if (arg == "--zipf-theta" && i + 1 < argc) {
+            config.zipf_theta = std::atof(argv[++i]);
+            if (config.zipf_theta <= 0 || config.zipf_theta >= 1) {
+                std::cerr << "Zipf theta must be in (0, 1)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--set-ratio" && i + 1 < argc) {
+            config.kv_set_ratio = std::atof(argv[++i]);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            config.replay_trace = argv[++i];
+        } else if (arg == "--replay-speed" && i + 1 < argc) {
+            config.replay_speed = std::atof(argv[++i]);
+            if (config.replay_speed <= 0) {
+                std::cerr << "Replay speed must be positive" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--procs" && i + 1 < argc) {
+            config.processes = std::atoi(argv[++i]);
+            if (config.processes < 1) {
+                std::cerr << "Process count must be at least 1" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--source-ip" && i + 1 < argc) {
+            if (!parseSourceIps(argv[++i], config.source_ips)) {
+                return 1;
+            }
+        } else if (arg == "--graceful") {
+            config.churn_rst_close = false;
+        } else if (arg == "--depth" && i + 1 < argc) {
+            config.pipeline_depth = std::atoi(argv[++i]);
         } else if (arg == "--help") {
             printUsage(argv[0]);
             return 0;
@@ -60,10 +227,49 @@ int main(int argc, char* argv[]) {
     std::cout << "  Server: " << config.server_ip << ":" << config.server_port << std::endl;
     std::cout << "  Concurrent connections: " << config.concurrent_connections << std::endl;
     std::cout << "  Messages per connection: " << config.messages_per_connection << std::endl;
-    std::cout << "  Message size: " << config.message_size << " bytes" << std::endl;
+    if (config.size_distribution.empty()) {
+        std::cout << "  Message size: " << config.message_size << " bytes" << std::endl;
+    } else {
+        std::cout << "  Message size: " << config.size_distribution << " (min " << sizes.minSize()
+                  << ", mean " << static_cast<int>(sizes.meanSize()) << ", max " << sizes.maxSize() << " bytes)" << std::endl;
+    }
     std::cout << "  Test duration: " << config.test_duration << " seconds" << std::endl;
+    std::cout << "  Threads: " << config.num_threads << std::endl;
+    std::cout << "  Pipeline depth: " << config.pipeline_depth << std::endl;
+    if (config.churn_rate > 0) {
+        std::cout << "  Mode: churn, " << config.churn_rate << " conn/s" << std::endl;
+    } else if (config.fanout_subscribers > 0) {
+        std::cout << "  Mode: fan-out, " << config.fanout_subscribers << " subscribers" << std::endl;
+    } else if (config.kv) {
+        std::cout << "  Mode: kv, " << config.kv_keys << " " << config.kv_distribution << " keys, "
+                  << config.kv_set_ratio * 100 << "% SET" << std::endl;
+    } else if (!config.replay_trace.empty()) {
+        std::cout << "  Mode: replay " << config.replay_trace << " at " << config.replay_speed << "x" << std::endl;
+    } else if (config.rate > 0) {
+        std::cout << "  Mode: open-loop, " << config.rates.size() << " rate step(s)" << std::endl;
+    }
+    
+    if (config.processes > 1) {
+        std::cout << "  Processes: " << config.processes << std::endl;
+    }
+    if (!config.source_ips.empty()) {
+        std::cout << "  Source addresses: " << config.source_ips.front() << " .. " << config.source_ips.back()
+                  << " (" << config.source_ips.size() << ")" << std::endl;
+    }
+    
+    if (config.pipeline_depth < 1) {
+        std::cerr << "Pipeline depth must be at least 1" << std::endl;
+        return 1;
+    }
+    if (config.processes > 1 && (config.churn_rate > 0 || config.fanout_subscribers > 0 || config.kv ||
+                                 !config.replay_trace.empty() || !config.adversary_profiles.empty() ||
+                                 config.rates.size() > 1)) {
+        std::cerr << "--procs supports the echo load with at most one --rate only" << std::endl;
+        return 1;
+    }
+    raiseFileLimit();
     
-    PressureClient client(config);
+    PressureTest client(config);
     g_client = &client;
     
     if (!client.initialize()) {
@@ -1,8 +1,11 @@
 #include "pressure_client.h"
+#include "../include/frame.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstring>
@@ -10,10 +13,86 @@
 #include <cerrno>
 #include <random>
 #include <thread>
-#include <iomanip>
+#include <algorithm>
 
-PressureClient::PressureClient(const ClientConfig& config) 
-    : config_(config), epoll_fd_(-1), running_(false) {
+void TestStats::merge(const TestStats& other) {
+    total_connections += other.total_connections;
+    successful_connections += other.successful_connections;
+    failed_connections += other.failed_connections;
+    messages_sent += other.messages_sent;
+    messages_received += other.messages_received;
+    bytes_sent += other.bytes_sent;
+    bytes_received += other.bytes_received;
+    timeouts += other.timeouts;
+    echo_mismatches += other.echo_mismatches;
+    server_errors += other.server_errors;
+    latency.merge(other.latency);
+    size_buckets.merge(other.size_buckets);
+    // 取最早开始、最晚结束的时间作为整体测试时间
+    if (start_time == std::chrono::steady_clock::time_point() || other.start_time < start_time) {
+        start_time = other.start_time;
+    }
+    if (other.end_time > end_time) {
+        end_time = other.end_time;
+    }
+}
+
+void TestStats::reset() {
+    total_connections = 0;
+    successful_connections = 0;
+    failed_connections = 0;
+    messages_sent = 0;
+    messages_received = 0;
+    bytes_sent = 0;
+    bytes_received = 0;
+    timeouts = 0;
+    echo_mismatches = 0;
+    server_errors = 0;
+    latency.reset();
+    size_buckets.reset();
+    start_time = std::chrono::steady_clock::time_point();
+    end_time = std::chrono::steady_clock::time_point();
+}
+
+void TestStats::appendTo(std::vector<char>& out) const {
+    const std::atomic<long>* counters[] = {&total_connections, &successful_connections, &failed_connections,
+                                           &messages_sent, &messages_received, &bytes_sent, &bytes_received,
+                                           &timeouts, &echo_mismatches, &server_errors};
+    for (const std::atomic<long>* counter : counters) {
+        appendPod(out, counter->load());
+    }
+    // steady_clock在同一台机器上各进程共用，开始和结束时间可直接比较
+    appendPod(out, static_cast<int64_t>(start_time.time_since_epoch().count()));
+    appendPod(out, static_cast<int64_t>(end_time.time_since_epoch().count()));
+    latency.appendTo(out);
+    size_buckets.appendTo(out);
+}
+
+bool TestStats::readFrom(const char*& data, const char* end) {
+    std::atomic<long>* counters[] = {&total_connections, &successful_connections, &failed_connections,
+                                     &messages_sent, &messages_received, &bytes_sent, &bytes_received,
+                                     &timeouts, &echo_mismatches, &server_errors};
+    for (std::atomic<long>* counter : counters) {
+        long value;
+        if (!readPod(data, end, value)) {
+            return false;
+        }
+        *counter = value;
+    }
+    int64_t start_ticks;
+    int64_t end_ticks;
+    if (!readPod(data, end, start_ticks) || !readPod(data, end, end_ticks)) {
+        return false;
+    }
+    start_time = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(start_ticks));
+    end_time = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(end_ticks));
+    return latency.readFrom(data, end) && size_buckets.readFrom(data, end);
+}
+
+PressureClient::PressureClient(const ClientConfig& config, int thread_id) 
+    : config_(config), thread_id_(thread_id), epoll_fd_(-1), running_(false),
+      size_rng_(std::random_device{}() + thread_id),
+      rng_(std::random_device{}() + thread_id) {
 }
 
 PressureClient::~PressureClient() {
@@ -26,6 +105,25 @@ bool PressureClient::initialize() {
         return false;
     }
     
+    source_addrs_.clear();
+    for (const std::string& ip : config_.source_ips) {
+        struct in_addr addr;
+        if (inet_pton(AF_INET, ip.c_str(), &addr) != 1) {
+            std::cerr << "Invalid source address: " << ip << std::endl;
+            return false;
+        }
+        source_addrs_.push_back(addr);
+    }
+    
+    // 预生成载荷池，运行期间不再逐字节生成随机数据；每项按最大消息生成，较短的消息取前缀
+    // 大消息时减少项数，载荷池总共不超过16MB
+    int body_size = std::max(maxMessageSize() - static_cast<int>(sizeof(uint64_t)), 0);
+    int pool_size = std::max(std::min(config_.payload_pool_size, 16 * 1024 * 1024 / std::max(body_size, 1)), 1);
+    payload_pool_.clear();
+    for (int i = 0; i < pool_size; ++i) {
+        payload_pool_.push_back(generatePayload(rng_, body_size));
+    }
+    
     // std::cout << "Pressure client initialized" << std::endl;
     // std::cout << "Target: " << config_.server_ip << ":" << config_.server_port << std::endl;
     // std::cout << "Messages per connection: " << config_.messages_per_connection << std::endl;
@@ -52,28 +150,44 @@ void PressureClient::runTest() {
     running_ = true;
     stats_.start_time = std::chrono::steady_clock::now();
     
-    std::cout << "Starting pressure test..." << std::endl;
+    // 时间轮覆盖一个完整的超时周期
+    timeout_wheel_.assign(std::max(config_.timeout_ms, 1) / kWheelTickMs + 2, std::vector<WheelEntry>());
+    current_tick_ = 0;
+    
+    if (isOpenLoop()) {
+        // 各线程错开相位，使合并后的发送间隔均匀
+        schedule_offset_ns_ = 1e9 / config_.rate * thread_id_ / config_.num_threads;
+        next_send_time_ = stats_.start_time + std::chrono::nanoseconds(
+            static_cast<long long>(schedule_offset_ns_));
+    }
     
-    struct epoll_event events[config_.concurrent_connections];
+    // 事件数组不随连接数增长，几十万连接时避免在线程栈上分配数MB
+    std::vector<struct epoll_event> events(std::min(config_.concurrent_connections, 4096));
     
     while (running_) {
         // 建立新连接直到达到并发数
-        while (connections_.size() < config_.concurrent_connections) {
-            Connection conn;
-            conn.messages_to_send = config_.messages_per_connection;
-            conn.connect_time = std::chrono::steady_clock::now();
-            conn.last_activity = conn.connect_time;
-            
-            if (createConnection(conn)) {
-                connections_[conn.fd] = conn;
+        while (active_fds_.size() < static_cast<size_t>(config_.concurrent_connections)) {
+            if (createConnection()) {
                 stats_.total_connections++;
             } else {
                 stats_.failed_connections++;
             }
         }
         
+        int wait_ms = 100;
+        if (isOpenLoop()) {
+            // 按计划发送，等待时间不超过下一次计划发送时间
+            if (!sendScheduled()) {
+                wait_ms = 1;
+            } else {
+                auto until_next = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    next_send_time_ - std::chrono::steady_clock::now()).count();
+                wait_ms = static_cast<int>(std::max<long long>(0, std::min<long long>(until_next, 100)));
+            }
+        }
+        
         // 处理epoll事件
-        int num_events = epoll_wait(epoll_fd_, events, config_.concurrent_connections, 100);
+        int num_events = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), wait_ms);
         
         if (num_events == -1) {
             if (errno == EINTR) {
@@ -87,71 +201,64 @@ void PressureClient::runTest() {
             int fd = events[i].data.fd;
             uint32_t event_type = events[i].events;
             
-            auto it = connections_.find(fd);
-            if (it == connections_.end()) {
+            Connection* found = findConnection(fd);
+            if (found == nullptr) {
                 continue;
             }
             
-            Connection& conn = it->second;
+            Connection& conn = *found;
             
             if (event_type & (EPOLLERR | EPOLLHUP)) {
                 handleClose(conn);
                 continue;
             }
             
-            switch (conn.state) {
-                case CONNECTING:
-                    if (event_type & EPOLLOUT) {
-                        handleConnect(conn);
-                    }
-                    break;
-                case CONNECTED:
-                case SENDING:
-                    if (event_type & EPOLLOUT) {
-                        handleSend(conn);
-                    }
-                    break;
-                case RECEIVING:
-                    if (event_type & EPOLLIN) {
-                        handleReceive(conn);
-                    }
-                    break;
-                default:
-                    break;
+            if (conn.state == CONNECTING) {
+                if (event_type & EPOLLOUT) {
+                    handleConnect(conn);
+                }
+                continue;
+            }
+            
+            // 先发送积压数据，再处理回射
+            if ((event_type & EPOLLOUT) && !handleSend(conn)) {
+                continue;
+            }
+            if (event_type & EPOLLIN) {
+                handleReceive(conn);
             }
         }
         
-        // // 检查超时
-        // checkTimeouts();
+        // 检查超时
+        checkTimeouts();
         
         // 检查测试是否完成
         auto now = std::chrono::steady_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - stats_.start_time);
         if (duration.count() >= config_.test_duration) {
-            std::cout << "Test duration reached, stopping..." << std::endl;
+            std::cout << "[Thread " << thread_id_ << "] Test duration reached, stopping..." << std::endl;
             break;
         }
         
-        if (connections_.empty()) {
-            std::cout << "All connections completed, stopping..." << std::endl;
+        if (active_fds_.empty()) {
+            std::cout << "[Thread " << thread_id_ << "] All connections completed, stopping..." << std::endl;
             break;
         }
     }
     
     stats_.end_time = std::chrono::steady_clock::now();
     running_ = false;
-    
-    printStats();
 }
 
 void PressureClient::stopTest() {
     running_ = false;
     
     // 关闭所有连接
-    for (auto& pair : connections_) {
-        close(pair.first);
+    for (int fd : active_fds_) {
+        close(fd);
+        connections_[fd].fd = -1;
     }
-    connections_.clear();
+    active_fds_.clear();
     
     if (epoll_fd_ != -1) {
         close(epoll_fd_);
@@ -159,16 +266,38 @@ void PressureClient::stopTest() {
     }
 }
 
-bool PressureClient::createConnection(Connection& conn) {
-    conn.fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (conn.fd == -1) {
+bool PressureClient::createConnection() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
         std::cerr << "Create socket failed: " << strerror(errno) << std::endl;
         return false;
     }
     
     // 设置为非阻塞
-    int flags = fcntl(conn.fd, F_GETFL, 0);
-    fcntl(conn.fd, F_SETFL, flags | O_NONBLOCK);
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    
+    // 流水线发送小报文时关闭Nagle，避免与延迟确认叠加产生约40ms的停顿
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    
+    // 绑定本端地址以突破单个地址的临时端口上限；IP_BIND_ADDRESS_NO_PORT把端口分配推迟到connect，
+    // 按四元组判重，否则bind时就会按本端地址独占端口
+    if (!source_addrs_.empty()) {
+#ifdef IP_BIND_ADDRESS_NO_PORT
+        int no_port = 1;
+        setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &no_port, sizeof(no_port));
+#endif
+        struct sockaddr_in local_addr;
+        memset(&local_addr, 0, sizeof(local_addr));
+        local_addr.sin_family = AF_INET;
+        local_addr.sin_addr = source_addrs_[next_generation_ % source_addrs_.size()];
+        if (bind(fd, (struct sockaddr*)&local_addr, sizeof(local_addr)) == -1) {
+            std::cerr << "Bind source address failed: " << strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+    }
     
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
@@ -176,206 +305,423 @@ bool PressureClient::createConnection(Connection& conn) {
     server_addr.sin_port = htons(config_.server_port);
     inet_pton(AF_INET, config_.server_ip.c_str(), &server_addr.sin_addr);
     
-    int ret = connect(conn.fd, (struct sockaddr*)&server_addr, sizeof(server_addr));
-    if (ret == -1) {
-        if (errno == EINPROGRESS) {
-            // 连接进行中
-            uint32_t events = EPOLLOUT | (config_.use_et_mode ? EPOLLET : 0);
-            addEpollEvent(conn.fd, events);
-            conn.state = CONNECTING;
-            return true;
-        } else {
-            std::cerr << "Connect failed: " << strerror(errno) << std::endl;
-            close(conn.fd);
-            return false;
-        }
+    // 立即连接成功时同样由第一次EPOLLOUT进入handleConnect完成初始化
+    int ret = connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr));
+    if (ret == -1 && errno != EINPROGRESS) {
+        std::cerr << "Connect failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
     }
     
-    // 立即连接成功
-    conn.state = CONNECTED;
-    uint32_t events = EPOLLOUT | (config_.use_et_mode ? EPOLLET : 0);
-    addEpollEvent(conn.fd, events);
+    // 按fd下标放入连接表，复用槽位上已分配的缓冲区
+    if (static_cast<size_t>(fd) >= connections_.size()) {
+        connections_.resize(fd + 1);
+    }
+    Connection& conn = connections_[fd];
+    conn.fd = fd;
+    conn.state = CONNECTING;
+    conn.messages_to_send = config_.messages_per_connection;
+    conn.messages_sent = 0;
+    conn.messages_received = 0;
+    conn.send_cursor = 0;
+    conn.send_offset = 0;
+    conn.receive_length = 0;
+    conn.connect_time = std::chrono::steady_clock::now();
+    conn.last_activity = conn.connect_time;
+    conn.list_index = active_fds_.size();
+    conn.generation = ++next_generation_;
+    active_fds_.push_back(fd);
+    scheduleTimeout(conn, conn.last_activity + std::chrono::milliseconds(config_.timeout_ms));
+    
+    conn.events = EPOLLOUT | (config_.use_et_mode ? EPOLLET : 0);
+    addEpollEvent(fd, conn.events);
     return true;
 }
 
-void PressureClient::handleConnect(Connection& conn) {
+PressureClient::Connection* PressureClient::findConnection(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= connections_.size() || connections_[fd].fd != fd) {
+        return nullptr;
+    }
+    return &connections_[fd];
+}
+
+bool PressureClient::handleConnect(Connection& conn) {
     int error = 0;
     socklen_t len = sizeof(error);
     if (getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
         std::cerr << "Connection failed: " << strerror(error) << std::endl;
         handleClose(conn);
-        return;
+        return false;
     }
     
     conn.state = CONNECTED;
     stats_.successful_connections++;
+    conn.pending.init(config_.pipeline_depth);
     
-    // 准备发送第一条消息
-    conn.send_buffer = generateMessage();
-    modifyEpollEvent(conn.fd, EPOLLOUT | (config_.use_et_mode ? EPOLLET : 0));
+    // 闭环模式立即填满在途窗口；开环模式由调度器决定何时发送
+    if (!isOpenLoop()) {
+        fillWindow(conn);
+    }
+    if (flushSendBuffer(conn) < 0) {
+        handleClose(conn);
+        return false;
+    }
+    updateEpollEvent(conn);
+    return true;
 }
 
-void PressureClient::handleSend(Connection& conn) {
-    if (!sendMessage(conn)) {
+bool PressureClient::handleSend(Connection& conn) {
+    if (flushSendBuffer(conn) < 0) {
         handleClose(conn);
-        return;
+        return false;
     }
     
     conn.last_activity = std::chrono::steady_clock::now();
-    
-    if (conn.messages_sent < conn.messages_to_send) {
-        // 准备下一条消息
-        conn.send_buffer = generateMessage();
-        conn.state = SENDING;
-    } else {
-        // 所有消息发送完成，等待接收
-        conn.state = RECEIVING;
-        modifyEpollEvent(conn.fd, EPOLLIN | (config_.use_et_mode ? EPOLLET : 0));
-    }
+    updateEpollEvent(conn);
+    return true;
 }
 
-void PressureClient::handleReceive(Connection& conn) {
+bool PressureClient::handleReceive(Connection& conn) {
     if (!receiveMessage(conn)) {
         handleClose(conn);
-        return;
+        return false;
     }
     
     conn.last_activity = std::chrono::steady_clock::now();
     
-    if (conn.messages_received >= conn.messages_to_send) {
-        // 所有消息接收完成
+    if (!isOpenLoop()) {
+        if (conn.messages_received >= conn.messages_to_send) {
+            // 所有消息接收完成
+            handleClose(conn);
+            return false;
+        }
+        // 每收到一条回射就补发一条，保持在途请求数不变
+        fillWindow(conn);
+    }
+    if (flushSendBuffer(conn) < 0) {
         handleClose(conn);
+        return false;
     }
+    updateEpollEvent(conn);
+    return true;
 }
 
 void PressureClient::handleClose(Connection& conn) {
-    if (conn.state != CONNECTING && conn.messages_received < conn.messages_to_send) {
+    // 开环模式下连接应一直保持，中途关闭即视为失败
+    bool incomplete = isOpenLoop() || conn.messages_received < conn.messages_to_send;
+    if (conn.state != CONNECTING && incomplete) {
         stats_.failed_connections++;
     }
-    removeEpollEvent(conn.fd);
+    // close会自动将fd移出epoll，无需再调用EPOLL_CTL_DEL
     close(conn.fd);
-    connections_.erase(conn.fd);
+    
+    // 从活跃列表中交换删除
+    int last_fd = active_fds_.back();
+    active_fds_[conn.list_index] = last_fd;
+    connections_[last_fd].list_index = conn.list_index;
+    active_fds_.pop_back();
+    conn.fd = -1;
 }
 
-bool PressureClient::sendMessage(Connection& conn) {
-    std::string message=conn.send_buffer;
+void PressureClient::fillWindow(Connection& conn) {
+    auto now = std::chrono::steady_clock::now();
+    while (!conn.pending.full() && conn.messages_sent < conn.messages_to_send) {
+        sendMessage(conn, now);
+    }
+}
 
-    size_t total_size = sizeof(int) + message.length();
-    
-    // 分配内存来构建完整的结构体
-    std::vector<char> buffer(total_size);
-    
-    // 设置长度字段（网络字节序）
-    int msg_length = htonl(message.length());
-    memcpy(buffer.data(), &msg_length, sizeof(msg_length));
-    
-    // 拷贝数据内容
-    memcpy(buffer.data() + sizeof(msg_length), message.data(), message.length());
-    
-    // 一次性发送整个结构体
-    ssize_t bytes_sent = send(conn.fd, buffer.data(), total_size, 0);
-    if (bytes_sent != static_cast<ssize_t>(total_size)) {
-        std::cerr << "Send message struct failed: " << strerror(errno) << std::endl;
-        return false;
+void PressureClient::sendMessage(Connection& conn, std::chrono::steady_clock::time_point intended_time) {
+    // 登记在途请求，闭环模式下计划发送时间即实际发送时间，开环模式下为调度时间
+    PendingRequest& request = conn.pending.push();
+    request.seq = conn.messages_sent;
+    request.intended_time = intended_time;
+    request.send_time = std::chrono::steady_clock::now();
+    int message_size = config_.sizes ? std::min(config_.sizes->sample(size_rng_.next()), maxMessageSize())
+                                     : maxMessageSize();
+    request.body_size = std::max(message_size - static_cast<int>(sizeof(uint64_t)), 0);
+    
+    // 长度字段(网络字节序) + 序号，数据部分发送时直接引用载荷池
+    std::string_view body = bodyFor(request);
+    encodeFrameHeader(request.header, sizeof(uint64_t) + body.size() + trailerSize());
+    memcpy(request.header + kFrameHeaderSize, &request.seq, sizeof(request.seq));
+    if (config_.checksum) {
+        uint32_t crc = crc32c(request.header + kFrameHeaderSize, sizeof(request.seq));
+        encodeChecksum(request.trailer, crc32c(body.data(), body.size(), crc));
     }
     
     conn.messages_sent++;
     stats_.messages_sent++;
-    stats_.bytes_sent += bytes_sent;
-    
-    return true;
 }
 
-bool PressureClient::receiveMessage(Connection& conn) {
-    // 读取消息头（长度字段）
-    int msg_length;
-    ssize_t bytes_received = recv(conn.fd, &msg_length, sizeof(msg_length), 0);
-    
-    if (bytes_received == 0) {
-        std::cerr << "Connection closed by server" << std::endl;
-        return false;
-    } else if (bytes_received < 0) {
-        std::cerr << "Receive message header failed: " << strerror(errno) << std::endl;
-        return false;
-    } else if (bytes_received != sizeof(msg_length)) {
-        std::cerr << "Incomplete message header received" << std::endl;
-        return false;
+int PressureClient::flushSendBuffer(Connection& conn) {
+    const int kMaxIov = 64;
+    
+    while (conn.send_cursor < conn.messages_sent) {
+        // 把所有未发送的请求组织成iovec，一次系统调用发出
+        struct iovec iov[kMaxIov];
+        int iovcnt = 0;
+        size_t skip = conn.send_offset;
+        for (int seq = conn.send_cursor; seq < conn.messages_sent && iovcnt + 3 <= kMaxIov; ++seq) {
+            PendingRequest& request = conn.pending.at(seq - conn.messages_received);
+            std::string_view body = bodyFor(request);
+            
+            if (skip < sizeof(request.header)) {
+                iov[iovcnt].iov_base = request.header + skip;
+                iov[iovcnt].iov_len = sizeof(request.header) - skip;
+                iovcnt++;
+                skip = 0;
+            } else {
+                skip -= sizeof(request.header);
+            }
+            if (skip < body.size()) {
+                iov[iovcnt].iov_base = const_cast<char*>(body.data()) + skip;
+                iov[iovcnt].iov_len = body.size() - skip;
+                iovcnt++;
+                skip = 0;
+            } else {
+                skip -= body.size();
+            }
+            if (skip < trailerSize()) {
+                iov[iovcnt].iov_base = request.trailer + skip;
+                iov[iovcnt].iov_len = trailerSize() - skip;
+                iovcnt++;
+            }
+            skip = 0;
+        }
+        
+        // 使用sendmsg代替writev以便传入MSG_NOSIGNAL
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t bytes_sent = sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+        if (bytes_sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 发送缓冲区满，等待EPOLLOUT
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Send message failed: " << strerror(errno) << std::endl;
+            return -1;
+        }
+        stats_.bytes_sent += bytes_sent;
+        
+        // 推进发送游标
+        size_t progress = conn.send_offset + bytes_sent;
+        while (conn.send_cursor < conn.messages_sent) {
+            size_t frame_size = sizeof(PendingRequest::header) +
+                conn.pending.at(conn.send_cursor - conn.messages_received).body_size + trailerSize();
+            if (progress < frame_size) {
+                break;
+            }
+            progress -= frame_size;
+            conn.send_cursor++;
+        }
+        conn.send_offset = progress;
     }
-    
-    // 转换为主机字节序
-    msg_length = ntohl(msg_length);
-    
-    if (msg_length <= 0 || msg_length > 1024 * 1024) { // 限制最大1MB
-        std::cerr << "Invalid message length: " << msg_length << std::endl;
-        return false;
+    return 1;
+}
+
+bool PressureClient::receiveMessage(Connection& conn) {
+    // 缓冲区至少容纳一条完整报文
+    size_t min_size = std::max<size_t>(4096, sizeof(PendingRequest::header) + payload_pool_[0].size() + trailerSize());
+    if (conn.receive_buffer.size() < min_size) {
+        conn.receive_buffer.resize(min_size);
     }
     
-    // 读取消息体
-    std::vector<char> buffer(msg_length);
-    int bytes_cnt = 0;
-    while(bytes_cnt < msg_length){
-      bytes_received = recv(conn.fd, buffer.data(), msg_length, 0);
-      if (bytes_received < 0) {
+    // 边缘触发: 读到缓冲区排空为止，数据直接读入连接的接收缓冲区
+    while (true) {
+        size_t space = conn.receive_buffer.size() - conn.receive_length;
+        ssize_t bytes_received = recv(conn.fd, conn.receive_buffer.data() + conn.receive_length, space, 0);
+        if (bytes_received > 0) {
+            conn.receive_length += bytes_received;
+            stats_.bytes_received += bytes_received;
+            if (!parseMessages(conn)) {
+                return false;
+            }
+            if (static_cast<size_t>(bytes_received) < space) {
+                break;
+            }
+            continue;
+        }
+        if (bytes_received == 0) {
+            std::cerr << "Connection closed by server" << std::endl;
+            return false;
+        }
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
-          // 非阻塞模式下没有数据可读
-          continue;
+            break;
         }
-        std::cerr << "Read message body failed: " << strerror(errno) << std::endl;
+        if (errno == EINTR) {
+            continue;
+        }
+        std::cerr << "Receive message failed: " << strerror(errno) << std::endl;
         return false;
-      }
-      bytes_cnt += bytes_received;
     }
-    conn.receive_buffer.assign(buffer.data(), msg_length);
+    return true;
+}
+
+bool PressureClient::parseMessages(Connection& conn) {
+    // 解析所有完整报文，按发送顺序与在途请求匹配
+    auto now = std::chrono::steady_clock::now();
+    const char* data = conn.receive_buffer.data();
+    size_t offset = 0;
+    while (conn.receive_length - offset >= sizeof(int)) {
+        uint32_t msg_length = decodeFrameHeader(data + offset);
+        
+        // 服务器过载拒绝: 记录错误码，服务器随后关闭连接
+        if (isErrorFrameHeader(msg_length)) {
+            if (conn.receive_length - offset >= kFrameHeaderSize + sizeof(uint32_t)) {
+                uint32_t code = decodeFrameHeader(data + offset + kFrameHeaderSize);
+                std::cerr << "Server error: " << frameErrorName(code) << std::endl;
+            }
+            stats_.server_errors++;
+            return false;
+        }
+        if (msg_length < sizeof(uint64_t) || msg_length > 1024 * 1024) { // 限制最大1MB
+            std::cerr << "Invalid message length: " << msg_length << std::endl;
+            return false;
+        }
+        size_t frame_size = kFrameHeaderSize + msg_length;
+        if (conn.receive_length - offset < frame_size) {
+            // 报文尚未接收完整，必要时扩大缓冲区
+            if (conn.receive_buffer.size() < frame_size) {
+                memmove(conn.receive_buffer.data(), data + offset, conn.receive_length - offset);
+                conn.receive_length -= offset;
+                conn.receive_buffer.resize(frame_size);
+                return true;
+            }
+            break;
+        }
+        if (conn.pending.empty()) {
+            std::cerr << "Unexpected echo without request in flight" << std::endl;
+            return false;
+        }
+        
+        // 验证回射数据: 序号须与最早的在途请求一致，数据须与载荷池一致(开启校验时只验证CRC32C)
+        PendingRequest& request = conn.pending.front();
+        const char* payload = data + offset + kFrameHeaderSize;
+        bool echo_ok = config_.checksum ?
+            verifyEchoChecksum(payload, msg_length, request.seq, request.body_size) :
+            verifyEchoPayload(payload, msg_length, request.seq, bodyFor(request));
+        if (!echo_ok) {
+            std::cerr << "Echo data mismatch!" << std::endl;
+            stats_.echo_mismatches++;
+        }
+        
+        // 记录往返延迟，使用计划发送时间以避免协同遗漏(coordinated omission)
+        int64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - request.intended_time).count();
+        stats_.latency.record(latency_ns);
+        if (!config_.size_distribution.empty()) {
+            stats_.size_buckets.record(msg_length - trailerSize(), latency_ns);
+        }
+        conn.pending.pop();
+        
+        conn.messages_received++;
+        stats_.messages_received++;
+        offset += frame_size;
+    }
     
-    // 验证回射数据
-    if (conn.receive_buffer != conn.send_buffer) {
-        std::cerr << "Echo data mismatch!" << std::endl;
+    // 将未解析的剩余字节移到缓冲区头部
+    if (offset > 0) {
+        memmove(conn.receive_buffer.data(), data + offset, conn.receive_length - offset);
+        conn.receive_length -= offset;
     }
-    conn.messages_received++;
-    stats_.messages_received++;
-    stats_.bytes_received += bytes_cnt;
     return true;
 }
 
-// void PressureClient::checkTimeouts() {
-//     auto now = std::chrono::steady_clock::now();
-//     std::vector<int> timeouts;
-    
-//     for (auto& pair : connections_) {
-//         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-//             now - pair.second.last_activity);
-//         if (duration.count() > config_.timeout_ms) {
-//             timeouts.push_back(pair.first);
-//             stats_.timeouts++;
-//         }
-//     }
-    
-//     for (int fd : timeouts) {
-//         auto it = connections_.find(fd);
-//         if (it != connections_.end()) {
-//             handleClose(it->second);
-//         }
-//     }
-// }
+bool PressureClient::sendScheduled() {
+    auto now = std::chrono::steady_clock::now();
+    
+    // 补发所有已到期的请求；落后于计划时不丢弃，延迟从计划时间算起
+    while (next_send_time_ <= now) {
+        Connection* conn = nextReadyConnection();
+        if (conn == nullptr) {
+            // 所有连接的在途窗口已满，计划时间保持不变
+            return false;
+        }
+        
+        sendMessage(*conn, next_send_time_);
+        advanceSchedule();
+        if (flushSendBuffer(*conn) < 0) {
+            handleClose(*conn);
+            continue;
+        }
+        conn->last_activity = now;
+        updateEpollEvent(*conn);
+    }
+    return true;
+}
 
-std::string PressureClient::generateMessage() {
-    static const char alphanum[] = 
-        "0123456789"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "abcdefghijklmnopqrstuvwxyz";
-    
-    std::string message;
-    message.reserve(config_.message_size);
-    
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, sizeof(alphanum) - 2);
-    
-    for (int i = 0; i < config_.message_size; ++i) {
-        message += alphanum[dis(gen)];
+void PressureClient::advanceSchedule() {
+    // 每个线程承担 rate/num_threads 的速率
+    double thread_rate = config_.rate / config_.num_threads;
+    if (config_.poisson_arrivals) {
+        std::exponential_distribution<double> interval(thread_rate);
+        schedule_offset_ns_ += interval(rng_) * 1e9;
+    } else {
+        schedule_offset_ns_ += 1e9 / thread_rate;
+    }
+    next_send_time_ = stats_.start_time + std::chrono::nanoseconds(
+        static_cast<long long>(schedule_offset_ns_));
+}
+
+PressureClient::Connection* PressureClient::nextReadyConnection() {
+    for (size_t i = 0; i < active_fds_.size(); ++i) {
+        rr_cursor_ = (rr_cursor_ + 1) % active_fds_.size();
+        Connection& conn = connections_[active_fds_[rr_cursor_]];
+        if (conn.state == CONNECTED && !conn.pending.full()) {
+            return &conn;
+        }
+    }
+    return nullptr;
+}
+
+void PressureClient::scheduleTimeout(Connection& conn, std::chrono::steady_clock::time_point deadline) {
+    long tick = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - stats_.start_time).count() / kWheelTickMs + 1;
+    if (tick <= current_tick_) {
+        tick = current_tick_ + 1;
+    }
+    WheelEntry entry;
+    entry.fd = conn.fd;
+    entry.generation = conn.generation;
+    timeout_wheel_[tick % timeout_wheel_.size()].push_back(entry);
+}
+
+void PressureClient::checkTimeouts() {
+    auto now = std::chrono::steady_clock::now();
+    long now_tick = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now - stats_.start_time).count() / kWheelTickMs;
+    auto timeout = std::chrono::milliseconds(config_.timeout_ms);
+    
+    // 只检查到期槽中的连接，活跃连接重新登记到新的截止时间，代价与连接总数无关
+    while (current_tick_ < now_tick) {
+        current_tick_++;
+        expired_entries_.clear();
+        expired_entries_.swap(timeout_wheel_[current_tick_ % timeout_wheel_.size()]);
+        
+        for (const WheelEntry& entry : expired_entries_) {
+            Connection* conn = findConnection(entry.fd);
+            if (conn == nullptr || conn->generation != entry.generation) {
+                // 连接已关闭或fd已被新连接复用
+                continue;
+            }
+            
+            // 没有在途请求的空闲连接(开环模式下等待调度)不算超时
+            bool waiting = conn->state == CONNECTING || !conn->pending.empty();
+            if (!waiting) {
+                scheduleTimeout(*conn, now + timeout);
+            } else if (now - conn->last_activity >= timeout) {
+                stats_.timeouts++;
+                handleClose(*conn);
+            } else {
+                scheduleTimeout(*conn, conn->last_activity + timeout);
+            }
+        }
     }
-    
-    return message;
 }
 
 void PressureClient::addEpollEvent(int fd, uint32_t events) {
@@ -398,40 +744,14 @@ void PressureClient::modifyEpollEvent(int fd, uint32_t events) {
     }
 }
 
-void PressureClient::removeEpollEvent(int fd) {
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) == -1) {
-        std::cerr << "Remove epoll event failed: " << strerror(errno) << std::endl;
+void PressureClient::updateEpollEvent(Connection& conn) {
+    // 始终关注可读；有待发送数据时额外关注可写
+    uint32_t events = EPOLLIN | (config_.use_et_mode ? EPOLLET : 0);
+    if (conn.send_cursor < conn.messages_sent) {
+        events |= EPOLLOUT;
+    }
+    if (events != conn.events) {
+        modifyEpollEvent(conn.fd, events);
+        conn.events = events;
     }
 }
-
-void PressureClient::printStats() {
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        stats_.end_time - stats_.start_time);
-    double duration_sec = duration.count() / 1000.0;
-    
-    std::cout << "\n=== Pressure Test Results ===" << std::endl;
-    std::cout << "Duration: " << duration_sec << " seconds" << std::endl;
-    std::cout << "Total connections: " << stats_.total_connections << std::endl;
-    std::cout << "Successful connections: " << stats_.successful_connections << std::endl;
-    std::cout << "Failed connections: " << stats_.failed_connections << std::endl;
-    std::cout << "Timeouts: " << stats_.timeouts << std::endl;
-    std::cout << "Messages sent: " << stats_.messages_sent << std::endl;
-    std::cout << "Messages received: " << stats_.messages_received << std::endl;
-    std::cout << "Bytes sent: " << stats_.bytes_sent << std::endl;
-    std::cout << "Bytes received: " << stats_.bytes_received << std::endl;
-    
-    if (duration_sec > 0) {
-        std::cout << "Connections per second: " 
-                  << stats_.total_connections / duration_sec << std::endl;
-        std::cout << "Messages per second: " 
-                  << stats_.messages_sent / duration_sec << std::endl;
-        std::cout << "Throughput: " 
-                  << (stats_.bytes_sent + stats_.bytes_received) / duration_sec / 1024 
-                  << " KB/s" << std::endl;
-    }
-    
-    double success_rate = (stats_.total_connections > 0) ? 
-        (static_cast<double>(stats_.successful_connections) / stats_.total_connections * 100) : 0;
-    std::cout << "Success rate: " << std::fixed << std::setprecision(2) 
-              << success_rate << "%" << std::endl;
-}
\ No newline at end of file
@@ -2,10 +2,16 @@
 #define PRESSURE_CLIENT_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <map>
+#include <cstdint>
+#include <random>
+#include <netinet/in.h>
+#include "../include/latency_histogram.h"
+#include "../include/size_distribution.h"
 
 struct ClientConfig {
     std::string server_ip = "127.0.0.1";
@@ -13,10 +19,35 @@ struct ClientConfig {
     int concurrent_connections = 1000;  // 并发连接数
     int messages_per_connection = 10;  // 每个连接发送的消息数
     int message_size = 1024;           // 每条消息大小(字节)
+    std::string size_distribution;     // 消息大小分布(见size_distribution.h)，为空时固定为message_size
+    const SizeDistribution* sizes = nullptr;   // 按size_distribution建好的分布，main解析一次后各线程只读共享
     int timeout_ms = 5000;             // 超时时间
     bool use_et_mode = true;           // 使用边缘触发
     int batch_size = 10;               // 批量连接数
     int test_duration = 30;            // 测试持续时间(秒)
+    int num_threads = 1;               // 工作线程数，每个线程独立epoll
+    double rate = 0;                   // 开环模式目标速率(请求/秒)，0表示闭环
+    bool poisson_arrivals = false;     // 开环模式使用泊松到达，否则均匀间隔
+    std::vector<double> rates;         // 速率扫描列表，依次测试以找出延迟拐点
+    int pipeline_depth = 1;            // 每个连接保持的在途请求数
+    int payload_pool_size = 64;        // 启动时预生成的载荷数量
+    std::string json_output;           // 结果输出为JSON文件，为空则不输出
+    bool checksum = false;             // 载荷附带CRC32C尾部，按校验和验证回射而不逐字节比较
+    double churn_rate = 0;             // 短连接模式目标速率(连接/秒)，0表示长连接测试
+    bool churn_rst_close = true;       // 短连接以RST关闭(SO_LINGER 0)，避免本端TIME_WAIT堆积
+    std::vector<std::string> adversary_profiles;   // 依次与正常流量同时运行的异常客户端画像
+    int adversary_connections = 16;    // 异常客户端连接数
+    int adversary_interval_ms = 10;    // 异常客户端每次动作的间隔
+    int fanout_subscribers = 0;        // 发布订阅扇出测试的订阅连接数，0表示不测试；发布速率取rate
+    bool kv = false;                   // 键值负载测试(服务器--kv)，值大小取message_size
+    uint64_t kv_keys = 100000;         // 键空间大小
+    std::string kv_distribution = "uniform";   // 键分布: uniform或zipf
+    double zipf_theta = 0.99;          // Zipfian偏斜参数，须小于1
+    double kv_set_ratio = 0.1;         // SET占命令的比例，其余为GET
+    std::string replay_trace;          // 回放的录制文件(服务器--capture)，为空则不回放
+    double replay_speed = 1.0;         // 回放速度倍数，2表示按录制间隔的一半发送
+    int processes = 1;                 // 工作进程数，大于1时由协调进程fork并合并结果
+    std::vector<std::string> source_ips;   // 本端绑定地址，连接依次轮换；多进程时每个进程分到其中一个
 };
 
 struct TestStats {
@@ -28,19 +59,32 @@ struct TestStats {
     std::atomic<long> bytes_sent{0};
     std::atomic<long> bytes_received{0};
     std::atomic<long> timeouts{0};
+    std::atomic<long> echo_mismatches{0};
+    std::atomic<long> server_errors{0};     // 服务器过载时回复的错误报文
+    LatencyHistogram latency;           // 请求往返延迟(ns)，从计划发送时间算起
+    SizeBucketStats size_buckets;       // 按消息大小分桶的吞吐和延迟
     std::chrono::steady_clock::time_point start_time;
     std::chrono::steady_clock::time_point end_time;
+
+    // 合并其他线程的统计结果
+    void merge(const TestStats& other);
+    // 清空统计，用于速率扫描的下一阶段
+    void reset();
+    // 序列化/反序列化，多进程模式下工作进程经共享内存把结果交给协调进程
+    void appendTo(std::vector<char>& out) const;
+    bool readFrom(const char*& data, const char* end);
 };
 
+// 单线程压测客户端：一个epoll管理本线程分到的全部连接
 class PressureClient {
 public:
-    PressureClient(const ClientConfig& config);
+    PressureClient(const ClientConfig& config, int thread_id = 0);
     ~PressureClient();
     
     bool initialize();
     void runTest();
     void stopTest();
-    void printStats();
+    const TestStats& stats() const { return stats_; }
     
 private:
     enum ConnectionState {
@@ -52,42 +96,127 @@ private:
         CLOSED
     };
     
+    // 已发送待回射的请求
+    // 报文载荷 = 8字节序号 + 载荷池中的数据，序号与长度字段一起放在header中，
+    // 数据部分直接引用载荷池，发送时用sendmsg(writev)拼接，无需拷贝
+    struct PendingRequest {
+        std::chrono::steady_clock::time_point intended_time;   // 计划发送时间(限速模式下由调度决定)
+        std::chrono::steady_clock::time_point send_time;       // 实际发送时间
+        uint64_t seq = 0;                                      // 连接内序号
+        uint32_t body_size = 0;                                // 数据部分长度，按大小分布抽样
+        char header[sizeof(int) + sizeof(uint64_t)];           // 长度字段(网络字节序) + 序号
+        char trailer[sizeof(uint32_t)];                        // 开启校验时为序号和数据的CRC32C
+    };
+    
+    // 在途请求环形队列，容量为流水线深度，回射按发送顺序匹配
+    struct RequestRing {
+        std::vector<PendingRequest> slots;
+        size_t head = 0;
+        size_t count = 0;
+        
+        void init(size_t capacity) { slots.resize(capacity); head = 0; count = 0; }
+        bool empty() const { return count == 0; }
+        bool full() const { return count == slots.size(); }
+        size_t size() const { return count; }
+        PendingRequest& front() { return slots[head]; }
+        PendingRequest& at(size_t i) { return slots[(head + i) % slots.size()]; }
+        void pop() { head = (head + 1) % slots.size(); --count; }
+        // 返回队尾空槽位，调用者填充
+        PendingRequest& push() { return slots[(head + count++) % slots.size()]; }
+    };
+    
     struct Connection {
         int fd = -1;
         ConnectionState state = CONNECTING;
         int messages_to_send = 0;
         int messages_sent = 0;
         int messages_received = 0;
-        std::string send_buffer;
-        std::string receive_buffer;
-        int expected_length = 0;
+        int send_cursor = 0;                    // 第一条未发送完的请求序号
+        size_t send_offset = 0;                 // 该请求已发送的字节数
+        std::vector<char> receive_buffer;       // 接收缓冲区
+        size_t receive_length = 0;              // 接收缓冲区中未解析的字节数
+        uint32_t events = 0;                    // 当前注册的epoll事件
+        size_t list_index = 0;                  // 在active_fds_中的位置
+        uint32_t generation = 0;                // 连接代号，区分复用同一fd的新旧连接
+        RequestRing pending;                    // 按发送顺序排列的在途请求
         std::chrono::steady_clock::time_point connect_time;
         std::chrono::steady_clock::time_point last_activity;
     };
     
-    bool createConnection(Connection& conn);
+    bool createConnection();
+    Connection* findConnection(int fd);         // 按fd直接索引连接，不存在返回nullptr
     bool setupEpoll();
     void addEpollEvent(int fd, uint32_t events);
     void modifyEpollEvent(int fd, uint32_t events);
-    void removeEpollEvent(int fd);
 
-    void handleConnect(Connection& conn);
-    void handleSend(Connection& conn);
-    void handleReceive(Connection& conn);
+    void updateEpollEvent(Connection& conn);    // 按是否有待发送数据调整关注事件
+
+    // 以下处理函数返回false表示连接已关闭
+    bool handleConnect(Connection& conn);
+    bool handleSend(Connection& conn);
+    bool handleReceive(Connection& conn);
     void handleClose(Connection& conn);
-    // void checkTimeouts();
     
-    bool sendMessage(Connection& conn);
+    // 超时检测: 时间轮按last_activity+timeout_ms登记截止时间，每个连接同时只在一个槽中
+    struct WheelEntry {
+        int fd;
+        uint32_t generation;
+    };
+    void scheduleTimeout(Connection& conn, std::chrono::steady_clock::time_point deadline);
+    void checkTimeouts();
+    
+    // 生成一条请求并登记到在途队列，由flushSendBuffer发送
+    void sendMessage(Connection& conn, std::chrono::steady_clock::time_point intended_time);
+    // 发送所有未发送的请求: 1全部发出，0缓冲区满需等待可写，-1出错
+    int flushSendBuffer(Connection& conn);
+    // 读取并按顺序匹配所有已到达的回射: 返回false表示出错
     bool receiveMessage(Connection& conn);
+    // 解析接收缓冲区中的完整报文: 返回false表示出错
+    bool parseMessages(Connection& conn);
+    // 闭环模式下补足在途窗口
+    void fillWindow(Connection& conn);
+    
+    // 开环模式
+    bool isOpenLoop() const { return config_.rate > 0; }
+    bool sendScheduled();                   // 发送所有到期的计划请求，返回false表示被阻塞
+    void advanceSchedule();                 // 计算下一次计划发送时间
+    Connection* nextReadyConnection();      // 轮询选取一个可发送的连接
     
-    std::string generateMessage();
+    size_t trailerSize() const { return config_.checksum ? sizeof(PendingRequest::trailer) : 0; }
+    // 序号、数据和校验和合计不超过接收端接受的最大报文
+    int maxMessageSize() const {
+        return std::min(config_.sizes ? config_.sizes->maxSize() : std::max(config_.message_size, 1),
+                        SizeDistribution::kMaxSize - static_cast<int>(trailerSize()));
+    }
+    // 数据部分取载荷池中一项的前body_size字节
+    std::string_view bodyFor(const PendingRequest& request) const {
+        return std::string_view(payload_pool_[request.seq % payload_pool_.size()].data(), request.body_size);
+    }
     
 private:
     ClientConfig config_;
+    int thread_id_;
     int epoll_fd_;
-    bool running_;
+    std::atomic<bool> running_;
     TestStats stats_;
-    std::map<int, Connection> connections_;
+    std::vector<Connection> connections_;       // 按fd下标索引，fd为-1表示空闲
+    std::vector<int> active_fds_;               // 活跃连接的fd，用于轮询与关闭
+    std::vector<std::string> payload_pool_;     // 预生成的载荷数据(不含序号)，每项按最大消息长度生成
+    std::vector<struct in_addr> source_addrs_;  // 解析后的本端绑定地址
+    FastRng size_rng_;                          // 按config_.sizes抽样消息大小，每线程一个
+    
+    // 开环调度状态
+    std::chrono::steady_clock::time_point next_send_time_; // 下一次计划发送时间
+    double schedule_offset_ns_ = 0;                         // 相对start_time的计划偏移
+    size_t rr_cursor_ = 0;                                  // 轮询游标
+    
+    // 超时时间轮
+    static const int kWheelTickMs = 10;                     // 时间轮刻度(毫秒)
+    std::vector<std::vector<WheelEntry>> timeout_wheel_;    // 各槽中待检查的连接
+    std::vector<WheelEntry> expired_entries_;               // 当前处理的槽，复用内存
+    long current_tick_ = 0;                                 // 已处理到的刻度
+    uint32_t next_generation_ = 0;                          // 连接代号计数
+    std::mt19937_64 rng_;                                   // 泊松间隔随机数
 };
 
 #endif // PRESSURE_CLIENT_H
\ No newline at end of file
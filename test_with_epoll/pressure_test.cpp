@@ -0,0 +1,900 @@
+#include "pressure_test.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <fstream>
+#include <unistd.h>
+
+// 输出一行延迟分位数(微秒)，各模式共用，没有记录时不输出
+static void printLatency(const std::string& label, const LatencyHistogram& latency) {
+    if (latency.count() == 0) {
+        return;
+    }
+    std::cout << label << " (us): "
+              << "p50=" << latency.percentile(50) / 1000.0
+              << " p90=" << latency.percentile(90) / 1000.0
+              << " p99=" << latency.percentile(99) / 1000.0
+              << " p99.9=" << latency.percentile(99.9) / 1000.0
+              << " max=" << latency.max() / 1000.0
+              << " mean=" << latency.mean() / 1000.0 << std::endl;
+}
+
+// 输出以prefix为前缀的延迟字段，字段间以逗号分隔，首个字段前和末个字段后的分隔由调用者负责
+static void writeLatencyJson(std::ostream& out, const std::string& prefix, const LatencyHistogram& latency) {
+    out << "  \"" << prefix << "_p50_us\": " << latency.percentile(50) / 1000.0 << ",\n";
+    out << "  \"" << prefix << "_p90_us\": " << latency.percentile(90) / 1000.0 << ",\n";
+    out << "  \"" << prefix << "_p99_us\": " << latency.percentile(99) / 1000.0 << ",\n";
+    out << "  \"" << prefix << "_p999_us\": " << latency.percentile(99.9) / 1000.0 << ",\n";
+    out << "  \"" << prefix << "_max_us\": " << latency.max() / 1000.0 << ",\n";
+    out << "  \"" << prefix << "_mean_us\": " << latency.mean() / 1000.0;
+}
+
+template <typename Client, typename Stats>
+void PressureTest::runClients(std::vector<std::unique_ptr<Client>>& clients, Stats& merged) {
+    merged.reset();
+    for (auto& client : clients) {
+        threads_.emplace_back(&Client::runTest, client.get());
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+
+    for (auto& client : clients) {
+        merged.merge(client->stats());
+    }
+}
+
+PressureTest::PressureTest(const ClientConfig& config)
+    : config_(config) {
+    if (config_.num_threads < 1) {
+        config_.num_threads = 1;
+    }
+    // 线程数不超过连接数，避免出现空线程
+    int connections = config_.fanout_subscribers > 0 ? config_.fanout_subscribers : config_.concurrent_connections;
+    if (config_.num_threads > connections) {
+        config_.num_threads = connections > 0 ? connections : 1;
+    }
+    if (config_.processes > connections) {
+        config_.processes = connections > 0 ? connections : 1;
+    }
+}
+
+PressureTest::~PressureTest() {
+    stopTest();
+}
+
+bool PressureTest::initialize() {
+    if (config_.churn_rate > 0) {
+        return createChurnClients();
+    }
+    if (config_.fanout_subscribers > 0) {
+        return createFanoutClients();
+    }
+    if (config_.kv) {
+        return createKvClients();
+    }
+    if (!config_.replay_trace.empty()) {
+        return createReplayClients();
+    }
+    if (!config_.rates.empty()) {
+        config_.rate = config_.rates.front();
+    }
+    if (config_.processes > 1) {
+        return true;    // 各工作进程fork后自行建立客户端
+    }
+    return createClients(config_);
+}
+
+bool PressureTest::createClients(const ClientConfig& config) {
+    clients_.clear();
+    int base = config.concurrent_connections / config.num_threads;
+    int remainder = config.concurrent_connections % config.num_threads;
+
+    for (int i = 0; i < config.num_threads; ++i) {
+        // 按线程分片连接数，余数分给前面的线程
+        ClientConfig shard = config;
+        shard.concurrent_connections = base + (i < remainder ? 1 : 0);
+
+        std::unique_ptr<PressureClient> client(new PressureClient(shard, i));
+        if (!client->initialize()) {
+            std::cerr << "Failed to initialize pressure client " << i << std::endl;
+            clients_.clear();
+            return false;
+        }
+        clients_.push_back(std::move(client));
+    }
+    return true;
+}
+
+void PressureTest::runTest() {
+    if (config_.churn_rate > 0) {
+        runChurn();
+        return;
+    }
+    if (config_.fanout_subscribers > 0) {
+        runFanout();
+        return;
+    }
+    if (config_.kv) {
+        runKv();
+        return;
+    }
+    if (!config_.replay_trace.empty()) {
+        runReplay();
+        return;
+    }
+    if (config_.processes > 1) {
+        runProcesses();
+        return;
+    }
+    if (clients_.empty()) {
+        std::cerr << "Pressure test not initialized" << std::endl;
+        return;
+    }
+
+    if (!config_.adversary_profiles.empty()) {
+        runAdversaryProfiles();
+        return;
+    }
+    if (config_.rates.size() > 1) {
+        runRateSweep();
+        return;
+    }
+
+    std::cout << "Starting pressure test with " << clients_.size() << " thread(s)..." << std::endl;
+    runPhase();
+    printStats();
+    writeJson();
+}
+
+void PressureTest::runPhase() {
+    runClients(clients_, stats_);
+}
+
+void PressureTest::runProcesses() {
+    // 槽位按空统计的序列化长度分配，直方图桶数固定，实际结果长度相同
+    std::vector<char> probe;
+    stats_.reset();
+    stats_.appendTo(probe);
+    ProcessCoordinator coordinator(config_.processes, probe.size());
+    if (!coordinator.create()) {
+        return;
+    }
+
+    std::cout << "Starting pressure test with " << config_.processes << " process(es) x "
+              << config_.num_threads << " thread(s)..." << std::endl;
+    int base = config_.concurrent_connections / config_.processes;
+    int remainder = config_.concurrent_connections % config_.processes;
+    for (int i = 0; i < config_.processes; ++i) {
+        // 连接数和开环速率按进程均分，每个进程只绑定一个本端地址
+        ClientConfig shard = config_;
+        shard.processes = 1;
+        shard.concurrent_connections = base + (i < remainder ? 1 : 0);
+        shard.rate = config_.rate / config_.processes;
+        shard.rates.clear();
+        shard.json_output.clear();
+        if (!config_.source_ips.empty()) {
+            shard.source_ips.assign(1, config_.source_ips[i % config_.source_ips.size()]);
+        }
+        pid_t pid = coordinator.spawn();
+        if (pid < 0) {
+            break;
+        }
+        if (pid == 0) {
+            runWorker(coordinator, i, shard);
+        }
+    }
+
+    // 给工作进程足够时间生成载荷池和建立epoll
+    if (!coordinator.release(30000)) {
+        std::cerr << "Multi-process test cancelled" << std::endl;
+        coordinator.waitAll();
+        return;
+    }
+    coordinator.waitAll();
+
+    stats_.reset();
+    for (int i = 0; i < coordinator.spawned(); ++i) {
+        const char* data;
+        size_t length;
+        TestStats worker;
+        if (!coordinator.result(i, data, length) || !worker.readFrom(data, data + length)) {
+            std::cerr << "Worker " << i << " reported no results" << std::endl;
+            continue;
+        }
+        stats_.merge(worker);
+    }
+    printStats();
+    writeJson();
+}
+
+void PressureTest::runWorker(ProcessCoordinator& coordinator, int index, const ClientConfig& shard) {
+    config_ = shard;
+    if (config_.num_threads > config_.concurrent_connections) {
+        config_.num_threads = std::max(config_.concurrent_connections, 1);
+    }
+    bool ready = createClients(config_);
+    if (!coordinator.arriveAndWait(ready)) {
+        _exit(1);
+    }
+    runPhase();
+    std::vector<char> data;
+    stats_.appendTo(data);
+    _exit(coordinator.publish(index, data) ? 0 : 1);
+}
+
+void PressureTest::runAdversaryProfiles() {
+    profile_results_.clear();
+    std::vector<std::string> profiles = config_.adversary_profiles;
+    profiles.insert(profiles.begin(), "baseline");
+
+    for (size_t i = 0; i < profiles.size(); ++i) {
+        // 每个阶段使用全新的正常连接
+        if (i > 0 && !createClients(config_)) {
+            return;
+        }
+
+        std::unique_ptr<AdversaryClient> adversary;
+        std::thread adversary_thread;
+        AdversaryClient::Profile profile;
+        if (AdversaryClient::parseProfile(profiles[i], profile)) {
+            adversary.reset(new AdversaryClient(config_, profile));
+            adversary_thread = std::thread(&AdversaryClient::runTest, adversary.get());
+        }
+
+        std::cout << "Profile " << i + 1 << "/" << profiles.size() << ": " << profiles[i] << std::endl;
+        runPhase();
+
+        ProfileResult result;
+        result.profile = profiles[i];
+        if (adversary) {
+            adversary->stopTest();
+            adversary_thread.join();
+            result.adversary = adversary->stats();
+        }
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            stats_.end_time - stats_.start_time);
+        double duration_sec = duration.count() / 1000.0;
+        result.achieved_rate = duration_sec > 0 ? stats_.messages_received / duration_sec : 0;
+        result.timeouts = stats_.timeouts;
+        result.failed_connections = stats_.failed_connections;
+        result.echo_mismatches = stats_.echo_mismatches;
+        result.p50_ns = stats_.latency.percentile(50);
+        result.p99_ns = stats_.latency.percentile(99);
+        result.p999_ns = stats_.latency.percentile(99.9);
+        result.max_ns = stats_.latency.max();
+        profile_results_.push_back(result);
+    }
+    printAdversaryProfiles();
+    writeJson();
+}
+
+void PressureTest::printAdversaryProfiles() {
+    std::cout << "\n=== Adversary Profile Results (well-behaved traffic) ===" << std::endl;
+    std::cout << std::left << std::setw(14) << "Profile" << std::setw(14) << "Rate(req/s)"
+              << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)" << std::setw(12) << "p99.9(us)"
+              << std::setw(12) << "max(us)" << std::setw(10) << "p99 x" << std::setw(10) << "Timeouts"
+              << "Adversary conns/closed/resets" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    int64_t base_p99 = profile_results_.empty() ? 1 : std::max<int64_t>(profile_results_.front().p99_ns, 1);
+    for (const auto& result : profile_results_) {
+        std::cout << std::setw(14) << result.profile << std::setw(14) << result.achieved_rate
+                  << std::setw(12) << result.p50_ns / 1000.0 << std::setw(12) << result.p99_ns / 1000.0
+                  << std::setw(12) << result.p999_ns / 1000.0 << std::setw(12) << result.max_ns / 1000.0
+                  << std::setw(10) << static_cast<double>(result.p99_ns) / base_p99
+                  << std::setw(10) << result.timeouts
+                  << result.adversary.connections << "/" << result.adversary.server_closes
+                  << "/" << result.adversary.resets << std::endl;
+    }
+    std::cout << std::right;
+}
+
+bool PressureTest::createChurnClients() {
+    churn_clients_.clear();
+    int base = config_.concurrent_connections / config_.num_threads;
+    int remainder = config_.concurrent_connections % config_.num_threads;
+
+    for (int i = 0; i < config_.num_threads; ++i) {
+        // 并发连接数在短连接模式下是进行中会话的上限
+        ClientConfig shard = config_;
+        shard.concurrent_connections = base + (i < remainder ? 1 : 0);
+
+        std::unique_ptr<ChurnClient> client(new ChurnClient(shard, i));
+        if (!client->initialize()) {
+            std::cerr << "Failed to initialize churn client " << i << std::endl;
+            churn_clients_.clear();
+            return false;
+        }
+        churn_clients_.push_back(std::move(client));
+    }
+    return true;
+}
+
+void PressureTest::runChurn() {
+    if (churn_clients_.empty()) {
+        std::cerr << "Pressure test not initialized" << std::endl;
+        return;
+    }
+
+    std::cout << "Starting churn test at " << config_.churn_rate << " conn/s with "
+              << churn_clients_.size() << " thread(s)..." << std::endl;
+    runClients(churn_clients_, churn_stats_);
+    printChurnStats();
+    writeChurnJson();
+}
+
+void PressureTest::runRateSweep() {
+    rate_steps_.clear();
+    for (size_t i = 0; i < config_.rates.size(); ++i) {
+        ClientConfig phase = config_;
+        phase.rate = config_.rates[i];
+        // 每个阶段使用全新的连接，避免上一阶段的积压影响结果
+        if (i > 0 && !createClients(phase)) {
+            return;
+        }
+
+        std::cout << "Rate step " << i + 1 << "/" << config_.rates.size()
+                  << ": " << phase.rate << " req/s" << std::endl;
+        runPhase();
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            stats_.end_time - stats_.start_time);
+        double duration_sec = duration.count() / 1000.0;
+
+        RateStep step;
+        step.target_rate = phase.rate;
+        step.achieved_rate = duration_sec > 0 ? stats_.messages_received / duration_sec : 0;
+        step.timeout_rate = duration_sec > 0 ? stats_.timeouts / duration_sec : 0;
+        step.p50_ns = stats_.latency.percentile(50);
+        step.p99_ns = stats_.latency.percentile(99);
+        step.p999_ns = stats_.latency.percentile(99.9);
+        step.max_ns = stats_.latency.max();
+        rate_steps_.push_back(step);
+    }
+    printRateSweep();
+    writeJson();
+}
+
+void PressureTest::printRateSweep() {
+    std::cout << "\n=== Rate Sweep Results ===" << std::endl;
+    std::cout << std::left << std::setw(16) << "Target(req/s)" << std::setw(18) << "Achieved(req/s)"
+              << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)"
+              << std::setw(12) << "p99.9(us)" << std::setw(12) << "max(us)" << "Timeouts/s" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& step : rate_steps_) {
+        std::cout << std::setw(16) << step.target_rate << std::setw(18) << step.achieved_rate
+                  << std::setw(12) << step.p50_ns / 1000.0 << std::setw(12) << step.p99_ns / 1000.0
+                  << std::setw(12) << step.p999_ns / 1000.0 << std::setw(12) << step.max_ns / 1000.0
+                  << step.timeout_rate << std::endl;
+    }
+    std::cout << std::right;
+
+    // 拐点: 第一个p99超过最低速率p99两倍，或实际吞吐低于目标95%的阶段
+    if (rate_steps_.empty()) {
+        return;
+    }
+    int64_t base_p99 = std::max<int64_t>(rate_steps_.front().p99_ns, 1);
+    for (size_t i = 1; i < rate_steps_.size(); ++i) {
+        const RateStep& step = rate_steps_[i];
+        if (step.p99_ns > 2 * base_p99 || step.achieved_rate < step.target_rate * 0.95) {
+            std::cout << "Latency knee: p99 bends upward between "
+                      << rate_steps_[i - 1].achieved_rate << " and "
+                      << step.achieved_rate << " req/s" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Latency knee: not reached up to "
+              << rate_steps_.back().achieved_rate << " req/s" << std::endl;
+}
+
+void PressureTest::stopTest() {
+    for (auto& client : clients_) {
+        client->stopTest();
+    }
+    for (auto& client : churn_clients_) {
+        client->stopTest();
+    }
+}
+
+void PressureTest::printStats() {
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        stats_.end_time - stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+    
+    std::cout << "\n=== Pressure Test Results ===" << std::endl;
+    if (config_.processes > 1) {
+        std::cout << "Processes: " << config_.processes << " x " << config_.num_threads << " thread(s)" << std::endl;
+    } else {
+        std::cout << "Threads: " << clients_.size() << std::endl;
+    }
+    std::cout << "Pipeline depth: " << config_.pipeline_depth << std::endl;
+    if (config_.rate > 0) {
+        std::cout << "Target rate: " << config_.rate << " req/s ("
+                  << (config_.poisson_arrivals ? "poisson" : "uniform") << ")" << std::endl;
+    }
+    std::cout << "Duration: " << duration_sec << " seconds" << std::endl;
+    std::cout << "Total connections: " << stats_.total_connections << std::endl;
+    std::cout << "Successful connections: " << stats_.successful_connections << std::endl;
+    std::cout << "Failed connections: " << stats_.failed_connections << std::endl;
+    std::cout << "Timeouts: " << stats_.timeouts << std::endl;
+    std::cout << "Messages sent: " << stats_.messages_sent << std::endl;
+    std::cout << "Messages received: " << stats_.messages_received << std::endl;
+    std::cout << "Bytes sent: " << stats_.bytes_sent << std::endl;
+    std::cout << "Bytes received: " << stats_.bytes_received << std::endl;
+    std::cout << "Echo mismatches: " << stats_.echo_mismatches << std::endl;
+    std::cout << "Server errors: " << stats_.server_errors << std::endl;
+    
+    if (duration_sec > 0) {
+        std::cout << "Connections per second: " 
+                  << stats_.total_connections / duration_sec << std::endl;
+        std::cout << "Messages per second: " 
+                  << stats_.messages_sent / duration_sec << std::endl;
+        std::cout << "Timeouts per second: " 
+                  << stats_.timeouts / duration_sec << std::endl;
+        std::cout << "Throughput: " 
+                  << (stats_.bytes_sent + stats_.bytes_received) / duration_sec / 1024 
+                  << " KB/s" << std::endl;
+    }
+    
+    printLatency("Latency", stats_.latency);
+    if (!config_.size_distribution.empty()) {
+        std::cout << "Size distribution: " << config_.size_distribution << std::endl;
+        stats_.size_buckets.print(std::cout, duration_sec);
+    }
+    
+    double success_rate = (stats_.total_connections > 0) ? 
+        (static_cast<double>(stats_.successful_connections) / stats_.total_connections * 100) : 0;
+    std::cout << "Success rate: " << std::fixed << std::setprecision(2) 
+              << success_rate << "%" << std::endl;
+}
+
+void PressureTest::writeJson() {
+    if (config_.json_output.empty()) {
+        return;
+    }
+    std::ofstream out(config_.json_output);
+    if (!out) {
+        std::cerr << "Open json output failed: " << config_.json_output << std::endl;
+        return;
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        stats_.end_time - stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+
+    // 扁平结构，便于脚本和基准驱动程序解析
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"processes\": " << config_.processes << ",\n";
+    out << "  \"threads\": " << (config_.processes > 1 ? static_cast<size_t>(config_.num_threads) : clients_.size()) << ",\n";
+    out << "  \"connections\": " << config_.concurrent_connections << ",\n";
+    out << "  \"message_size\": " << config_.message_size << ",\n";
+    out << "  \"pipeline_depth\": " << config_.pipeline_depth << ",\n";
+    out << "  \"rate\": " << config_.rate << ",\n";
+    out << "  \"duration_sec\": " << duration_sec << ",\n";
+    out << "  \"total_connections\": " << stats_.total_connections << ",\n";
+    out << "  \"failed_connections\": " << stats_.failed_connections << ",\n";
+    out << "  \"timeouts\": " << stats_.timeouts << ",\n";
+    out << "  \"echo_mismatches\": " << stats_.echo_mismatches << ",\n";
+    out << "  \"server_errors\": " << stats_.server_errors << ",\n";
+    out << "  \"messages_sent\": " << stats_.messages_sent << ",\n";
+    out << "  \"messages_received\": " << stats_.messages_received << ",\n";
+    out << "  \"bytes_sent\": " << stats_.bytes_sent << ",\n";
+    out << "  \"bytes_received\": " << stats_.bytes_received << ",\n";
+    out << "  \"messages_per_sec\": " << (duration_sec > 0 ? stats_.messages_received / duration_sec : 0) << ",\n";
+    out << "  \"throughput_kbps\": "
+        << (duration_sec > 0 ? (stats_.bytes_sent + stats_.bytes_received) / duration_sec / 1024 : 0) << ",\n";
+    writeLatencyJson(out, "latency", stats_.latency);
+    if (!config_.size_distribution.empty()) {
+        out << ",\n  \"size_distribution\": \"" << config_.size_distribution << "\"";
+        out << ",\n  \"size_buckets\": ";
+        stats_.size_buckets.writeJson(out, duration_sec);
+    }
+
+    // 异常画像测试时附带每个画像下正常流量的结果
+    if (!profile_results_.empty()) {
+        out << ",\n  \"adversary_profiles\": [\n";
+        for (size_t i = 0; i < profile_results_.size(); ++i) {
+            const ProfileResult& result = profile_results_[i];
+            out << "    {\"profile\": \"" << result.profile << "\""
+                << ", \"achieved_rate\": " << result.achieved_rate
+                << ", \"timeouts\": " << result.timeouts
+                << ", \"failed_connections\": " << result.failed_connections
+                << ", \"echo_mismatches\": " << result.echo_mismatches
+                << ", \"latency_p50_us\": " << result.p50_ns / 1000.0
+                << ", \"latency_p99_us\": " << result.p99_ns / 1000.0
+                << ", \"latency_p999_us\": " << result.p999_ns / 1000.0
+                << ", \"latency_max_us\": " << result.max_ns / 1000.0
+                << ", \"adversary_connections\": " << result.adversary.connections
+                << ", \"adversary_server_closes\": " << result.adversary.server_closes
+                << ", \"adversary_resets\": " << result.adversary.resets << "}"
+                << (i + 1 < profile_results_.size() ? ",\n" : "\n");
+        }
+        out << "  ]";
+    }
+
+    // 速率扫描时附带每个阶段的结果
+    if (!rate_steps_.empty()) {
+        out << ",\n  \"rate_steps\": [\n";
+        for (size_t i = 0; i < rate_steps_.size(); ++i) {
+            const RateStep& step = rate_steps_[i];
+            out << "    {\"target_rate\": " << step.target_rate
+                << ", \"achieved_rate\": " << step.achieved_rate
+                << ", \"timeouts_per_sec\": " << step.timeout_rate
+                << ", \"latency_p50_us\": " << step.p50_ns / 1000.0
+                << ", \"latency_p99_us\": " << step.p99_ns / 1000.0
+                << ", \"latency_p999_us\": " << step.p999_ns / 1000.0
+                << ", \"latency_max_us\": " << step.max_ns / 1000.0 << "}"
+                << (i + 1 < rate_steps_.size() ? ",\n" : "\n");
+        }
+        out << "  ]";
+    }
+    out << "\n}\n";
+}
+
+void PressureTest::printChurnStats() {
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        churn_stats_.end_time - churn_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+
+    std::cout << "\n=== Churn Test Results ===" << std::endl;
+    std::cout << "Threads: " << churn_clients_.size() << std::endl;
+    std::cout << "Target rate: " << config_.churn_rate << " conn/s ("
+              << (config_.poisson_arrivals ? "poisson" : "uniform") << ", "
+              << (config_.churn_rst_close ? "RST close" : "graceful close") << ")" << std::endl;
+    std::cout << "Duration: " << duration_sec << " seconds" << std::endl;
+    std::cout << "Attempted connections: " << churn_stats_.attempted << std::endl;
+    std::cout << "Completed sessions: " << churn_stats_.completed << std::endl;
+    std::cout << "Connect failures: " << churn_stats_.connect_failures << std::endl;
+    std::cout << "I/O failures: " << churn_stats_.io_failures << std::endl;
+    std::cout << "Timeouts: " << churn_stats_.timeouts << std::endl;
+    std::cout << "Echo mismatches: " << churn_stats_.echo_mismatches << std::endl;
+    if (duration_sec > 0) {
+        std::cout << "Achieved rate: " << churn_stats_.completed / duration_sec << " conn/s" << std::endl;
+    }
+
+    // 各阶段延迟分布(微秒)
+    struct {
+        const char* name;
+        const LatencyHistogram* latency;
+    } phases[] = {
+        {"Connect", &churn_stats_.connect_latency},
+        {"First byte", &churn_stats_.first_byte_latency},
+        {"Close", &churn_stats_.close_latency},
+        {"Session", &churn_stats_.session_latency},
+    };
+    for (const auto& phase : phases) {
+        printLatency(std::string(phase.name) + " latency", *phase.latency);
+    }
+}
+
+void PressureTest::writeChurnJson() {
+    if (config_.json_output.empty()) {
+        return;
+    }
+    std::ofstream out(config_.json_output);
+    if (!out) {
+        std::cerr << "Open json output failed: " << config_.json_output << std::endl;
+        return;
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        churn_stats_.end_time - churn_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"mode\": \"churn\",\n";
+    out << "  \"threads\": " << churn_clients_.size() << ",\n";
+    out << "  \"message_size\": " << config_.message_size << ",\n";
+    out << "  \"churn_rate\": " << config_.churn_rate << ",\n";
+    out << "  \"rst_close\": " << (config_.churn_rst_close ? "true" : "false") << ",\n";
+    out << "  \"duration_sec\": " << duration_sec << ",\n";
+    out << "  \"attempted\": " << churn_stats_.attempted << ",\n";
+    out << "  \"completed\": " << churn_stats_.completed << ",\n";
+    out << "  \"connect_failures\": " << churn_stats_.connect_failures << ",\n";
+    out << "  \"io_failures\": " << churn_stats_.io_failures << ",\n";
+    out << "  \"timeouts\": " << churn_stats_.timeouts << ",\n";
+    out << "  \"echo_mismatches\": " << churn_stats_.echo_mismatches << ",\n";
+    out << "  \"connections_per_sec\": " << (duration_sec > 0 ? churn_stats_.completed / duration_sec : 0);
+
+    struct {
+        const char* prefix;
+        const LatencyHistogram* latency;
+    } phases[] = {
+        {"connect", &churn_stats_.connect_latency},
+        {"first_byte", &churn_stats_.first_byte_latency},
+        {"close", &churn_stats_.close_latency},
+        {"session", &churn_stats_.session_latency},
+    };
+    for (const auto& phase : phases) {
+        out << ",\n";
+        writeLatencyJson(out, phase.prefix, *phase.latency);
+    }
+    out << "\n}\n";
+}
+
+bool PressureTest::createFanoutClients() {
+    fanout_clients_.clear();
+    int base = config_.fanout_subscribers / config_.num_threads;
+    int remainder = config_.fanout_subscribers % config_.num_threads;
+
+    std::cout << "Subscribing " << config_.fanout_subscribers << " connections..." << std::endl;
+    for (int i = 0; i < config_.num_threads; ++i) {
+        int subscribers = base + (i < remainder ? 1 : 0);
+        std::unique_ptr<FanoutClient> client(new FanoutClient(config_, i, subscribers, i == 0));
+        if (!client->initialize()) {
+            std::cerr << "Failed to initialize fanout client " << i << std::endl;
+            fanout_clients_.clear();
+            return false;
+        }
+        fanout_clients_.push_back(std::move(client));
+    }
+    return true;
+}
+
+void PressureTest::runFanout() {
+    if (fanout_clients_.empty()) {
+        std::cerr << "Pressure test not initialized" << std::endl;
+        return;
+    }
+
+    std::cout << "Starting fan-out test to " << config_.fanout_subscribers << " subscribers with "
+              << fanout_clients_.size() << " thread(s)..." << std::endl;
+    runClients(fanout_clients_, fanout_stats_);
+    printFanoutStats();
+    writeFanoutJson();
+}
+
+void PressureTest::printFanoutStats() {
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        fanout_stats_.end_time - fanout_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+    long expected = fanout_stats_.published * fanout_stats_.subscribers;
+
+    std::cout << "\n=== Fan-out Test Results ===" << std::endl;
+    std::cout << "Threads: " << fanout_clients_.size() << std::endl;
+    std::cout << "Subscribers: " << fanout_stats_.subscribers << " (connect failures: "
+              << fanout_stats_.connect_failures << ")" << std::endl;
+    std::cout << "Duration: " << duration_sec << " seconds" << std::endl;
+    std::cout << "Published: " << fanout_stats_.published << std::endl;
+    std::cout << "Delivered: " << fanout_stats_.delivered << " of " << expected << std::endl;
+    std::cout << "Gaps: " << fanout_stats_.gaps << std::endl;
+    std::cout << "Disconnects: " << fanout_stats_.disconnects << std::endl;
+    std::cout << "Invalid frames: " << fanout_stats_.invalid << std::endl;
+    if (duration_sec > 0) {
+        std::cout << "Delivered messages per second: " << fanout_stats_.delivered / duration_sec << std::endl;
+    }
+    printLatency("Delivery latency", fanout_stats_.latency);
+}
+
+void PressureTest::writeFanoutJson() {
+    if (config_.json_output.empty()) {
+        return;
+    }
+    std::ofstream out(config_.json_output);
+    if (!out) {
+        std::cerr << "Open json output failed: " << config_.json_output << std::endl;
+        return;
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        fanout_stats_.end_time - fanout_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"mode\": \"fanout\",\n";
+    out << "  \"threads\": " << fanout_clients_.size() << ",\n";
+    out << "  \"message_size\": " << config_.message_size << ",\n";
+    out << "  \"subscribers\": " << fanout_stats_.subscribers << ",\n";
+    out << "  \"duration_sec\": " << duration_sec << ",\n";
+    out << "  \"published\": " << fanout_stats_.published << ",\n";
+    out << "  \"delivered\": " << fanout_stats_.delivered << ",\n";
+    out << "  \"gaps\": " << fanout_stats_.gaps << ",\n";
+    out << "  \"disconnects\": " << fanout_stats_.disconnects << ",\n";
+    out << "  \"delivered_per_sec\": " << (duration_sec > 0 ? fanout_stats_.delivered / duration_sec : 0) << ",\n";
+    writeLatencyJson(out, "latency", fanout_stats_.latency);
+    out << "\n}\n";
+}
+
+bool PressureTest::createKvClients() {
+    kv_clients_.clear();
+    int base = config_.concurrent_connections / config_.num_threads;
+    int remainder = config_.concurrent_connections % config_.num_threads;
+
+    for (int i = 0; i < config_.num_threads; ++i) {
+        int connections = base + (i < remainder ? 1 : 0);
+        std::unique_ptr<KvClient> client(new KvClient(config_, i, connections));
+        if (!client->initialize()) {
+            std::cerr << "Failed to initialize kv client " << i << std::endl;
+            kv_clients_.clear();
+            return false;
+        }
+        kv_clients_.push_back(std::move(client));
+    }
+    return true;
+}
+
+void PressureTest::runKv() {
+    if (kv_clients_.empty()) {
+        std::cerr << "Pressure test not initialized" << std::endl;
+        return;
+    }
+
+    std::cout << "Starting kv test over " << config_.kv_keys << " " << config_.kv_distribution << " keys with "
+              << kv_clients_.size() << " thread(s)..." << std::endl;
+    runClients(kv_clients_, kv_stats_);
+    printKvStats();
+    writeKvJson();
+}
+
+void PressureTest::printKvStats() {
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        kv_stats_.end_time - kv_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+    long completed = kv_stats_.latency.count();
+
+    std::cout << "\n=== KV Test Results ===" << std::endl;
+    std::cout << "Threads: " << kv_clients_.size() << std::endl;
+    std::cout << "Connections: " << kv_stats_.connections << " (connect failures: "
+              << kv_stats_.connect_failures << ")" << std::endl;
+    std::cout << "Key distribution: " << config_.kv_distribution;
+    if (config_.kv_distribution == "zipf") {
+        std::cout << " (theta " << config_.zipf_theta << ")";
+    }
+    std::cout << " over " << config_.kv_keys << " keys" << std::endl;
+    std::cout << "Duration: " << duration_sec << " seconds" << std::endl;
+    std::cout << "Completed: " << completed << " (GET " << kv_stats_.gets << ", SET " << kv_stats_.sets
+              << " issued)" << std::endl;
+    if (kv_stats_.hits + kv_stats_.misses > 0) {
+        std::cout << "GET hit ratio: " << kv_stats_.hits * 100.0 / (kv_stats_.hits + kv_stats_.misses)
+                  << "%" << std::endl;
+    }
+    std::cout << "Errors: " << kv_stats_.errors << std::endl;
+    std::cout << "Value mismatches: " << kv_stats_.mismatches << std::endl;
+    std::cout << "Disconnects: " << kv_stats_.disconnects << std::endl;
+    if (duration_sec > 0) {
+        std::cout << "Operations per second: " << completed / duration_sec << std::endl;
+    }
+    printLatency("Latency", kv_stats_.latency);
+}
+
+void PressureTest::writeKvJson() {
+    if (config_.json_output.empty()) {
+        return;
+    }
+    std::ofstream out(config_.json_output);
+    if (!out) {
+        std::cerr << "Open json output failed: " << config_.json_output << std::endl;
+        return;
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        kv_stats_.end_time - kv_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+    const LatencyHistogram& latency = kv_stats_.latency;
+    long lookups = kv_stats_.hits + kv_stats_.misses;
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"mode\": \"kv\",\n";
+    out << "  \"threads\": " << kv_clients_.size() << ",\n";
+    out << "  \"connections\": " << kv_stats_.connections << ",\n";
+    out << "  \"pipeline_depth\": " << config_.pipeline_depth << ",\n";
+    out << "  \"value_size\": " << config_.message_size << ",\n";
+    out << "  \"keys\": " << config_.kv_keys << ",\n";
+    out << "  \"distribution\": \"" << config_.kv_distribution << "\",\n";
+    out << "  \"zipf_theta\": " << config_.zipf_theta << ",\n";
+    out << "  \"set_ratio\": " << config_.kv_set_ratio << ",\n";
+    out << "  \"duration_sec\": " << duration_sec << ",\n";
+    out << "  \"completed\": " << latency.count() << ",\n";
+    out << "  \"ops_per_sec\": " << (duration_sec > 0 ? latency.count() / duration_sec : 0) << ",\n";
+    out << "  \"hit_ratio\": " << (lookups > 0 ? static_cast<double>(kv_stats_.hits) / lookups : 0) << ",\n";
+    out << "  \"errors\": " << kv_stats_.errors << ",\n";
+    out << "  \"mismatches\": " << kv_stats_.mismatches << ",\n";
+    out << "  \"disconnects\": " << kv_stats_.disconnects << ",\n";
+    writeLatencyJson(out, "latency", latency);
+    out << "\n}\n";
+}
+
+bool PressureTest::createReplayClients() {
+    replay_clients_.clear();
+    if (!replay_trace_.load(config_.replay_trace)) {
+        return false;
+    }
+    // 回放连接数不超过录制中的连接数，线程数不超过回放连接数
+    config_.concurrent_connections = static_cast<int>(std::min<uint64_t>(
+        config_.concurrent_connections, std::max<uint64_t>(replay_trace_.connections(), 1)));
+    config_.num_threads = std::min(config_.num_threads, config_.concurrent_connections);
+    std::cout << "Loaded " << replay_trace_.size() << " frames from " << replay_trace_.connections()
+              << " connections over " << replay_trace_.durationNs() / 1e9 << " seconds"
+              << (replay_trace_.hasPayloads() ? " (with payloads)" : "") << std::endl;
+
+    for (int i = 0; i < config_.num_threads; ++i) {
+        std::unique_ptr<ReplayClient> client(new ReplayClient(config_, i, replay_trace_));
+        if (!client->initialize()) {
+            std::cerr << "Failed to initialize replay client " << i << std::endl;
+            replay_clients_.clear();
+            return false;
+        }
+        replay_clients_.push_back(std::move(client));
+    }
+    return true;
+}
+
+void PressureTest::runReplay() {
+    if (replay_clients_.empty()) {
+        std::cerr << "Pressure test not initialized" << std::endl;
+        return;
+    }
+
+    std::cout << "Replaying " << config_.replay_trace << " at " << config_.replay_speed << "x over "
+              << config_.concurrent_connections << " connections with " << replay_clients_.size()
+              << " thread(s)..." << std::endl;
+    runClients(replay_clients_, replay_stats_);
+    printReplayStats();
+    writeReplayJson();
+}
+
+void PressureTest::printReplayStats() {
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        replay_stats_.end_time - replay_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+
+    std::cout << "\n=== Replay Results ===" << std::endl;
+    std::cout << "Threads: " << replay_clients_.size() << std::endl;
+    std::cout << "Connections: " << replay_stats_.connections << " (connect failures: "
+              << replay_stats_.connect_failures << ")" << std::endl;
+    std::cout << "Speed: " << config_.replay_speed << "x" << std::endl;
+    std::cout << "Duration: " << duration_sec << " seconds" << std::endl;
+    std::cout << "Sent: " << replay_stats_.sent << " of " << replay_trace_.size() << " frames ("
+              << replay_stats_.skipped << " skipped on closed connections)" << std::endl;
+    std::cout << "Received: " << replay_stats_.received << std::endl;
+    std::cout << "Sent late (>1 ms behind schedule): " << replay_stats_.late << std::endl;
+    std::cout << "Errors: " << replay_stats_.errors << std::endl;
+    std::cout << "Disconnects: " << replay_stats_.disconnects << std::endl;
+    if (duration_sec > 0) {
+        std::cout << "Requests per second: " << replay_stats_.received / duration_sec << std::endl;
+        std::cout << "Throughput: " << replay_stats_.bytes_sent / 1024.0 / duration_sec << " KB/s" << std::endl;
+    }
+    printLatency("Latency", replay_stats_.latency);
+}
+
+void PressureTest::writeReplayJson() {
+    if (config_.json_output.empty()) {
+        return;
+    }
+    std::ofstream out(config_.json_output);
+    if (!out) {
+        std::cerr << "Open json output failed: " << config_.json_output << std::endl;
+        return;
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        replay_stats_.end_time - replay_stats_.start_time);
+    double duration_sec = duration.count() / 1000.0;
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"mode\": \"replay\",\n";
+    out << "  \"trace\": \"" << config_.replay_trace << "\",\n";
+    out << "  \"speed\": " << config_.replay_speed << ",\n";
+    out << "  \"threads\": " << replay_clients_.size() << ",\n";
+    out << "  \"connections\": " << replay_stats_.connections << ",\n";
+    out << "  \"duration_sec\": " << duration_sec << ",\n";
+    out << "  \"trace_frames\": " << replay_trace_.size() << ",\n";
+    out << "  \"sent\": " << replay_stats_.sent << ",\n";
+    out << "  \"received\": " << replay_stats_.received << ",\n";
+    out << "  \"skipped\": " << replay_stats_.skipped << ",\n";
+    out << "  \"late\": " << replay_stats_.late << ",\n";
+    out << "  \"errors\": " << replay_stats_.errors << ",\n";
+    out << "  \"disconnects\": " << replay_stats_.disconnects << ",\n";
+    out << "  \"requests_per_sec\": " << (duration_sec > 0 ? replay_stats_.received / duration_sec : 0) << ",\n";
+    writeLatencyJson(out, "latency", replay_stats_.latency);
+    out << "\n}\n";
+}
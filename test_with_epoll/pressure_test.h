@@ -0,0 +1,100 @@
+#ifndef PRESSURE_TEST_H
+#define PRESSURE_TEST_H
+
+#include "pressure_client.h"
+#include "churn_client.h"
+#include "adversary_client.h"
+#include "fanout_client.h"
+#include "kv_client.h"
+#include "replay_client.h"
+#include "process_coordinator.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 多线程压测：将连接分片到多个PressureClient，每个线程一个epoll，结束后合并统计
+class PressureTest {
+public:
+    PressureTest(const ClientConfig& config);
+    ~PressureTest();
+
+    bool initialize();
+    void runTest();
+    void stopTest();
+    void printStats();
+
+private:
+    // 速率扫描中单个阶段的结果
+    struct RateStep {
+        double target_rate;
+        double achieved_rate;
+        double timeout_rate;
+        int64_t p50_ns;
+        int64_t p99_ns;
+        int64_t p999_ns;
+        int64_t max_ns;
+    };
+
+    // 异常客户端画像下正常流量的结果
+    struct ProfileResult {
+        std::string profile;
+        double achieved_rate;
+        long timeouts;
+        long failed_connections;
+        long echo_mismatches;
+        int64_t p50_ns;
+        int64_t p99_ns;
+        int64_t p999_ns;
+        int64_t max_ns;
+        AdversaryStats adversary;
+    };
+
+    bool createClients(const ClientConfig& config);   // 按线程分片创建客户端
+    // 各模式共用: 每个客户端一个线程运行到结束，再把各客户端的统计合并到merged(先清空)
+    template <typename Client, typename Stats>
+    void runClients(std::vector<std::unique_ptr<Client>>& clients, Stats& merged);
+    void runPhase();                                    // 运行一个阶段并合并统计
+    void runRateSweep();                                // 依次测试各速率
+    void printRateSweep();                              // 输出扫描结果及延迟拐点
+    void writeJson();                                   // 输出机器可读的结果
+    void runAdversaryProfiles();                        // 先跑基线，再依次与各异常画像同时运行
+    void printAdversaryProfiles();
+    bool createChurnClients();                          // 短连接模式: 按线程分片创建客户端
+    void runChurn();                                    // 短连接模式: 运行并合并统计
+    void printChurnStats();
+    void writeChurnJson();
+    bool createFanoutClients();                         // 扇出模式: 订阅连接按线程分片，线程0负责发布
+    void runFanout();
+    void printFanoutStats();
+    void writeFanoutJson();
+    bool createKvClients();                             // 键值模式: 连接按线程分片
+    void runKv();
+    void printKvStats();
+    void writeKvJson();
+    bool createReplayClients();                         // 回放模式: 加载录制文件，回放连接按线程分片
+    void runReplay();
+    void printReplayStats();
+    void writeReplayJson();
+    void runProcesses();                                // 多进程模式: fork工作进程，同时放行并合并统计
+    // 工作进程: 按分片配置建立客户端，等待放行后运行并写回统计，不返回
+    void runWorker(ProcessCoordinator& coordinator, int index, const ClientConfig& shard);
+
+private:
+    ClientConfig config_;
+    std::vector<std::unique_ptr<PressureClient>> clients_;  // 每线程一个客户端
+    std::vector<std::thread> threads_;                      // 工作线程
+    TestStats stats_;                                       // 合并后的统计
+    std::vector<RateStep> rate_steps_;                      // 速率扫描结果
+    std::vector<ProfileResult> profile_results_;            // 异常画像测试结果
+    std::vector<std::unique_ptr<ChurnClient>> churn_clients_;   // 短连接模式客户端
+    ChurnStats churn_stats_;                                // 短连接模式合并后的统计
+    std::vector<std::unique_ptr<FanoutClient>> fanout_clients_; // 扇出模式客户端
+    FanoutStats fanout_stats_;                              // 扇出模式合并后的统计
+    std::vector<std::unique_ptr<KvClient>> kv_clients_;     // 键值模式客户端
+    KvStats kv_stats_;                                      // 键值模式合并后的统计
+    ReplayTrace replay_trace_;                              // 回放模式的录制文件，各线程共用
+    std::vector<std::unique_ptr<ReplayClient>> replay_clients_; // 回放模式客户端
+    ReplayStats replay_stats_;                              // 回放模式合并后的统计
+};
+
+#endif // PRESSURE_TEST_H
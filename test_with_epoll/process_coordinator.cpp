@@ -0,0 +1,159 @@
+#include "process_coordinator.h"
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/futex.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex requires a plain int");
+
+// 共享内存是MAP_SHARED映射，不能用FUTEX_PRIVATE_FLAG
+static void futexWait(std::atomic<int>* word, int expected) {
+    syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+}
+
+static void futexWakeAll(std::atomic<int>* word) {
+    syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+ProcessCoordinator::ProcessCoordinator(int processes, size_t slot_bytes)
+    : processes_(processes), slot_bytes_(slot_bytes), memory_(nullptr), memory_size_(0), shared_(nullptr) {
+}
+
+ProcessCoordinator::~ProcessCoordinator() {
+    if (memory_ != nullptr) {
+        munmap(memory_, memory_size_);
+    }
+}
+
+size_t ProcessCoordinator::slotStride() const {
+    return alignUp(sizeof(uint64_t) + slot_bytes_, 64);
+}
+
+char* ProcessCoordinator::slot(int index) const {
+    return static_cast<char*>(memory_) + alignUp(sizeof(Shared), 64) + index * slotStride();
+}
+
+bool ProcessCoordinator::create() {
+    memory_size_ = alignUp(sizeof(Shared), 64) + processes_ * slotStride();
+    memory_ = mmap(nullptr, memory_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory_ == MAP_FAILED) {
+        std::cerr << "Map coordinator shared memory failed: " << strerror(errno) << std::endl;
+        memory_ = nullptr;
+        return false;
+    }
+    // 匿名映射已清零，槽位长度均为0
+    shared_ = new (memory_) Shared();
+    shared_->arrived = 0;
+    shared_->failed = 0;
+    shared_->gate = 0;
+    return true;
+}
+
+pid_t ProcessCoordinator::spawn() {
+    // 先刷出缓冲的输出，避免子进程退出时重复输出
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Fork worker process failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    if (pid == 0) {
+        // 协调进程被强制结束时工作进程随之退出，不留下孤儿进程继续压测
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        return 0;
+    }
+    pids_.push_back(pid);
+    exited_.push_back(false);
+    return pid;
+}
+
+bool ProcessCoordinator::arriveAndWait(bool ready) {
+    if (!ready) {
+        shared_->failed.fetch_add(1);
+    }
+    shared_->arrived.fetch_add(1);
+    int gate;
+    while ((gate = shared_->gate.load()) == 0) {
+        futexWait(&shared_->gate, 0);
+    }
+    return gate > 0 && ready;
+}
+
+bool ProcessCoordinator::publish(int index, const std::vector<char>& data) {
+    if (data.size() > slot_bytes_) {
+        std::cerr << "Worker " << index << " result exceeds " << slot_bytes_ << " bytes" << std::endl;
+        return false;
+    }
+    char* target = slot(index);
+    memcpy(target + sizeof(uint64_t), data.data(), data.size());
+    reinterpret_cast<std::atomic<uint64_t>*>(target)->store(data.size());
+    return true;
+}
+
+bool ProcessCoordinator::release(int timeout_ms) {
+    bool ok = spawned() == processes_;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (ok && shared_->arrived.load() < spawned()) {
+        // 到达屏障前退出的进程永远不会到达
+        for (size_t i = 0; i < pids_.size(); ++i) {
+            int status;
+            if (!exited_[i] && waitpid(pids_[i], &status, WNOHANG) == pids_[i]) {
+                exited_[i] = true;
+                std::cerr << "Worker process " << pids_[i] << " exited before start" << std::endl;
+                ok = false;
+            }
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            std::cerr << "Timed out waiting for worker processes, " << shared_->arrived.load()
+                      << "/" << spawned() << " ready" << std::endl;
+            ok = false;
+        }
+        if (ok) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    if (shared_->failed.load() > 0) {
+        std::cerr << shared_->failed.load() << " worker process(es) failed to initialize" << std::endl;
+        ok = false;
+    }
+    shared_->gate.store(ok ? 1 : -1);
+    futexWakeAll(&shared_->gate);
+    return ok;
+}
+
+void ProcessCoordinator::waitAll() {
+    for (size_t i = 0; i < pids_.size(); ++i) {
+        if (exited_[i]) {
+            continue;
+        }
+        int status = 0;
+        while (waitpid(pids_[i], &status, 0) == -1 && errno == EINTR) {
+        }
+        exited_[i] = true;
+        if (WIFSIGNALED(status)) {
+            std::cerr << "Worker process " << pids_[i] << " killed by signal " << WTERMSIG(status) << std::endl;
+        }
+    }
+}
+
+bool ProcessCoordinator::result(int index, const char*& data, size_t& length) const {
+    const char* source = slot(index);
+    length = reinterpret_cast<const std::atomic<uint64_t>*>(source)->load();
+    data = source + sizeof(uint64_t);
+    return length > 0;
+}
@@ -0,0 +1,55 @@
+#ifndef PROCESS_COORDINATOR_H
+#define PROCESS_COORDINATOR_H
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 多进程压测的协调: fork前建立匿名共享内存，包含一个启动屏障和每个工作进程一个结果槽位。
+// 工作进程初始化完成后到达屏障并在futex上睡眠，协调进程确认全部就绪后一次唤醒，各进程同时开始；
+// 结束时工作进程把序列化的统计写入自己的槽位，协调进程等所有进程退出后读取并合并
+class ProcessCoordinator {
+public:
+    ProcessCoordinator(int processes, size_t slot_bytes);
+    ~ProcessCoordinator();
+
+    bool create();                              // 建立共享内存，须在spawn之前调用
+    pid_t spawn();                              // fork下一个工作进程，父进程返回pid，子进程返回0，失败返回-1
+
+    // 工作进程: 报告初始化是否成功并等待放行，返回false表示测试被取消
+    bool arriveAndWait(bool ready);
+    // 工作进程: 把结果写入第index个槽位，超过槽位大小时返回false
+    bool publish(int index, const std::vector<char>& data);
+
+    // 协调进程: 等待所有工作进程到达屏障，全部就绪则放行并返回true；
+    // 有进程初始化失败、提前退出或超时则取消测试并返回false
+    bool release(int timeout_ms);
+    void waitAll();                             // 协调进程: 等待所有工作进程退出
+    // 协调进程: 读取第index个进程的结果，该进程未写回时返回false
+    bool result(int index, const char*& data, size_t& length) const;
+    int spawned() const { return static_cast<int>(pids_.size()); }
+
+private:
+    struct Shared {
+        std::atomic<int> arrived;               // 已到达屏障的进程数(含初始化失败的)
+        std::atomic<int> failed;                // 初始化失败的进程数
+        std::atomic<int> gate;                  // 0等待，1放行，-1取消；工作进程在此等待
+    };
+
+    // 槽位开头为结果长度，0表示尚未写回
+    char* slot(int index) const;
+    size_t slotStride() const;
+
+private:
+    int processes_;
+    size_t slot_bytes_;
+    void* memory_;
+    size_t memory_size_;
+    Shared* shared_;
+    std::vector<pid_t> pids_;
+    std::vector<bool> exited_;
+};
+
+#endif // PROCESS_COORDINATOR_H
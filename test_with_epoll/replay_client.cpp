@@ -0,0 +1,370 @@
+#include "replay_client.h"
+#include "client_util.h"
+#include "../include/frame.h"
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <iostream>
+#include <cerrno>
+#include <algorithm>
+
+ReplayTrace::ReplayTrace()
+    : data_(nullptr), size_(0), max_length_(0) {
+    memset(&header_, 0, sizeof(header_));
+}
+
+ReplayTrace::~ReplayTrace() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+bool ReplayTrace::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << "Open trace " << path << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(TraceFileHeader)) {
+        std::cerr << "Trace " << path << " is too short" << std::endl;
+        close(fd);
+        return false;
+    }
+    size_ = st.st_size;
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Map trace " << path << " failed: " << strerror(errno) << std::endl;
+        size_ = 0;
+        return false;
+    }
+    data_ = static_cast<const char*>(mapped);
+    memcpy(&header_, data_, sizeof(header_));
+    if (!validTraceHeader(header_)) {
+        std::cerr << "Trace " << path << " has an unknown format" << std::endl;
+        return false;
+    }
+
+    // 录制未正常结束时文件头中的记录数为0，此时读到最后一条完整的记录为止
+    uint64_t limit = header_.records > 0 ? header_.records : UINT64_MAX;
+    uint64_t connections = 0;
+    size_t offset = sizeof(TraceFileHeader);
+    while (index_.size() < limit && size_ - offset >= sizeof(TraceRecord)) {
+        const TraceRecord& current = *reinterpret_cast<const TraceRecord*>(data_ + offset);
+        size_t record_size = traceRecordSize(current, header_.flags);
+        if (size_ - offset < record_size) {
+            break;
+        }
+        index_.push_back(offset);
+        max_length_ = std::max(max_length_, current.length);
+        connections = std::max<uint64_t>(connections, current.connection + 1ULL);
+        offset += record_size;
+    }
+    if (header_.connections == 0) {
+        header_.connections = connections;
+    }
+    // 各worker按块写入，块之间时间交错
+    std::stable_sort(index_.begin(), index_.end(), [this](uint64_t a, uint64_t b) {
+        return reinterpret_cast<const TraceRecord*>(data_ + a)->time_ns <
+               reinterpret_cast<const TraceRecord*>(data_ + b)->time_ns;
+    });
+    if (index_.empty()) {
+        std::cerr << "Trace " << path << " has no records" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ReplayStats::merge(const ReplayStats& other) {
+    connections += other.connections;
+    connect_failures += other.connect_failures;
+    sent += other.sent;
+    received += other.received;
+    bytes_sent += other.bytes_sent;
+    late += other.late;
+    skipped += other.skipped;
+    errors += other.errors;
+    disconnects += other.disconnects;
+    latency.merge(other.latency);
+    if (start_time == std::chrono::steady_clock::time_point() || other.start_time < start_time) {
+        start_time = other.start_time;
+    }
+    if (other.end_time > end_time) {
+        end_time = other.end_time;
+    }
+}
+
+void ReplayStats::reset() {
+    connections = 0;
+    connect_failures = 0;
+    sent = 0;
+    received = 0;
+    bytes_sent = 0;
+    late = 0;
+    skipped = 0;
+    errors = 0;
+    disconnects = 0;
+    latency.reset();
+    start_time = std::chrono::steady_clock::time_point();
+    end_time = std::chrono::steady_clock::time_point();
+}
+
+ReplayClient::ReplayClient(const ClientConfig& config, int thread_id, const ReplayTrace& trace)
+    : config_(config), thread_id_(thread_id), trace_(trace), epoll_fd_(-1), running_(false), cursor_(0),
+      rng_(std::random_device{}() + thread_id) {
+}
+
+ReplayClient::~ReplayClient() {
+    stopTest();
+    for (auto& connection : connections_) {
+        if (connection.fd != -1) {
+            close(connection.fd);
+        }
+    }
+    connections_.clear();
+    if (epoll_fd_ != -1) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+bool ReplayClient::initialize() {
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ == -1) {
+        std::cerr << "Create epoll failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    receive_scratch_.resize(256 * 1024);
+    if (!trace_.hasPayloads()) {
+        filler_ = generatePayload(rng_, static_cast<int>(trace_.maxLength()));
+    }
+
+    // 回放连接j(j % num_threads == thread_id)放在slots_[j / num_threads]
+    for (int j = thread_id_; j < config_.concurrent_connections; j += config_.num_threads) {
+        int fd = connectBlocking(config_.server_ip, config_.server_port, stats_.connect_failures == 0);
+        slots_.push_back(fd);
+        if (fd == -1) {
+            stats_.connect_failures++;
+            continue;
+        }
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+        if (static_cast<size_t>(fd) >= connections_.size()) {
+            connections_.resize(fd + 1);
+        }
+        connections_[fd].fd = fd;
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        stats_.connections++;
+    }
+    return stats_.connections > 0;
+}
+
+void ReplayClient::runTest() {
+    if (epoll_fd_ == -1) {
+        std::cerr << "Replay client not initialized" << std::endl;
+        return;
+    }
+
+    running_ = true;
+    stats_.start_time = std::chrono::steady_clock::now();
+    auto replay_end = stats_.start_time + std::chrono::nanoseconds(
+        static_cast<long long>(trace_.durationNs() / config_.replay_speed));
+    // 发完最后一条记录后最多再等timeout_ms收齐响应
+    auto drain_end = replay_end + std::chrono::milliseconds(config_.timeout_ms);
+
+    std::vector<struct epoll_event> events(1024);
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        sendDue(now);
+        if ((cursor_ >= trace_.size() && inFlight() == 0) || now >= drain_end) {
+            break;
+        }
+
+        // 睡到下一条记录的计划时间，最多100毫秒
+        int wait_ms = 100;
+        if (cursor_ < trace_.size()) {
+            auto next = stats_.start_time + std::chrono::nanoseconds(
+                static_cast<long long>(trace_.record(cursor_).time_ns / config_.replay_speed));
+            auto until_next = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+            wait_ms = static_cast<int>(std::max<long long>(std::min<long long>(until_next, 100), 0));
+        }
+        int num_events = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), wait_ms);
+        if (num_events == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Epoll wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < num_events; ++i) {
+            int fd = events[i].data.fd;
+            if (static_cast<size_t>(fd) >= connections_.size() || connections_[fd].fd != fd) {
+                continue;
+            }
+            Connection& connection = connections_[fd];
+            if ((events[i].events & EPOLLIN) && !handleReceive(connection)) {
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !flush(connection)) {
+                stats_.disconnects++;
+                closeConnection(connection);
+            }
+        }
+    }
+    stats_.end_time = std::chrono::steady_clock::now();
+    running_ = false;
+}
+
+void ReplayClient::stopTest() {
+    running_ = false;
+}
+
+void ReplayClient::sendDue(std::chrono::steady_clock::time_point now) {
+    // 开环: 落后于计划时照常补发，延迟从计划时间算起
+    size_t slots = static_cast<size_t>(config_.concurrent_connections);
+    std::vector<int> touched;
+    while (cursor_ < trace_.size()) {
+        const TraceRecord& record = trace_.record(cursor_);
+        auto intended = stats_.start_time + std::chrono::nanoseconds(
+            static_cast<long long>(record.time_ns / config_.replay_speed));
+        if (intended > now) {
+            break;
+        }
+        size_t replay_connection = record.connection % slots;
+        if (static_cast<int>(replay_connection % config_.num_threads) == thread_id_) {
+            int fd = slots_[replay_connection / config_.num_threads];
+            if (fd == -1) {
+                stats_.skipped++;
+            } else {
+                Connection& connection = connections_[fd];
+                const char* payload = trace_.payload(cursor_);
+                if (payload == nullptr) {
+                    payload = filler_.data();
+                }
+                size_t offset = connection.output.size();
+                connection.output.resize(offset + kFrameHeaderSize + record.length);
+                encodeFrameHeader(connection.output.data() + offset, record.length);
+                memcpy(connection.output.data() + offset + kFrameHeaderSize, payload, record.length);
+                connection.in_flight.push_back(intended);
+                if (now - intended > std::chrono::milliseconds(1)) {
+                    stats_.late++;
+                }
+                stats_.sent++;
+                stats_.bytes_sent += kFrameHeaderSize + record.length;
+                touched.push_back(fd);
+            }
+        }
+        cursor_++;
+    }
+    for (int fd : touched) {
+        Connection& connection = connections_[fd];
+        if (connection.fd != -1 && !flush(connection)) {
+            stats_.disconnects++;
+            closeConnection(connection);
+        }
+    }
+}
+
+bool ReplayClient::flush(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.output_offset,
+                            connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            return false;
+        }
+        connection.output_offset += sent;
+    }
+    connection.output.clear();
+    connection.output_offset = 0;
+    return true;
+}
+
+bool ReplayClient::handleReceive(Connection& connection) {
+    while (true) {
+        ssize_t received = recv(connection.fd, receive_scratch_.data(), receive_scratch_.size(), 0);
+        if (received > 0) {
+            connection.pending.insert(connection.pending.end(), receive_scratch_.data(),
+                                      receive_scratch_.data() + received);
+            size_t consumed = parseResponses(connection, connection.pending.data(), connection.pending.size());
+            if (connection.fd == -1) {
+                return false;
+            }
+            connection.pending.erase(connection.pending.begin(), connection.pending.begin() + consumed);
+        } else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            stats_.disconnects++;
+            closeConnection(connection);
+            return false;
+        } else if (errno != EINTR) {
+            return true;
+        }
+    }
+}
+
+size_t ReplayClient::parseResponses(Connection& connection, const char* data, size_t length) {
+    auto now = std::chrono::steady_clock::now();
+    size_t offset = 0;
+    while (length - offset >= kFrameHeaderSize) {
+        uint32_t msg_length = decodeFrameHeader(data + offset);
+        if (isErrorFrameHeader(msg_length) || connection.in_flight.empty()) {
+            if (isErrorFrameHeader(msg_length) && length - offset >= kFrameHeaderSize + sizeof(uint32_t)) {
+                uint32_t code = decodeFrameHeader(data + offset + kFrameHeaderSize);
+                std::cerr << "[Thread " << thread_id_ << "] Server error: " << frameErrorName(code) << std::endl;
+            }
+            stats_.errors++;
+            closeConnection(connection);
+            return length;
+        }
+        size_t frame_size = kFrameHeaderSize + msg_length;
+        if (length - offset < frame_size) {
+            break;
+        }
+        stats_.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - connection.in_flight.front()).count());
+        connection.in_flight.pop_front();
+        stats_.received++;
+        offset += frame_size;
+    }
+    return offset;
+}
+
+void ReplayClient::closeConnection(Connection& connection) {
+    if (connection.fd == -1) {
+        return;
+    }
+    for (int& fd : slots_) {
+        if (fd == connection.fd) {
+            fd = -1;
+        }
+    }
+    close(connection.fd);
+    connection.fd = -1;
+    connection.output.clear();
+    connection.output_offset = 0;
+    connection.pending.clear();
+    connection.in_flight.clear();
+}
+
+size_t ReplayClient::inFlight() const {
+    size_t total = 0;
+    for (int fd : slots_) {
+        if (fd != -1) {
+            total += connections_[fd].in_flight.size();
+        }
+    }
+    return total;
+}
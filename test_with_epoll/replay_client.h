@@ -0,0 +1,104 @@
+#ifndef REPLAY_CLIENT_H
+#define REPLAY_CLIENT_H
+
+#include "pressure_client.h"
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include "../include/latency_histogram.h"
+#include "../include/traffic_trace.h"
+
+// 只读映射的录制文件，加载时按时间建立记录索引，所有回放线程共用
+class ReplayTrace {
+public:
+    ReplayTrace();
+    ~ReplayTrace();
+
+    bool load(const std::string& path);
+    size_t size() const { return index_.size(); }
+    const TraceRecord& record(size_t i) const {
+        return *reinterpret_cast<const TraceRecord*>(data_ + index_[i]);
+    }
+    // 录制了载荷时返回记录后的载荷，否则返回nullptr
+    const char* payload(size_t i) const {
+        return (header_.flags & kTraceHasPayloads) ? data_ + index_[i] + sizeof(TraceRecord) : nullptr;
+    }
+    bool hasPayloads() const { return (header_.flags & kTraceHasPayloads) != 0; }
+    uint64_t connections() const { return header_.connections; }
+    uint64_t durationNs() const { return index_.empty() ? 0 : record(index_.size() - 1).time_ns; }
+    uint32_t maxLength() const { return max_length_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    TraceFileHeader header_;
+    std::vector<uint64_t> index_;       // 记录在文件中的偏移，按时间排序
+    uint32_t max_length_;
+};
+
+// 回放测试统计
+struct ReplayStats {
+    long connections = 0;               // 建立成功的连接数
+    long connect_failures = 0;
+    long sent = 0;                      // 发出的报文数
+    long received = 0;                  // 收到的响应数
+    long bytes_sent = 0;
+    long late = 0;                      // 实际发送比计划晚1毫秒以上的报文数
+    long skipped = 0;                   // 所属连接已断开而未发送的报文数
+    long errors = 0;                    // 服务器回复的错误报文
+    long disconnects = 0;               // 连接被服务器断开
+    LatencyHistogram latency;           // 计划发送时间到收到响应
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point end_time;
+
+    void merge(const ReplayStats& other);
+    void reset();
+};
+
+// 单线程回放: 按录制的时间间隔(除以speed)开环发送报文，录制中的连接c映射到第c % N个回放连接，
+// 回放连接j由线程j % T负责；每个请求对应一个按序返回的响应(回射和键值模式)
+class ReplayClient {
+public:
+    ReplayClient(const ClientConfig& config, int thread_id, const ReplayTrace& trace);
+    ~ReplayClient();
+
+    bool initialize();
+    void runTest();
+    void stopTest();
+    const ReplayStats& stats() const { return stats_; }
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::vector<char> output;           // 待发送的报文
+        size_t output_offset = 0;
+        std::vector<char> pending;          // 上次未解析完的响应
+        std::deque<std::chrono::steady_clock::time_point> in_flight;  // 在途请求的计划发送时间
+    };
+
+    void sendDue(std::chrono::steady_clock::time_point now);    // 发送所有到期的记录
+    bool flush(Connection& connection);         // 返回false表示发送出错
+    bool handleReceive(Connection& connection); // 返回false表示连接已断开
+    size_t parseResponses(Connection& connection, const char* data, size_t length);
+    void closeConnection(Connection& connection);
+    size_t inFlight() const;
+
+private:
+    ClientConfig config_;
+    int thread_id_;
+    const ReplayTrace& trace_;
+    int epoll_fd_;
+    std::atomic<bool> running_;
+    ReplayStats stats_;
+    std::vector<int> slots_;                    // 本线程的回放连接 -> fd，-1表示未连接或已断开
+    std::vector<Connection> connections_;       // 按fd下标索引
+    std::vector<char> receive_scratch_;         // 接收缓冲区，所有连接共用
+    std::string filler_;                        // 未录制载荷时的填充数据
+    size_t cursor_;                             // 下一条待检查的记录
+    std::mt19937 rng_;
+};
+
+#endif // REPLAY_CLIENT_H
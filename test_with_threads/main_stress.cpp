@@ -1,4 +1,5 @@
 #include "stress_client.h"
+#include "../include/size_distribution.h"
 #include <iostream>
 #include <csignal>
 #include <atomic>
@@ -19,10 +20,15 @@ void printUsage(const char* program_name) {
     std::cout << "  -cont         Continuous mode until stopped" << std::endl;
     std::cout << "  -min <size>   Minimum message size (default: 10)" << std::endl;
     std::cout << "  -max <size>   Maximum message size (default: 1024)" << std::endl;
+    std::cout << "  --size-dist <spec>  Message size distribution, overrides -min/-max:" << std::endl;
+    std::cout << "                uniform:MIN,MAX  lognormal:MEDIAN,SIGMA[,MAX]  bimodal:SMALL,LARGE,P" << std::endl;
+    std::cout << "                zipf:MIN,MAX[,THETA]  file:PATH (lines of \"size weight\")" << std::endl;
     std::cout << "  -t <ms>       Think time between requests in milliseconds (default: 0)" << std::endl;
     std::cout << "  -ip <addr>    Server IP address (default: 127.0.0.1)" << std::endl;
     std::cout << "  -p <port>     Server port (default: 8080)" << std::endl;
     std::cout << "  -s <seconds>  Statistics report interval in seconds (default: 5)" << std::endl;
+    std::cout << "  --rate <rps>  Open-loop total request rate, latency measured against schedule" << std::endl;
+    std::cout << "  --poisson     Poisson arrivals in open-loop mode (default: uniform)" << std::endl;
     std::cout << "  -v            Verbose output" << std::endl;
     std::cout << "  -h, --help    Show this help message" << std::endl;
     std::cout << std::endl;
@@ -39,6 +45,9 @@ int main(int argc, char* argv[]) {
     
     // 默认配置
     StressConfig config;
+    SizeDistribution sizes;     // 只解析一次，所有工作线程共用分位数表
+    int min_size = 0;
+    int max_size = 0;
     
     // 命令行参数解析
     for (int i = 1; i < argc; ++i) {
@@ -54,6 +63,12 @@ int main(int argc, char* argv[]) {
             config.continuous_mode = true;
         } else if (arg == "-m" && i + 1 < argc) {
             config.message_size = std::stoi(argv[++i]);
+        } else if (arg == "-min" && i + 1 < argc) {
+            min_size = std::stoi(argv[++i]);
+        } else if (arg == "-max" && i + 1 < argc) {
+            max_size = std::stoi(argv[++i]);
+        } else if (arg == "--size-dist" && i + 1 < argc) {
+            config.size_distribution = argv[++i];
         } else if (arg == "-t" && i + 1 < argc) {
             config.think_time_ms = std::stoi(argv[++i]);
         } else if (arg == "-ip" && i + 1 < argc) {
@@ -62,6 +77,10 @@ int main(int argc, char* argv[]) {
             config.server_port = std::stoi(argv[++i]);
         } else if (arg == "-s" && i + 1 < argc) {
             config.stats_interval = std::stoi(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            config.rate = std::stod(argv[++i]);
+        } else if (arg == "--poisson") {
+            config.poisson_arrivals = true;
         } else if (arg == "-v") {
             config.verbose = true;
         } else if (arg == "-h" || arg == "--help") {
@@ -74,6 +93,18 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // -min/-max等价于均匀分布，未给出的一端取帮助中的默认值
+    if (config.size_distribution.empty() && (min_size > 0 || max_size > 0)) {
+        config.size_distribution = "uniform:" + std::to_string(min_size > 0 ? min_size : 10) + ","
+                                 + std::to_string(max_size > 0 ? max_size : 1024);
+    }
+    if (!config.size_distribution.empty()) {
+        if (!sizes.parse(config.size_distribution)) {
+            return 1;
+        }
+        config.sizes = &sizes;
+    }
+    
     std::cout << "Echo Server Stress Test Generator" << std::endl;
     std::cout << "==================================" << std::endl;
     
@@ -1,4 +1,5 @@
 #include "stress_client.h"
+#include "../include/frame.h"
 #include <iostream>
 #include <chrono>
 #include <sstream>
@@ -6,6 +7,9 @@
 
 StressClient::StressClient(const StressConfig& config) 
     : config_(config), gen_(rd_()) {
+    if (config_.sizes == nullptr) {
+        config_.size_distribution.clear();
+    }
 }
 
 StressClient::~StressClient() {
@@ -33,13 +37,30 @@ void StressClient::run() {
         std::cout << "Requests per client: " << config_.requests_per_client << std::endl;
     }
     std::cout << "Server: " << config_.server_ip << ":" << config_.server_port << std::endl;
-    if (config_.think_time_ms > 0) {
+    if (!config_.size_distribution.empty()) {
+        std::cout << "Message size: " << config_.size_distribution << " (mean "
+                  << static_cast<int>(config_.sizes->meanSize()) << " bytes)" << std::endl;
+    }
+    if (config_.rate > 0) {
+        std::cout << "Open-loop rate: " << config_.rate << " req/s ("
+                  << (config_.poisson_arrivals ? "poisson" : "uniform") << ")" << std::endl;
+    } else if (config_.think_time_ms > 0) {
         std::cout << "Think time: " << config_.think_time_ms << " ms" << std::endl;
     }
     std::cout << "==================================" << std::endl;
     
+    // 每个工作线程独立计数和记录延迟，由报告线程取样，结束后汇总
+    worker_stats_.clear();
+    for (int i = 0; i < config_.num_clients; ++i) {
+        worker_stats_.emplace_back(new WorkerStats());
+    }
+    last_report_time_ = test_start_time_;
+    last_report_stats_.reset();
+    
     // 启动统计报告线程
-    // reporter_thread_ = std::thread(&StressClient::statsReporter, this);
+    if (config_.stats_interval > 0) {
+        reporter_thread_ = std::thread(&StressClient::statsReporter, this);
+    }
     
     // 创建工作线程
     for (int i = 0; i < config_.num_clients; ++i) {
@@ -55,17 +76,27 @@ void StressClient::run() {
     
     // 停止统计报告线程
     running_ = false;
-    // if (reporter_thread_.joinable()) {
-    //     reporter_thread_.join();
-    // }
+    if (reporter_thread_.joinable()) {
+        reporter_thread_.join();
+    }
+    
+    // 汇总各线程计数
+    stats_.reset();
+    for (const auto& worker : worker_stats_) {
+        stats_.total_requests += worker->requests;
+        stats_.total_responses += worker->responses;
+        stats_.total_bytes_sent += worker->bytes_sent;
+        stats_.total_bytes_received += worker->bytes_received;
+    }
     
     auto end_time = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - test_start_time_);
+    double total_seconds = duration.count() / 1000.0;
     
     std::cout << "\n=== Stress Test Completed ===" << std::endl;
     printStats();
+    printLatency(total_seconds);
     
-    double total_seconds = duration.count() / 1000.0;
     double requests_per_second = stats_.total_requests / total_seconds;
     double mb_sent = stats_.total_bytes_sent / (1024.0 * 1024.0);
     double mb_received = stats_.total_bytes_received / (1024.0 * 1024.0);
@@ -101,30 +132,61 @@ void StressClient::workerThread(int thread_id) {
         std::cout << client_name << " started" << std::endl;
     }
     
-    // 创建客户端实例并连接
+    // 创建客户端实例并连接，逐条打印请求会让所有线程争用输出锁，仅在verbose时开启
     Client client(config_.server_ip, config_.server_port);
+    client.setVerbose(config_.verbose);
+    WorkerStats& worker = *worker_stats_[thread_id];
     
     if (!client.connectToServer()) {
         std::cerr << client_name << " failed to connect to server" << std::endl;
-        stats_.total_requests++;
+        WorkerStats::add(worker.requests, 1);
         return;
     }
     
     int request_count = 0;
     
+    // 开环模式: 每个线程承担 rate/num_clients，相位错开使整体发送间隔均匀
+    bool open_loop = config_.rate > 0;
+    double thread_rate = config_.rate / config_.num_clients;
+    std::mt19937_64 rng(std::random_device{}() + thread_id);
+    std::exponential_distribution<double> poisson_interval(open_loop ? thread_rate : 1.0);
+    double schedule_offset_ns = open_loop ? 1e9 / config_.rate * thread_id : 0;
+    FastRng size_rng(rng());
+    
     // 持续运行或固定请求数运行
     while (running_ && shouldContinue()) {
+        // 计划发送时间，闭环模式下即当前时间
+        auto intended_time = std::chrono::steady_clock::now();
+        if (open_loop) {
+            intended_time = test_start_time_ + std::chrono::nanoseconds(
+                static_cast<long long>(schedule_offset_ns));
+            // 落后于计划时立即发送，延迟仍从计划时间算起，避免协同遗漏
+            std::this_thread::sleep_until(intended_time);
+            schedule_offset_ns += config_.poisson_arrivals ?
+                poisson_interval(rng) * 1e9 : 1e9 / thread_rate;
+        }
+        
         std::string message;
         
         if (config_.random_messages) {
-            message = generateMessage();
+            message = generateMessage(config_.sizes ? config_.sizes->sample(size_rng.next()) : config_.message_size);
         } else {
             message = client_name + " - Message " + std::to_string(request_count);
         }
         
         int sent_bytes = client.sendRequest(message);
         int received_bytes = client.receiveResponse();
-        updateStats(sent_bytes, received_bytes);
+        updateStats(worker, sent_bytes, received_bytes);
+        if (received_bytes > 0) {
+            int64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - intended_time).count();
+            std::lock_guard<std::mutex> lock(worker.latency_mutex);
+            worker.interval_latency.record(latency);
+            worker.total_latency.record(latency);
+            if (!config_.size_distribution.empty()) {
+                worker.size_buckets.record(message.size(), latency);
+            }
+        }
         
         request_count++;
         
@@ -133,8 +195,8 @@ void StressClient::workerThread(int thread_id) {
             break;
         }
         
-        // 思考时间
-        if (config_.think_time_ms > 0) {
+        // 思考时间(开环模式由调度控制节奏)
+        if (!open_loop && config_.think_time_ms > 0) {
             std::this_thread::sleep_for(std::chrono::milliseconds(config_.think_time_ms));
         }
     }
@@ -148,18 +210,15 @@ void StressClient::workerThread(int thread_id) {
 }
 
 void StressClient::statsReporter() {
-    auto last_report_time = std::chrono::steady_clock::now();
+    auto next_report_time = test_start_time_ + std::chrono::seconds(config_.stats_interval);
     
     while (running_) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        
-        auto current_time = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-            current_time - last_report_time).count();
+        // 短间隔检查退出标志，避免测试结束后还要等满一个报告周期
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
         
-        if (elapsed >= config_.stats_interval) {
+        if (std::chrono::steady_clock::now() >= next_report_time) {
             printCurrentStats();
-            last_report_time = current_time;
+            next_report_time += std::chrono::seconds(config_.stats_interval);
         }
     }
 }
@@ -179,34 +238,20 @@ bool StressClient::shouldContinue() {
     return true; // 无限运行
 }
 
-std::string StressClient::generateMessage() {
-    static const char alphanum[] = 
-        "0123456789"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "abcdefghijklmnopqrstuvwxyz";
-    
-    std::string message;
-    message.reserve(config_.message_size);
-    
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, sizeof(alphanum) - 2);
-    
-    for (int i = 0; i < config_.message_size; ++i) {
-        message += alphanum[dis(gen)];
-    }
-    
-    return message;
+std::string StressClient::generateMessage(int size) {
+    // 每个工作线程独立的随机数引擎，避免多线程共享同一引擎
+    thread_local std::mt19937 gen(std::random_device{}());
+    return generatePayload(gen, size);
 }
 
-void StressClient::updateStats(long sent_bytes, long received_bytes) {
+void StressClient::updateStats(WorkerStats& worker, long sent_bytes, long received_bytes) {
     if (sent_bytes > 0) {
-        stats_.total_bytes_sent += sent_bytes;
-        stats_.total_requests++;
+        WorkerStats::add(worker.bytes_sent, sent_bytes);
+        WorkerStats::add(worker.requests, 1);
     }
     if (received_bytes > 0) {
-        stats_.total_bytes_received += received_bytes;
-        stats_.total_responses++;
+        WorkerStats::add(worker.bytes_received, received_bytes);
+        WorkerStats::add(worker.responses, 1);
     }
 }
 
@@ -218,16 +263,68 @@ void StressClient::printStats() const {
     std::cout << "Total bytes received: " << stats_.total_bytes_received << std::endl;
 }
 
+void StressClient::printLatency(double duration_sec) const {
+    LatencyHistogram merged;
+    SizeBucketStats size_buckets;
+    for (const auto& worker : worker_stats_) {
+        merged.merge(worker->total_latency);
+        size_buckets.merge(worker->size_buckets);
+    }
+    if (merged.count() == 0) {
+        return;
+    }
+    std::cout << "Latency (us): "
+              << "p50=" << merged.percentile(50) / 1000.0
+              << " p90=" << merged.percentile(90) / 1000.0
+              << " p99=" << merged.percentile(99) / 1000.0
+              << " p99.9=" << merged.percentile(99.9) / 1000.0
+              << " max=" << merged.max() / 1000.0 << std::endl;
+    if (!config_.size_distribution.empty()) {
+        size_buckets.print(std::cout, duration_sec);
+    }
+}
+
 void StressClient::printCurrentStats() {
     auto current_time = std::chrono::steady_clock::now();
+    
+    // 取样: 计数器直接读取，区间延迟取出后清零
+    StressStats current;
+    LatencyHistogram interval_latency;
+    for (const auto& worker : worker_stats_) {
+        current.total_requests += worker->requests.load(std::memory_order_relaxed);
+        current.total_responses += worker->responses.load(std::memory_order_relaxed);
+        current.total_bytes_sent += worker->bytes_sent.load(std::memory_order_relaxed);
+        current.total_bytes_received += worker->bytes_received.load(std::memory_order_relaxed);
+        
+        std::lock_guard<std::mutex> lock(worker->latency_mutex);
+        interval_latency.merge(worker->interval_latency);
+        worker->interval_latency.reset();
+    }
+    
+    double interval = std::chrono::duration_cast<std::chrono::milliseconds>(
+        current_time - last_report_time_).count() / 1000.0;
     auto total_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
         current_time - test_start_time_).count();
+    if (interval <= 0) {
+        return;
+    }
     
-    double requests_per_second = total_elapsed > 0 ? 
-        static_cast<double>(stats_.total_requests) / total_elapsed : 0;
+    double requests_per_second = (current.total_requests - last_report_stats_.total_requests) / interval;
+    double responses_per_second = (current.total_responses - last_report_stats_.total_responses) / interval;
+    double mb_per_second = (current.total_bytes_received - last_report_stats_.total_bytes_received)
+                           / (1024.0 * 1024.0) / interval;
     
-    std::cout << "[Progress] Time: " << total_elapsed << "s, " 
-              << "Requests: " << stats_.total_requests << ", "
+    std::cout << "[Interval] Time: " << total_elapsed << "s, "
+              << "Requests: " << current.total_requests << ", "
               << "RPS: " << std::fixed << std::setprecision(2) << requests_per_second << ", "
+              << "Responses/s: " << responses_per_second << ", "
+              << "MB/s: " << mb_per_second << ", "
+              << "Latency(us) p50=" << interval_latency.percentile(50) / 1000.0
+              << " p99=" << interval_latency.percentile(99) / 1000.0
+              << " p99.9=" << interval_latency.percentile(99.9) / 1000.0
+              << " max=" << interval_latency.max() / 1000.0
               << std::endl;
-}
\ No newline at end of file
+    
+    last_report_time_ = current_time;
+    last_report_stats_ = current;
+}
@@ -2,6 +2,8 @@
 #define STRESS_CLIENT_H
 
 #include "../include/client.h"
+#include "../include/latency_histogram.h"
+#include "../include/size_distribution.h"
 #include <atomic>
 #include <thread>
 #include <vector>
@@ -9,26 +11,49 @@
 #include <chrono>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
 
-// 压力测试统计
+// 压力测试统计(各工作线程汇总结果)
 struct StressStats {
-    std::atomic<long> total_requests{0};
-    std::atomic<long> total_responses{0};
-    std::atomic<long> total_bytes_sent{0};
-    std::atomic<long> total_bytes_received{0};
+    long total_requests = 0;
+    long total_responses = 0;
+    long total_bytes_sent = 0;
+    long total_bytes_received = 0;
 
     void reset() {
         total_requests = 0;
+        total_responses = 0;
         total_bytes_sent = 0;
         total_bytes_received = 0;
     }
 };
 
+// 单个工作线程的统计，按缓存行对齐避免线程间伪共享
+// 计数器只有所属线程写入，报告线程只读；延迟直方图由互斥锁保护，只在取样时与报告线程竞争
+struct alignas(64) WorkerStats {
+    std::atomic<long> requests{0};
+    std::atomic<long> responses{0};
+    std::atomic<long> bytes_sent{0};
+    std::atomic<long> bytes_received{0};
+
+    std::mutex latency_mutex;
+    LatencyHistogram interval_latency;      // 当前报告区间的延迟
+    LatencyHistogram total_latency;         // 整个测试的延迟
+    SizeBucketStats size_buckets;           // 按报文大小分桶的延迟，设置了大小分布时输出
+
+    // 单写者累加，不需要原子读改写指令
+    static void add(std::atomic<long>& counter, long value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+};
+
 // 压力测试配置
 struct StressConfig {
     int num_clients = 10;           // 并发客户端数量
     int requests_per_client = 100;  // 每个客户端发送的请求数
     int message_size = 10;          // 消息大小
+    std::string size_distribution;  // 报文大小分布描述串(见size_distribution.h)，为空时固定为message_size
+    const SizeDistribution* sizes = nullptr;    // 按size_distribution建好的分布，main解析一次后各线程只读共享
     int connect_timeout = 5;        // 连接超时(秒)
     int request_timeout = 3;        // 请求超时(秒)
     std::string server_ip = "127.0.0.1";
@@ -39,6 +64,8 @@ struct StressConfig {
     int duration_seconds = 0;       // 测试持续时间(秒)，0表示无限
     int think_time_ms = 0;          // 思考时间(毫秒)
     int stats_interval = 5;         // 统计报告间隔(秒)
+    double rate = 0;                // 开环模式总速率(请求/秒)，0表示闭环
+    bool poisson_arrivals = false;  // 开环模式使用泊松到达，否则均匀间隔
 };
 
 class StressClient {
@@ -53,10 +80,11 @@ public:
 private:
     void workerThread(int thread_id);                   // 工作线程
     void statsReporter();                               // 统计报告线程
-    std::string generateMessage();                      // 生成消息
-    void updateStats(long sent_bytes, long received_bytes); // 更新统计
+    std::string generateMessage(int size);              // 生成指定大小的消息
+    void updateStats(WorkerStats& worker, long sent_bytes, long received_bytes); // 更新统计
     bool shouldContinue();                              // 检查是否继续运行
-    void printCurrentStats();                           // 打印当前统计
+    void printCurrentStats();                           // 打印当前区间的速率和延迟
+    void printLatency(double duration_sec) const;       // 打印延迟分布
     
 private:
     StressConfig config_;
@@ -64,6 +92,11 @@ private:
     std::atomic<bool> running_{false};
     std::vector<std::thread> workers_;
     std::thread reporter_thread_;
+    std::vector<std::unique_ptr<WorkerStats>> worker_stats_;   // 每个工作线程一份统计
+    
+    // 报告线程状态: 上一次取样的累计值
+    std::chrono::steady_clock::time_point last_report_time_;
+    StressStats last_report_stats_;
     std::random_device rd_;
     std::mt19937 gen_;
     std::chrono::steady_clock::time_point test_start_time_;